@@ -0,0 +1,835 @@
+#include "leveldb/backup.h"
+
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "db/filename.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "port/port.h"
+#include "util/crc32c.h"
+#include "util/mutexlock.h"
+#include "util/rate_limiter.h"
+
+namespace leveldb{
+
+	BackupOptions::BackupOptions()
+		:env(Env::Default()),
+		info_log(NULL),
+		max_background_copies(4),
+		rate_limit_bytes_per_sec(0)
+	{
+
+	}
+
+	BackupEngine::~BackupEngine()
+	{
+
+	}
+
+	namespace {
+
+		//A file of a backup, named relative to the backup directory.
+		struct BackupFile{
+			std::string name;
+			uint64_t size;
+			uint32_t crc;
+		};
+
+		struct BackupMeta{
+			uint64_t timestamp;
+			std::vector<BackupFile> files;
+		};
+
+		//Copy "src" to "target", checksumming the data on the way. The copy
+		//is written under a temporary name and renamed into place, so a
+		//target that exists is always complete. With an empty "target" the
+		//source is only read and checksummed.
+		struct CopyJob{
+			std::string src;
+			std::string target;
+			bool verify;			//Fail unless the data matches the expected values
+			uint64_t expected_size;
+			uint32_t expected_crc;
+			uint64_t size;			//Set by the copy
+			uint32_t crc;			//Set by the copy
+			Status status;
+
+			CopyJob(const std::string& s, const std::string& t)
+				:src(s), target(t), verify(false), expected_size(0), expected_crc(0),
+				size(0), crc(0){ }
+		};
+
+		static Status CopyFile(Env* env, RateLimiter* limiter, CopyJob* job)
+		{
+			const bool checksum_only = job->target.empty();
+			const std::string tmp = job->target + ".tmp";
+			SequentialFile* in;
+			Status s = env->NewSequentialFile(job->src, &in);
+			if (!s.ok())
+			{
+				return s;
+			}
+			WritableFile* out = NULL;
+			if (!checksum_only)
+			{
+				s = env->NewWritableFile(tmp, &out);
+				if (!s.ok())
+				{
+					delete in;
+					return s;
+				}
+			}
+
+			static const int kBufferSize = 64 << 10;
+			char* scratch = new char[kBufferSize];
+			job->size = 0;
+			job->crc = 0;
+			while (s.ok())
+			{
+				Slice fragment;
+				s = in->Read(kBufferSize, &fragment, scratch);
+				if (!s.ok() || fragment.empty())
+				{
+					break;
+				}
+				if (limiter != NULL)
+				{
+					limiter->Request(fragment.size());
+				}
+				job->crc = crc32c::Extend(job->crc, fragment.data(), fragment.size());
+				job->size += fragment.size();
+				if (!checksum_only)
+				{
+					s = out->Append(fragment);
+				}
+			}
+			delete[] scratch;
+			delete in;
+			if (checksum_only)
+			{
+				return s;
+			}
+
+			if (s.ok())
+			{
+				s = out->Sync();
+			}
+			if (s.ok())
+			{
+				s = out->Close();
+			}
+			delete out;
+			if (s.ok() && job->verify &&
+				(job->size != job->expected_size || job->crc != job->expected_crc))
+			{
+				s = Status::Corruption(job->src, "does not match its recorded checksum");
+			}
+			if (s.ok())
+			{
+				s = env->RenameFile(tmp, job->target);
+			}
+			if (!s.ok())
+			{
+				env->DeleteFile(tmp);
+			}
+			return s;
+		}
+
+		//Runs a list of copies on several threads. A failed copy stops the
+		//copies that have not started yet.
+		class CopyRunner{
+		public:
+			CopyRunner(Env* env, RateLimiter* limiter, std::vector<CopyJob>* jobs)
+				:env_(env),
+				limiter_(limiter),
+				jobs_(jobs),
+				cv_(&mu_),
+				next_job_(0),
+				running_(0),
+				failed_(false){ }
+
+			//Returns the status of the first copy that failed.
+			Status Run(int threads)
+			{
+				if (threads > static_cast<int>(jobs_->size()))
+				{
+					threads = static_cast<int>(jobs_->size());
+				}
+				if (threads < 1)
+				{
+					threads = 1;
+				}
+				mu_.Lock();
+				running_ = threads;
+				mu_.Unlock();
+				for (int i = 0; i < threads; i++)
+				{
+					env_->StartThread(&CopyRunner::BGWork, this);
+				}
+
+				MutexLock l(&mu_);
+				while (running_ > 0)
+				{
+					cv_.Wait();
+				}
+				for (size_t i = 0; i < next_job_; i++)
+				{
+					if (!(*jobs_)[i].status.ok())
+					{
+						return (*jobs_)[i].status;
+					}
+				}
+				return Status::OK();
+			}
+
+		private:
+			static void BGWork(void* arg)
+			{
+				reinterpret_cast<CopyRunner*>(arg)->Work();
+			}
+
+			void Work()
+			{
+				mu_.Lock();
+				while (!failed_ && next_job_ < jobs_->size())
+				{
+					CopyJob* job = &(*jobs_)[next_job_++];
+					mu_.Unlock();
+					job->status = CopyFile(env_, limiter_, job);
+					mu_.Lock();
+					if (!job->status.ok())
+					{
+						failed_ = true;
+					}
+				}
+				running_--;
+				cv_.SignalAll();
+				mu_.Unlock();
+			}
+
+			Env* const env_;
+			RateLimiter* const limiter_;
+			std::vector<CopyJob>* const jobs_;
+			port::Mutex mu_;
+			port::CondVar cv_;
+			size_t next_job_;
+			int running_;
+			bool failed_;
+		};
+
+		static bool ParseNumber(const std::string& s, uint64_t* value)
+		{
+			if (s.empty())
+			{
+				return false;
+			}
+			char* end;
+			*value = strtoull(s.c_str(), &end, 10);
+			return *end == '\0';
+		}
+
+		static void SplitString(const std::string& s, char delim,
+			std::vector<std::string>* parts)
+		{
+			parts->clear();
+			size_t start = 0;
+			while (start <= s.size())
+			{
+				size_t pos = s.find(delim, start);
+				if (pos == std::string::npos)
+				{
+					pos = s.size();
+				}
+				parts->push_back(s.substr(start, pos - start));
+				start = pos + 1;
+			}
+		}
+
+		static std::string BaseName(const std::string& name)
+		{
+			const size_t pos = name.rfind('/');
+			return pos == std::string::npos ? name : name.substr(pos + 1);
+		}
+
+		//Shared table files are named "shared/<number>_<crc32c>_<size>.sst".
+		//The file number alone does not identify a table: a database
+		//restored from an older backup hands out again the numbers of
+		//tables that newer backups hold.
+		static std::string SharedTableName(uint64_t number, uint32_t crc, uint64_t size)
+		{
+			char buf[100];
+			snprintf(buf, sizeof(buf), "shared/%06llu_%u_%llu.sst",
+				static_cast<unsigned long long>(number), crc,
+				static_cast<unsigned long long>(size));
+			return buf;
+		}
+
+		//Return the name the backup file "name" takes in a restored
+		//database. Shared tables drop the checksum and size from their name.
+		static std::string RestoredName(const std::string& name)
+		{
+			const std::string base = BaseName(name);
+			const size_t pos = base.find('_');
+			uint64_t number;
+			if (name.compare(0, 7, "shared/") == 0 && pos != std::string::npos &&
+				ParseNumber(base.substr(0, pos), &number) && number > 0)
+			{
+				return BaseName(TableFileName("", number));
+			}
+			return base;
+		}
+
+		//Metadata files are text:
+		//	timestamp <seconds>
+		//	file <name> <size> <crc32c>	(one line per file)
+		//	checksum <crc32c of all preceding lines>
+		static std::string EncodeMeta(const BackupMeta& meta)
+		{
+			std::string result;
+			char buf[100];
+			snprintf(buf, sizeof(buf), "timestamp %llu\n",
+				static_cast<unsigned long long>(meta.timestamp));
+			result.append(buf);
+			for (size_t i = 0; i < meta.files.size(); i++)
+			{
+				const BackupFile& f = meta.files[i];
+				snprintf(buf, sizeof(buf), " %llu %u\n",
+					static_cast<unsigned long long>(f.size), f.crc);
+				result.append("file ");
+				result.append(f.name);
+				result.append(buf);
+			}
+			snprintf(buf, sizeof(buf), "checksum %u\n",
+				crc32c::Value(result.data(), result.size()));
+			result.append(buf);
+			return result;
+		}
+
+		static Status DecodeMeta(const std::string& fname, const std::string& data,
+			BackupMeta* meta)
+		{
+			std::vector<std::string> lines;
+			SplitString(data, '\n', &lines);
+			//The data ends with a newline, which leaves an empty last part.
+			if (lines.size() < 3 || !lines.back().empty())
+			{
+				return Status::Corruption(fname, "truncated backup metadata");
+			}
+			lines.pop_back();
+
+			std::vector<std::string> fields;
+			uint64_t crc;
+			SplitString(lines.back(), ' ', &fields);
+			const size_t body_size = data.size() - lines.back().size() - 1;
+			if (fields.size() != 2 || fields[0] != "checksum" ||
+				!ParseNumber(fields[1], &crc) ||
+				crc != crc32c::Value(data.data(), body_size))
+			{
+				return Status::Corruption(fname, "backup metadata checksum mismatch");
+			}
+			lines.pop_back();
+
+			SplitString(lines[0], ' ', &fields);
+			if (fields.size() != 2 || fields[0] != "timestamp" ||
+				!ParseNumber(fields[1], &meta->timestamp))
+			{
+				return Status::Corruption(fname, "bad backup timestamp");
+			}
+			meta->files.clear();
+			for (size_t i = 1; i < lines.size(); i++)
+			{
+				SplitString(lines[i], ' ', &fields);
+				BackupFile f;
+				if (fields.size() != 4 || fields[0] != "file" ||
+					!ParseNumber(fields[2], &f.size) ||
+					!ParseNumber(fields[3], &crc))
+				{
+					return Status::Corruption(fname, "bad backup file entry");
+				}
+				f.name = fields[1];
+				f.crc = static_cast<uint32_t>(crc);
+				meta->files.push_back(f);
+			}
+			return Status::OK();
+		}
+
+		class BackupEngineImpl :public BackupEngine{
+		public:
+			explicit BackupEngineImpl(const BackupOptions& options)
+				:options_(options),
+				env_(options.env),
+				limiter_(options.rate_limit_bytes_per_sec > 0 ?
+					new RateLimiter(options.env, options.rate_limit_bytes_per_sec) : NULL),
+				has_damaged_backups_(false){ }
+
+			virtual ~BackupEngineImpl(){ delete limiter_; }
+
+			//Create the backup directory if needed and load its metadata.
+			Status Load();
+
+			virtual Status CreateNewBackup(DB* db, const std::string& dbname);
+			virtual Status PurgeOldBackups(uint32_t num_backups_to_keep);
+			virtual Status DeleteBackup(uint32_t backup_id);
+			virtual void GetBackupInfo(std::vector<BackupInfo>* info);
+			virtual Status RestoreDBFromBackup(uint32_t backup_id, const std::string& db_dir);
+			virtual Status RestoreDBFromLatestBackup(const std::string& db_dir);
+
+		private:
+			std::string BackupPath(const std::string& name) const
+			{
+				return options_.backup_dir + "/" + name;
+			}
+
+			static std::string MetaFileName(uint32_t backup_id)
+			{
+				char buf[30];
+				snprintf(buf, sizeof(buf), "meta/%u", backup_id);
+				return buf;
+			}
+
+			static std::string PrivateDirName(uint32_t backup_id)
+			{
+				char buf[30];
+				snprintf(buf, sizeof(buf), "private/%u", backup_id);
+				return buf;
+			}
+
+			Status WriteMeta(uint32_t backup_id, const BackupMeta& meta);
+
+			//Recompute shared_ from the backups in backups_.
+			void IndexSharedFiles();
+
+			//Delete shared files and private directories that no backup in
+			//backups_ refers to. Does nothing if some backup could not be
+			//loaded, since it may refer to any of them.
+			void GarbageCollect();
+
+			const BackupOptions options_;
+			Env* const env_;
+			RateLimiter* const limiter_;
+			std::map<uint32_t, BackupMeta> backups_;
+			bool has_damaged_backups_;
+
+			//Every shared table file referenced by some backup, by name.
+			std::map<std::string, BackupFile> shared_;
+		};
+
+		Status BackupEngineImpl::Load()
+		{
+			Status s = env_->CreateDir(options_.backup_dir);
+			if (s.ok())
+			{
+				s = env_->CreateDir(BackupPath("shared"));
+			}
+			if (s.ok())
+			{
+				s = env_->CreateDir(BackupPath("private"));
+			}
+			if (s.ok())
+			{
+				s = env_->CreateDir(BackupPath("meta"));
+			}
+			std::vector<std::string> children;
+			if (s.ok())
+			{
+				s = env_->GetChildren(BackupPath("meta"), &children);
+			}
+			if (!s.ok())
+			{
+				return s;
+			}
+
+			for (size_t i = 0; i < children.size(); i++)
+			{
+				uint64_t id;
+				if (!ParseNumber(children[i], &id))
+				{
+					continue;	//Skip ".tmp" files of interrupted backups
+				}
+				const std::string fname = BackupPath("meta/" + children[i]);
+				std::string data;
+				BackupMeta meta;
+				Status meta_status = ReadFileToString(env_, fname, &data);
+				if (meta_status.ok())
+				{
+					meta_status = DecodeMeta(fname, data, &meta);
+				}
+				if (meta_status.ok())
+				{
+					backups_[static_cast<uint32_t>(id)] = meta;
+				}
+				else
+				{
+					Log(options_.info_log, "Ignoring backup %s: %s",
+						children[i].c_str(), meta_status.ToString().c_str());
+					has_damaged_backups_ = true;
+				}
+			}
+			IndexSharedFiles();
+
+			//Drop the files left behind by an interrupted backup.
+			GarbageCollect();
+			return Status::OK();
+		}
+
+		Status BackupEngineImpl::WriteMeta(uint32_t backup_id, const BackupMeta& meta)
+		{
+			const std::string fname = BackupPath(MetaFileName(backup_id));
+			const std::string tmp = fname + ".tmp";
+			const std::string data = EncodeMeta(meta);
+			WritableFile* file;
+			Status s = env_->NewWritableFile(tmp, &file);
+			if (!s.ok())
+			{
+				return s;
+			}
+			s = file->Append(data);
+			if (s.ok())
+			{
+				s = file->Sync();
+			}
+			if (s.ok())
+			{
+				s = file->Close();
+			}
+			delete file;
+			if (s.ok())
+			{
+				s = env_->RenameFile(tmp, fname);
+			}
+			if (!s.ok())
+			{
+				env_->DeleteFile(tmp);
+			}
+			return s;
+		}
+
+		void BackupEngineImpl::IndexSharedFiles()
+		{
+			shared_.clear();
+			for (std::map<uint32_t, BackupMeta>::const_iterator it = backups_.begin();
+				it != backups_.end();
+				++it)
+			{
+				const std::vector<BackupFile>& files = it->second.files;
+				for (size_t i = 0; i < files.size(); i++)
+				{
+					if (files[i].name.compare(0, 7, "shared/") == 0)
+					{
+						shared_[files[i].name] = files[i];
+					}
+				}
+			}
+		}
+
+		void BackupEngineImpl::GarbageCollect()
+		{
+			if (has_damaged_backups_)
+			{
+				return;
+			}
+			std::vector<std::string> children;
+			env_->GetChildren(BackupPath("shared"), &children);
+			for (size_t i = 0; i < children.size(); i++)
+			{
+				const std::string name = "shared/" + children[i];
+				if (shared_.find(name) == shared_.end())
+				{
+					Log(options_.info_log, "Deleting unreferenced backup file %s",
+						name.c_str());
+					env_->DeleteFile(BackupPath(name));
+				}
+			}
+
+			env_->GetChildren(BackupPath("private"), &children);
+			for (size_t i = 0; i < children.size(); i++)
+			{
+				uint64_t id;
+				if (!ParseNumber(children[i], &id) ||
+					backups_.find(static_cast<uint32_t>(id)) == backups_.end())
+				{
+					env_->DeleteDir(BackupPath("private/" + children[i]));
+				}
+			}
+		}
+
+		Status BackupEngineImpl::CreateNewBackup(DB* db, const std::string& dbname)
+		{
+			const uint32_t backup_id = backups_.empty() ? 1 : backups_.rbegin()->first + 1;
+			const uint64_t start_micros = env_->NowMicros();
+
+			//A checkpoint only links files, so it is taken at once; the
+			//copies below then read from it while the database moves on.
+			char buf[30];
+			snprintf(buf, sizeof(buf), "/BACKUP-%u.tmp", backup_id);
+			const std::string staging = dbname + buf;
+			if (env_->FileExists(staging))
+			{
+				env_->DeleteDir(staging);	//Left by an interrupted backup
+			}
+			Status s = db->CreateCheckpoint(staging);
+			std::vector<std::string> children;
+			if (s.ok())
+			{
+				s = env_->GetChildren(staging, &children);
+			}
+			const std::string private_dir = PrivateDirName(backup_id);
+			if (s.ok())
+			{
+				s = env_->CreateDir(BackupPath(private_dir));
+			}
+
+			//Table files are checksummed first, on the copy threads. A table
+			//already in shared/ under the same number, checksum and size is
+			//not copied again.
+			std::vector<std::string> table_names;
+			std::vector<uint64_t> table_numbers;
+			std::vector<CopyJob> checksums;
+			std::vector<std::string> other_names;
+			for (size_t i = 0; s.ok() && i < children.size(); i++)
+			{
+				uint64_t number;
+				FileType type;
+				if (!ParseFileName(children[i], &number, &type))
+				{
+					continue;
+				}
+				if (type == kTableFile)
+				{
+					table_numbers.push_back(number);
+					checksums.push_back(CopyJob(staging + "/" + children[i], ""));
+				}
+				else if (type == kDescriptorFIle || type == kCurrentFile)
+				{
+					other_names.push_back(children[i]);
+				}
+			}
+			if (s.ok())
+			{
+				CopyRunner runner(env_, limiter_, &checksums);
+				s = runner.Run(options_.max_background_copies);
+			}
+
+			BackupMeta meta;
+			meta.timestamp = static_cast<uint64_t>(time(NULL));
+			std::vector<CopyJob> jobs;
+			std::vector<size_t> job_files;	//Index in meta.files of each job
+			uint64_t reused_bytes = 0;
+			for (size_t i = 0; s.ok() && i < checksums.size(); i++)
+			{
+				BackupFile f;
+				f.size = checksums[i].size;
+				f.crc = checksums[i].crc;
+				f.name = SharedTableName(table_numbers[i], f.crc, f.size);
+				if (shared_.find(f.name) != shared_.end())
+				{
+					reused_bytes += f.size;
+					meta.files.push_back(f);
+					continue;
+				}
+				//Tables are immutable, so the copy must match the checksum
+				CopyJob job(checksums[i].src, BackupPath(f.name));
+				job.verify = true;
+				job.expected_size = f.size;
+				job.expected_crc = f.crc;
+				jobs.push_back(job);
+				job_files.push_back(meta.files.size());
+				meta.files.push_back(f);
+			}
+			for (size_t i = 0; s.ok() && i < other_names.size(); i++)
+			{
+				BackupFile f;
+				f.name = private_dir + "/" + other_names[i];
+				f.size = 0;
+				f.crc = 0;
+				jobs.push_back(CopyJob(staging + "/" + other_names[i], BackupPath(f.name)));
+				job_files.push_back(meta.files.size());
+				meta.files.push_back(f);
+			}
+
+			uint64_t copied_bytes = 0;
+			if (s.ok())
+			{
+				CopyRunner runner(env_, limiter_, &jobs);
+				s = runner.Run(options_.max_background_copies);
+			}
+			if (s.ok())
+			{
+				for (size_t i = 0; i < jobs.size(); i++)
+				{
+					BackupFile* f = &meta.files[job_files[i]];
+					f->size = jobs[i].size;
+					f->crc = jobs[i].crc;
+					copied_bytes += jobs[i].size;
+				}
+				s = WriteMeta(backup_id, meta);
+			}
+			env_->DeleteDir(staging);
+
+			if (s.ok())
+			{
+				backups_[backup_id] = meta;
+				IndexSharedFiles();
+			}
+			else
+			{
+				//Drop whatever this backup copied.
+				GarbageCollect();
+			}
+			Log(options_.info_log,
+				"Backup %u: %d files copied (%llu bytes), %llu bytes reused, %llu us: %s",
+				backup_id, static_cast<int>(jobs.size()),
+				static_cast<unsigned long long>(copied_bytes),
+				static_cast<unsigned long long>(reused_bytes),
+				static_cast<unsigned long long>(env_->NowMicros() - start_micros),
+				s.ToString().c_str());
+			return s;
+		}
+
+		Status BackupEngineImpl::PurgeOldBackups(uint32_t num_backups_to_keep)
+		{
+			Status s;
+			while (backups_.size() > num_backups_to_keep)
+			{
+				const uint32_t backup_id = backups_.begin()->first;
+				s = env_->DeleteFile(BackupPath(MetaFileName(backup_id)));
+				if (!s.ok())
+				{
+					break;
+				}
+				backups_.erase(backups_.begin());
+			}
+			IndexSharedFiles();
+			GarbageCollect();
+			return s;
+		}
+
+		Status BackupEngineImpl::DeleteBackup(uint32_t backup_id)
+		{
+			if (backups_.find(backup_id) == backups_.end())
+			{
+				return Status::NotFound(MetaFileName(backup_id), "no such backup");
+			}
+			//Once the metadata is gone the backup no longer exists; its files
+			//are only garbage.
+			Status s = env_->DeleteFile(BackupPath(MetaFileName(backup_id)));
+			if (s.ok())
+			{
+				backups_.erase(backup_id);
+				IndexSharedFiles();
+				GarbageCollect();
+			}
+			return s;
+		}
+
+		void BackupEngineImpl::GetBackupInfo(std::vector<BackupInfo>* info)
+		{
+			info->clear();
+			for (std::map<uint32_t, BackupMeta>::const_iterator it = backups_.begin();
+				it != backups_.end();
+				++it)
+			{
+				BackupInfo b;
+				b.backup_id = it->first;
+				b.timestamp = it->second.timestamp;
+				b.size = 0;
+				b.number_files = static_cast<uint32_t>(it->second.files.size());
+				for (size_t i = 0; i < it->second.files.size(); i++)
+				{
+					b.size += it->second.files[i].size;
+				}
+				info->push_back(b);
+			}
+		}
+
+		Status BackupEngineImpl::RestoreDBFromBackup(uint32_t backup_id,
+			const std::string& db_dir)
+		{
+			std::map<uint32_t, BackupMeta>::const_iterator it = backups_.find(backup_id);
+			if (it == backups_.end())
+			{
+				return Status::NotFound(MetaFileName(backup_id), "no such backup");
+			}
+			const uint64_t start_micros = env_->NowMicros();
+			Status s = env_->CreateDir(db_dir);
+			if (!s.ok())
+			{
+				return s;
+			}
+
+			//Remove the files of the database being replaced. Its logs in
+			//particular would otherwise be replayed over the restored data.
+			std::vector<std::string> children;
+			env_->GetChildren(db_dir, &children);
+			for (size_t i = 0; i < children.size(); i++)
+			{
+				uint64_t number;
+				FileType type;
+				if (ParseFileName(children[i], &number, &type) &&
+					type != kDBLockFile && type != kInfoLogFile)
+				{
+					env_->DeleteFile(db_dir + "/" + children[i]);
+				}
+			}
+
+			//CURRENT is restored last, once everything it leads to is in place.
+			std::vector<CopyJob> jobs;
+			std::vector<CopyJob> current;
+			const std::vector<BackupFile>& files = it->second.files;
+			for (size_t i = 0; i < files.size(); i++)
+			{
+				CopyJob job(BackupPath(files[i].name), db_dir + "/" + RestoredName(files[i].name));
+				job.verify = true;
+				job.expected_size = files[i].size;
+				job.expected_crc = files[i].crc;
+				if (RestoredName(files[i].name) == "CURRENT")
+				{
+					current.push_back(job);
+				}
+				else
+				{
+					jobs.push_back(job);
+				}
+			}
+			CopyRunner runner(env_, limiter_, &jobs);
+			s = runner.Run(options_.max_background_copies);
+			if (s.ok())
+			{
+				CopyRunner current_runner(env_, limiter_, &current);
+				s = current_runner.Run(1);
+			}
+			Log(options_.info_log, "Restore of backup %u into %s: %d files, %llu us: %s",
+				backup_id, db_dir.c_str(), static_cast<int>(files.size()),
+				static_cast<unsigned long long>(env_->NowMicros() - start_micros),
+				s.ToString().c_str());
+			return s;
+		}
+
+		Status BackupEngineImpl::RestoreDBFromLatestBackup(const std::string& db_dir)
+		{
+			if (backups_.empty())
+			{
+				return Status::NotFound(options_.backup_dir, "holds no backup");
+			}
+			return RestoreDBFromBackup(backups_.rbegin()->first, db_dir);
+		}
+	}
+
+	Status BackupEngine::Open(const BackupOptions& options, BackupEngine** result)
+	{
+		*result = NULL;
+		BackupEngineImpl* impl = new BackupEngineImpl(options);
+		Status s = impl->Load();
+		if (s.ok())
+		{
+			*result = impl;
+		}
+		else
+		{
+			delete impl;
+		}
+		return s;
+	}
+}
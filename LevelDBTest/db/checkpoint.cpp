@@ -0,0 +1,169 @@
+#include "db/checkpoint.h"
+
+#include <set>
+#include "db/filename.h"
+#include "db/log_writer.h"
+#include "db/version_edit.h"
+#include "db/version_set.h"
+#include "leveldb/env.h"
+
+namespace leveldb{
+
+	static Status CopyFile(Env* env, const std::string& src, const std::string& target)
+	{
+		SequentialFile* in;
+		Status s = env->NewSequentialFile(src, &in);
+		if (!s.ok())
+		{
+			return s;
+		}
+		WritableFile* out;
+		s = env->NewWritableFile(target, &out);
+		if (!s.ok())
+		{
+			delete in;
+			return s;
+		}
+
+		static const int kBufferSize = 64 << 10;
+		char* scratch = new char[kBufferSize];
+		while (s.ok())
+		{
+			Slice fragment;
+			s = in->Read(kBufferSize, &fragment, scratch);
+			if (!s.ok() || fragment.empty())
+			{
+				break;
+			}
+			s = out->Append(fragment);
+		}
+		delete[] scratch;
+		delete in;
+
+		if (s.ok())
+		{
+			s = out->Sync();
+		}
+		if (s.ok())
+		{
+			s = out->Close();
+		}
+		delete out;
+		if (!s.ok())
+		{
+			env->DeleteFile(target);
+		}
+		return s;
+	}
+
+	//Write a descriptor holding the single record "edit" as file
+	//"manifest_number" of "dir" and point CURRENT at it.
+	static Status WriteDescriptor(Env* env, const std::string& dir,
+		uint64_t manifest_number, const VersionEdit& edit)
+	{
+		const std::string manifest = DescriptorFileName(dir, manifest_number);
+		WritableFile* file;
+		Status s = env->NewWritableFile(manifest, &file);
+		if (!s.ok())
+		{
+			return s;
+		}
+		{
+			log::Writer log(file);
+			std::string record;
+			edit.EncodeTo(&record);
+			s = log.AddRecord(record);
+		}
+		if (s.ok())
+		{
+			s = file->Sync();
+		}
+		if (s.ok())
+		{
+			s = file->Close();
+		}
+		delete file;
+		if (s.ok())
+		{
+			s = SetCurrentFile(env, dir, manifest_number);
+		}
+		return s;
+	}
+
+	extern Status CreateCheckpoint(const std::string& dbname,
+		const Options& options,
+		VersionSet* versions,
+		const std::string& checkpoint_dir,
+		port::Mutex* mu)
+	{
+		mu->AssertHeld();
+		Env* env = options.env;
+		if (env->FileExists(checkpoint_dir))
+		{
+			return Status::InvalidArgument(checkpoint_dir, "exists");
+		}
+
+		//Describe the current version as a self-contained descriptor rather
+		//than copying our MANIFEST, which may be rolled over and deleted
+		//while we work. The descriptor takes the next file number so that
+		//every file it lists is older than anything the checkpoint creates.
+		VersionEdit edit;
+		std::set<uint64_t> files;
+		versions->AddSnapshotTo(&edit, &files);
+		const uint64_t manifest_number = versions->NewFileNumber();
+		edit.SetLogNumber(versions->LogNumber());
+		edit.SetPrevLogNumber(0);
+		edit.setNextFile(manifest_number + 1);
+		edit.SetLastSequence(versions->LastSequence());
+
+		Version* pinned = versions->current();
+		pinned->Ref();
+		mu->Unlock();
+
+		const uint64_t start_micros = env->NowMicros();
+		//Build the checkpoint under a temporary name and rename it into
+		//place, so "checkpoint_dir" only ever appears complete.
+		const std::string tmp_dir = checkpoint_dir + ".tmp";
+		Status s = env->CreateDir(tmp_dir);
+		int linked = 0;
+		int copied = 0;
+		for (std::set<uint64_t>::const_iterator it = files.begin();
+			s.ok() && it != files.end();
+			++it)
+		{
+			const std::string src = TableFileName(dbname, *it);
+			const std::string target = TableFileName(tmp_dir, *it);
+			if (env->LinkFile(src, target).ok())
+			{
+				linked++;
+			}
+			else
+			{
+				//No link support, or the target is on another file system.
+				s = CopyFile(env, src, target);
+				copied++;
+			}
+		}
+		if (s.ok())
+		{
+			s = WriteDescriptor(env, tmp_dir, manifest_number, edit);
+		}
+		if (s.ok())
+		{
+			s = env->RenameFile(tmp_dir, checkpoint_dir);
+		}
+		if (!s.ok())
+		{
+			env->DeleteDir(tmp_dir);
+		}
+
+		Log(options.info_log, "Checkpoint %s: %d files linked, %d copied, %llu us: %s",
+			checkpoint_dir.c_str(), linked, copied,
+			static_cast<unsigned long long>(env->NowMicros() - start_micros),
+			s.ToString().c_str());
+
+		mu->Lock();
+		pinned->Unref();
+		return s;
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include "leveldb/options.h"
+#include "leveldb/status.h"
+#include "port/port.h"
+
+namespace leveldb{
+
+	class VersionSet;
+
+	//Create in "checkpoint_dir", which must not exist, a database that can
+	//be opened on its own and holds the current version of *versions.
+	//Every table file is hard-linked into the new directory (or copied
+	//where the Env cannot link), and a fresh MANIFEST listing exactly those
+	//files is written along with a CURRENT file naming it, so the cost
+	//does not grow with the amount of data. Writes still held in the
+	//memtable or the log are not part of the checkpoint; the caller
+	//flushes the memtable first.
+	//REQUIRES: *mu is held. It is released while files are linked, and the
+	//current version is pinned meanwhile so its files are not deleted.
+	extern Status CreateCheckpoint(const std::string& dbname,
+		const Options& options,
+		VersionSet* versions,
+		const std::string& checkpoint_dir,
+		port::Mutex* mu);
+}
@@ -0,0 +1,19 @@
+#include "db/db_impl.h"
+#include "leveldb/pinnable_slice.h"
+
+namespace leveldb{
+
+	//Default implementations of convenience methods that subclasses of DB
+	//can call if they wish
+	Status DB::Get(const ReadOptions& options, const Slice& key, PinnableSlice* value)
+	{
+		value->Reset();
+		Status s = Get(options, key, value->GetSelf());
+		if (s.ok())
+		{
+			value->PinSelf();
+		}
+		return s;
+	}
+
+}
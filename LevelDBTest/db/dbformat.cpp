@@ -105,6 +105,18 @@ namespace leveldb{
 		}
 	}
 
+	const char* InternalKeySliceTransform::Name() const {
+		return user_transform_->Name();
+	}
+
+	Slice InternalKeySliceTransform::Transform(const Slice& key) const {
+		return user_transform_->Transform(ExtractUserKey(key));
+	}
+
+	bool InternalKeySliceTransform::InDomain(const Slice& key) const {
+		return user_transform_->InDomain(ExtractUserKey(key));
+	}
+
 	LookupKey::LookupKey(const Slice& user_key, SequenceNumber s) {
 		size_t usize = user_key.size();
 		size_t needed = usize + 13;  // A conservative estimate
@@ -125,6 +137,18 @@ namespace leveldb{
 		end_ = dst;
 	}
 
+	const char* MemTableKeyBuffer::Encode(const Slice& internal_key) {
+		const size_t needed = internal_key.size() + 5;
+		if (needed > capacity_) {
+			if (buf_ != space_) delete[] buf_;
+			buf_ = new char[needed];
+			capacity_ = needed;
+		}
+		char* dst = EncodeVarint32(buf_, internal_key.size());
+		memcpy(dst, internal_key.data(), internal_key.size());
+		return buf_;
+	}
+
 
 
 
@@ -9,6 +9,7 @@
 #include "leveldb/comparator.h"
 #include "leveldb/db.h"
 #include "leveldb/slice.h"
+#include "leveldb/slice_transform.h"
 #include "leveldb/table_builder.h"
 #include "util/coding.h"
 #include "util/logging.h"
@@ -46,7 +47,9 @@ namespace leveldb {
 	// data structures.
 	enum ValueType {
 		kTypeDeletion = 0x0,
-		kTypeValue = 0x1
+		kTypeValue = 0x1,
+		kTypeMerge = 0x2,	//Operand for the configured Options::merge_operator
+		kTypeRangeDeletion = 0x3	//Deletes [user key, value) for older sequences
 	};
 	// kValueTypeForSeek defines the ValueType that should be passed when
 	// constructing a ParsedInternalKey object for seeking to a particular
@@ -54,7 +57,7 @@ namespace leveldb {
 	// and the value type is embedded as the low 8 bits in the sequence
 	// number in internal keys, we need to use the highest-numbered
 	// ValueType, not the lowest).
-	static const ValueType kValueTypeForSeek = kTypeValue;
+	static const ValueType kValueTypeForSeek = kTypeRangeDeletion;
 
 	typedef uint64_t SequenceNumber;
 
@@ -123,6 +126,25 @@ namespace leveldb {
 		int Compare(const InternalKey& a, const InternalKey& b) const;
 	};
 
+	// A prefix extractor for internal keys that applies the user's
+	// transformation to the user key portion. The DB wraps
+	// Options::prefix_extractor in one of these, just as it wraps the
+	// comparator, so that tables built from internal keys record user key
+	// prefixes. Name() is the user transformation's, so the prefix filters
+	// of those tables and of ingested files (which hold plain user keys)
+	// are interchangeable.
+	class InternalKeySliceTransform : public SliceTransform {
+	private:
+		const SliceTransform* const user_transform_;
+	public:
+		explicit InternalKeySliceTransform(const SliceTransform* t) : user_transform_(t) { }
+		virtual const char* Name() const;
+		virtual Slice Transform(const Slice& key) const;
+		virtual bool InDomain(const Slice& key) const;
+
+		const SliceTransform* user_transform() const { return user_transform_; }
+	};
+
 	// Modules in this directory should keep internal keys wrapped inside
 	// the following class instead of plain strings so that we do not
 	// incorrectly use string comparisons instead of an InternalKeyComparator.
@@ -167,7 +189,7 @@ namespace leveldb {
 		result->sequence = num >> 8;
 		result->type = static_cast<ValueType>(c);
 		result->user_key = Slice(internal_key.data(), n - 8);
-		return (c <= static_cast<unsigned char>(kTypeValue));
+		return (c <= static_cast<unsigned char>(kTypeRangeDeletion));
 	}
 
 	// A helper class useful for DBImpl::Get()
@@ -188,6 +210,9 @@ namespace leveldb {
 		// Return the user key
 		Slice user_key() const { return Slice(kstart_, end_ - kstart_ - 8); }
 
+		// Return the sequence number the lookup is performed at
+		SequenceNumber sequence() const { return DecodeFixed64(end_ - 8) >> 8; }
+
 	private:
 		// We construct a char array of the form:
 		//    klength  varint32               <-- start_
@@ -210,6 +235,32 @@ namespace leveldb {
 		if (start_ != space_) delete[] start_;
 	}
 
+	// Holds a varint32 length-prefixed copy of an internal key, the form
+	// memtable entries and memtable seek targets take. Keys that fit in
+	// the inline buffer are encoded without touching the heap; a longer key
+	// grows a heap buffer that is kept for the keys encoded after it.
+	class MemTableKeyBuffer {
+	public:
+		MemTableKeyBuffer() : buf_(space_), capacity_(sizeof(space_)) { }
+
+		~MemTableKeyBuffer() {
+			if (buf_ != space_) delete[] buf_;
+		}
+
+		// Encode "internal_key" and return the encoding, which stays valid
+		// until the next call.
+		const char* Encode(const Slice& internal_key);
+
+	private:
+		char* buf_;
+		size_t capacity_;
+		char space_[200];      // Avoid allocation for short keys
+
+		// No copying allowed
+		MemTableKeyBuffer(const MemTableKeyBuffer&);
+		void operator=(const MemTableKeyBuffer&);
+	};
+
 }
 
 #endif  // STORAGE_LEVELDB_DB_FORMAT_H_
@@ -0,0 +1,179 @@
+#include "db/external_file.h"
+
+#include "db/filename.h"
+#include "db/version_edit.h"
+#include "db/version_set.h"
+#include "leveldb/comparator.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "leveldb/table.h"
+
+namespace leveldb{
+
+	extern Status ReadExternalFileInfo(const Options& options,
+		const std::string& fname,
+		ExternalFileInfo* info)
+	{
+		Env* env = options.env;
+		info->fname = fname;
+		Status s = env->GetFileSize(fname, &info->file_size);
+		if (!s.ok())
+		{
+			return s;
+		}
+
+		RandomAccessFile* file = NULL;
+		s = env->NewRandomAccessFile(fname, &file);
+		if (!s.ok())
+		{
+			return s;
+		}
+		Table* table = NULL;
+		s = Table::Open(options, file, info->file_size, &table);
+		if (!s.ok())
+		{
+			delete file;
+			return s;
+		}
+
+		ReadOptions read_options;
+		read_options.verify_checksums = options.paranoid_checks;
+		read_options.fill_cache = false;
+		Iterator* iter = table->NewIterator(read_options);
+		iter->SeekToFirst();
+		if (!iter->Valid())
+		{
+			s = iter->status();
+			if (s.ok())
+			{
+				s = Status::InvalidArgument(fname, "external file has no entries");
+			}
+		}
+		else
+		{
+			info->smallest_user_key = iter->key().ToString();
+			if (options.paranoid_checks)
+			{
+				std::string last = info->smallest_user_key;
+				for (iter->Next(); iter->Valid(); iter->Next())
+				{
+					if (options.comparator->Compare(last, iter->key()) >= 0)
+					{
+						s = Status::Corruption(fname, "keys are not strictly increasing");
+						break;
+					}
+					last.assign(iter->key().data(), iter->key().size());
+				}
+				if (s.ok())
+				{
+					s = iter->status();
+				}
+				info->largest_user_key.swap(last);
+			}
+			else
+			{
+				iter->SeekToLast();
+				if (iter->Valid())
+				{
+					info->largest_user_key = iter->key().ToString();
+				}
+				s = iter->status();
+			}
+		}
+
+		delete iter;
+		delete table;
+		delete file;
+		return s;
+	}
+
+	extern Status InstallExternalFile(const std::string& dbname,
+		const Options& options,
+		VersionSet* versions,
+		const ExternalFileInfo& info,
+		port::Mutex* mu)
+	{
+		mu->AssertHeld();
+		const uint64_t number = versions->NewFileNumber();
+		const SequenceNumber seq = versions->LastSequence() + 1;
+		const std::string table_name = TableFileName(dbname, number);
+		Status s = options.env->RenameFile(info.fname, table_name);
+		if (!s.ok())
+		{
+			return s;
+		}
+
+		const int level = versions->current()->PickLevelForExternalFile(
+			info.smallest_user_key, info.largest_user_key);
+		VersionEdit edit;
+		edit.AddFile(level, number, info.file_size,
+			InternalKey(info.smallest_user_key, seq, kTypeValue),
+			InternalKey(info.largest_user_key, seq, kTypeValue),
+			seq);
+		versions->SetLastSequence(seq);
+		s = versions->LogAndApply(&edit, mu);
+		if (!s.ok())
+		{
+			//Hand the file back to the caller untouched.
+			options.env->RenameFile(table_name, info.fname);
+		}
+		return s;
+	}
+
+	namespace {
+		class GlobalSeqnoIterator :public Iterator{
+		public:
+			GlobalSeqnoIterator(Iterator* iter, SequenceNumber seq, const Comparator* ucmp)
+				:iter_(iter), seq_(seq), ucmp_(ucmp){ }
+
+			virtual ~GlobalSeqnoIterator(){ delete iter_; }
+
+			virtual bool Valid() const { return iter_->Valid(); }
+			virtual void SeekToFirst(){ iter_->SeekToFirst(); UpdateKey(); }
+			virtual void SeekToLast(){ iter_->SeekToLast(); UpdateKey(); }
+			virtual void Next(){ iter_->Next(); UpdateKey(); }
+			virtual void Prev(){ iter_->Prev(); UpdateKey(); }
+
+			virtual void Seek(const Slice& target){
+				Slice user_key = ExtractUserKey(target);
+				const SequenceNumber target_seq =
+					DecodeFixed64(target.data() + target.size() - 8) >> 8;
+				iter_->Seek(user_key);
+				if (iter_->Valid() && target_seq < seq_ &&
+					ucmp_->Compare(iter_->key(), user_key) == 0)
+				{
+					//(user_key, seq_) sorts before the target since larger
+					//sequence numbers come first.
+					iter_->Next();
+				}
+				UpdateKey();
+			}
+
+			virtual Slice key() const { assert(Valid()); return key_; }
+			virtual Slice value() const { return iter_->value(); }
+			virtual Status status() const { return iter_->status(); }
+
+		private:
+			void UpdateKey(){
+				if (iter_->Valid())
+				{
+					key_.clear();
+					AppendInternalKey(&key_, ParsedInternalKey(iter_->key(), seq_, kTypeValue));
+				}
+			}
+
+			Iterator* const iter_;
+			const SequenceNumber seq_;
+			const Comparator* const ucmp_;
+			std::string key_;
+		};
+	}
+
+	extern Iterator* NewGlobalSeqnoIterator(Iterator* iter,
+		SequenceNumber seq,
+		const Comparator* ucmp)
+	{
+		return new GlobalSeqnoIterator(iter, seq, ucmp);
+	}
+
+}
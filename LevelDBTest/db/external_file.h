@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <stdint.h>
+#include "db/dbformat.h"
+#include "port/port.h"
+
+namespace leveldb{
+
+	class Comparator;
+	class Iterator;
+	class VersionSet;
+
+	//A table file built outside of the DB with TableBuilder. Such files
+	//hold plain user keys; when ingested they are stamped with one global
+	//sequence number so that every entry reads as
+	//(user_key, global_seqno, kTypeValue).
+	struct ExternalFileInfo{
+		std::string fname;
+		uint64_t file_size;
+		std::string smallest_user_key;
+		std::string largest_user_key;
+	};
+
+	//Open "fname" as a table and fill *info with its size and key range.
+	//If options.paranoid_checks is set, every block is read with checksum
+	//verification and keys are checked to be strictly increasing under
+	//options.comparator; otherwise only the footer, index and the first
+	//and last blocks are read.
+	extern Status ReadExternalFileInfo(const Options& options,
+		const std::string& fname,
+		ExternalFileInfo* info);
+
+	//Move the file described by "info" into database "dbname" and install
+	//it in *versions with the next sequence number, at the deepest level
+	//that keeps it above every file it overlaps. The data is neither
+	//copied nor written to the log.
+	//REQUIRES: *mu is held, and no memtable holds keys in the file's range
+	//(the caller flushes an overlapping memtable first).
+	extern Status InstallExternalFile(const std::string& dbname,
+		const Options& options,
+		VersionSet* versions,
+		const ExternalFileInfo& info,
+		port::Mutex* mu);
+
+	//Return an iterator that yields the entries of "iter", whose keys are
+	//user keys, as internal keys tagged (seq, kTypeValue). Takes ownership
+	//of "iter".
+	extern Iterator* NewGlobalSeqnoIterator(Iterator* iter,
+		SequenceNumber seq,
+		const Comparator* ucmp);
+}
@@ -0,0 +1,124 @@
+//Checks that Version::Get reads an ingested file, which holds plain user
+//keys, alongside a table the DB flushed, which holds internal keys.
+//Built as its own console program.
+#include <stdio.h>
+#include <string>
+#include "db/dbformat.h"
+#include "db/external_file.h"
+#include "db/merge_context.h"
+#include "db/table_cache.h"
+#include "db/testutil.h"
+#include "db/version_edit.h"
+#include "db/version_set.h"
+#include "leveldb/comparator.h"
+#include "leveldb/env.h"
+#include "leveldb/options.h"
+#include "leveldb/pinnable_slice.h"
+#include "leveldb/table_builder.h"
+#include "port/port.h"
+
+using namespace leveldb;
+using leveldb::test::CheckOk;
+
+//Build "fname" from the sorted entries keys[i] -> values[i].
+static void BuildTable(const Options& options, const std::string& fname,
+	const std::string* keys, const std::string* values, int n)
+{
+	leveldb::WritableFile* file;
+	CheckOk(options.env->NewWritableFile(fname, &file));
+	TableBuilder builder(options, file);
+	for (int i = 0; i < n; i++)
+	{
+		builder.Add(keys[i], values[i]);
+	}
+	CheckOk(builder.Finish());
+	CheckOk(file->Close());
+	delete file;
+}
+
+static std::string Get(Version* v, const std::string& user_key,
+	SequenceNumber seq)
+{
+	LookupKey k(user_key, seq);
+	PinnableSlice value;
+	Version::GetStats stats;
+	MergeContext merge_context(NULL);
+	SequenceNumber max_covering_tombstone_seq = 0;
+	Status s = v->Get(ReadOptions(), k, &value, &stats, &merge_context,
+		&max_covering_tombstone_seq);
+	if (s.IsNotFound())
+	{
+		return "NOT_FOUND";
+	}
+	CheckOk(s);
+	return value.ToString();
+}
+
+int main(int argc, char** argv)
+{
+	Env* env = Env::Default();
+	const std::string dbname = test::NewTestDirectory(env, "external_file_test");
+
+	//What the DB hands its TableCache and VersionSet: the user's options
+	//with the comparator wrapped for internal keys.
+	Options user_options;
+	InternalKeyComparator icmp(user_options.comparator);
+	Options options = user_options;
+	options.comparator = &icmp;
+	TableCache table_cache(dbname, &options, user_options.comparator, 100);
+	VersionSet versions(dbname, &options, &table_cache, &icmp);
+	test::NewDB(env, dbname, user_options.comparator);
+	CheckOk(versions.Recover());
+	port::Mutex mu;
+	mu.Lock();
+
+	//A flushed level-0 table. Keys are shorter than the 8-byte tag, which
+	//an internal key comparator would read past.
+	const uint64_t flushed = versions.NewFileNumber();
+	const std::string flushed_keys[] = {
+		InternalKey("a", 1, kTypeValue).Encode().ToString(),
+		InternalKey("b", 2, kTypeValue).Encode().ToString(),
+		InternalKey("c", 3, kTypeValue).Encode().ToString()
+	};
+	const std::string flushed_values[] = { "flushed-a", "flushed-b", "flushed-c" };
+	BuildTable(options, TableFileName(dbname, flushed),
+		flushed_keys, flushed_values, 3);
+	uint64_t flushed_size;
+	CheckOk(env->GetFileSize(TableFileName(dbname, flushed), &flushed_size));
+	VersionEdit edit;
+	edit.AddFile(0, flushed, flushed_size,
+		InternalKey("a", 1, kTypeValue), InternalKey("c", 3, kTypeValue), 0);
+	versions.SetLastSequence(3);
+	CheckOk(versions.LogAndApply(&edit, &mu));
+
+	//An external file overlapping it, built with the user comparator.
+	const std::string external_keys[] = { "b", "d" };
+	const std::string external_values[] = { "ingested-b", "ingested-d" };
+	const std::string external_name = dbname + "/external.sst";
+	BuildTable(user_options, external_name, external_keys, external_values, 2);
+	ExternalFileInfo info;
+	CheckOk(ReadExternalFileInfo(user_options, external_name, &info));
+	LEVELDB_CHECK(info.smallest_user_key == "b");
+	LEVELDB_CHECK(info.largest_user_key == "d");
+	CheckOk(InstallExternalFile(dbname, options, &versions, info, &mu));
+	LEVELDB_CHECK(versions.LastSequence() == 4);
+	LEVELDB_CHECK(versions.current()->NumFiles(0) == 2);
+
+	Version* v = versions.current();
+	v->Ref();
+	mu.Unlock();
+	LEVELDB_CHECK(Get(v, "a", 4) == "flushed-a");
+	LEVELDB_CHECK(Get(v, "b", 4) == "ingested-b");
+	LEVELDB_CHECK(Get(v, "c", 4) == "flushed-c");
+	LEVELDB_CHECK(Get(v, "d", 4) == "ingested-d");
+	LEVELDB_CHECK(Get(v, "e", 4) == "NOT_FOUND");
+	//Snapshots older than the ingestion do not see it.
+	LEVELDB_CHECK(Get(v, "b", 3) == "flushed-b");
+	LEVELDB_CHECK(Get(v, "d", 3) == "NOT_FOUND");
+	mu.Lock();
+	v->Unref();
+	mu.Unlock();
+
+	fprintf(stderr, "PASS\n");
+	return 0;
+}
@@ -0,0 +1,258 @@
+#include "db/file_indexer.h"
+
+#include <algorithm>
+#include <assert.h>
+#include "db/version_edit.h"
+#include "leveldb/comparator.h"
+
+namespace leveldb{
+
+	//The first 8 bytes of "key", zero padded, as a big-endian integer.
+	//If a < b bytewise then PrefixOf(a) <= PrefixOf(b), so unequal
+	//prefixes decide a comparison.
+	static uint64_t PrefixOf(const Slice& key)
+	{
+		uint64_t result = 0;
+		const size_t n = key.size() < 8 ? key.size() : 8;
+		for (size_t i = 0; i < 8; i++)
+		{
+			result <<= 8;
+			if (i < n)
+			{
+				result |= static_cast<unsigned char>(key[i]);
+			}
+		}
+		return result;
+	}
+
+	FileIndexer::FileIndexer()
+		:icmp_(NULL),
+		ucmp_(NULL),
+		use_prefixes_(false),
+		files_(NULL)
+	{
+
+	}
+
+	void FileIndexer::Build(const InternalKeyComparator* icmp,
+		const std::vector<FileMetaData*>* files)
+	{
+		icmp_ = icmp;
+		ucmp_ = icmp->user_comparator();
+		use_prefixes_ = (ucmp_ == BytewiseComparator());
+		files_ = files;
+		for (int level = 0; level < config::kNumLevels; level++)
+		{
+			const std::vector<FileMetaData*>& upper = files[level];
+			std::vector<IndexUnit>& index = next_level_index_[level];
+			std::vector<KeyPrefixes>& prefixes = prefixes_[level];
+			index.clear();
+			prefixes.clear();
+
+			if (use_prefixes_)
+			{
+				prefixes.resize(upper.size());
+				for (size_t i = 0; i < upper.size(); i++)
+				{
+					prefixes[i].smallest = PrefixOf(upper[i]->smallest.user_key());
+					prefixes[i].largest = PrefixOf(upper[i]->largest.user_key());
+				}
+			}
+
+			//Level-0 files overlap, so a lookup checks all of them and learns
+			//nothing about where the key falls in level 1.
+			if (level == 0 || level + 1 >= config::kNumLevels)
+			{
+				continue;
+			}
+
+			const std::vector<FileMetaData*>& lower = files[level + 1];
+			const int32_t num_lower = static_cast<int32_t>(lower.size());
+			index.resize(upper.size());
+
+			//Both levels are sorted, so each bound only moves forward.
+			int32_t smallest_lb = 0, largest_lb = 0;
+			int32_t smallest_rb = -1, largest_rb = -1;
+			for (size_t i = 0; i < upper.size(); i++)
+			{
+				const Slice smallest = upper[i]->smallest.user_key();
+				const Slice largest = upper[i]->largest.user_key();
+				while (smallest_lb < num_lower &&
+					ucmp_->Compare(lower[smallest_lb]->largest.user_key(), smallest) < 0)
+				{
+					smallest_lb++;
+				}
+				while (largest_lb < num_lower &&
+					ucmp_->Compare(lower[largest_lb]->largest.user_key(), largest) < 0)
+				{
+					largest_lb++;
+				}
+				while (smallest_rb + 1 < num_lower &&
+					ucmp_->Compare(lower[smallest_rb + 1]->smallest.user_key(), smallest) <= 0)
+				{
+					smallest_rb++;
+				}
+				while (largest_rb + 1 < num_lower &&
+					ucmp_->Compare(lower[largest_rb + 1]->smallest.user_key(), largest) <= 0)
+				{
+					largest_rb++;
+				}
+
+				IndexUnit& unit = index[i];
+				unit.smallest_lb = smallest_lb;
+				unit.largest_lb = largest_lb;
+				unit.smallest_rb = smallest_rb;
+				unit.largest_rb = largest_rb;
+			}
+		}
+	}
+
+	uint64_t FileIndexer::KeyPrefix(const Slice& user_key) const
+	{
+		return use_prefixes_ ? PrefixOf(user_key) : 0;
+	}
+
+	int FileIndexer::CompareSmallest(int level, int32_t index,
+		const Slice& user_key, uint64_t key_prefix) const
+	{
+		if (use_prefixes_)
+		{
+			const uint64_t file_prefix = prefixes_[level][index].smallest;
+			if (key_prefix != file_prefix)
+			{
+				return key_prefix < file_prefix ? -1 : +1;
+			}
+		}
+		return ucmp_->Compare(user_key, files_[level][index]->smallest.user_key());
+	}
+
+	int FileIndexer::CompareLargest(int level, int32_t index,
+		const Slice& user_key, uint64_t key_prefix) const
+	{
+		if (use_prefixes_)
+		{
+			const uint64_t file_prefix = prefixes_[level][index].largest;
+			if (key_prefix != file_prefix)
+			{
+				return key_prefix < file_prefix ? -1 : +1;
+			}
+		}
+		return ucmp_->Compare(user_key, files_[level][index]->largest.user_key());
+	}
+
+	int32_t FileIndexer::FindFile(int level, const Slice& user_key,
+		uint64_t key_prefix, const Slice& ikey, int32_t left, int32_t right) const
+	{
+		const std::vector<FileMetaData*>& files = files_[level];
+		int32_t end = right + 1;
+		while (left < end)
+		{
+			const int32_t mid = left + (end - left) / 2;
+			int r = CompareLargest(level, mid, user_key, key_prefix);
+			if (r == 0)
+			{
+				//Same user key: the sequence numbers decide.
+				r = icmp_->Compare(ikey, files[mid]->largest.Encode());
+			}
+			if (r > 0)
+			{
+				//Key at "mid.largest" is < "target". Therefore all
+				//files at or before "mid" are uninteresting.
+				left = mid + 1;
+			}
+			else
+			{
+				//Key at "mid.largest" is >= "target". Therefore all files
+				//after "mid" are uninteresting.
+				end = mid;
+			}
+		}
+		return end;
+	}
+
+	int32_t FileIndexer::LocateFile(int level, const Slice& user_key,
+		uint64_t key_prefix, const Slice& ikey, int32_t* left, int32_t* right) const
+	{
+		const int32_t last = static_cast<int32_t>(files_[level].size()) - 1;
+		const int32_t first = *left;
+		const int32_t bound = std::min(*right, last);
+		*left = 0;
+		*right = kLevelMaxIndex;
+		if (first > bound)
+		{
+			//No file of this level may hold user_key, which places it
+			//nowhere in the next level.
+			return -1;
+		}
+
+		const int32_t index = FindFile(level, user_key, key_prefix, ikey, first, bound);
+		if (index <= bound)
+		{
+			const int cmp_smallest = CompareSmallest(level, index, user_key, key_prefix);
+			const int cmp_largest = (cmp_smallest < 0) ? -1 :
+				CompareLargest(level, index, user_key, key_prefix);
+			GetNextLevelIndex(level, index, cmp_smallest, cmp_largest, left, right);
+			//Otherwise all of file "index" is past any data for user_key
+			return (cmp_smallest >= 0) ? index : -1;
+		}
+		if (bound == last)
+		{
+			//user_key is past every file of the level.
+			GetNextLevelIndex(level, index, +1, +1, left, right);
+		}
+		return -1;
+	}
+
+	void FileIndexer::GetNextLevelIndex(int level, int32_t index,
+		int cmp_smallest, int cmp_largest, int32_t* left, int32_t* right) const
+	{
+		assert(level >= 1);
+		const std::vector<IndexUnit>& units = next_level_index_[level];
+		const int32_t num_lower = level + 1 < config::kNumLevels ?
+			static_cast<int32_t>(files_[level + 1].size()) : 0;
+		if (units.empty() || num_lower == 0)
+		{
+			*left = 0;
+			*right = num_lower - 1;
+			return;
+		}
+
+		const int32_t num_upper = static_cast<int32_t>(units.size());
+		if (index >= num_upper)
+		{
+			//Past the last file of the level.
+			*left = units[num_upper - 1].largest_lb;
+			*right = num_lower - 1;
+			return;
+		}
+
+		const IndexUnit& unit = units[index];
+		if (cmp_smallest < 0)
+		{
+			//Between the previous file and this one.
+			*left = (index > 0) ? units[index - 1].largest_lb : 0;
+			*right = unit.smallest_rb;
+		}
+		else if (cmp_smallest == 0)
+		{
+			*left = unit.smallest_lb;
+			*right = unit.smallest_rb;
+		}
+		else if (cmp_largest < 0)
+		{
+			*left = unit.smallest_lb;
+			*right = unit.largest_rb;
+		}
+		else if (cmp_largest == 0)
+		{
+			*left = unit.largest_lb;
+			*right = unit.largest_rb;
+		}
+		else
+		{
+			*left = unit.largest_lb;
+			*right = num_lower - 1;
+		}
+	}
+
+}
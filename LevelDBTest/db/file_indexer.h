@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "db/dbformat.h"
+
+namespace leveldb{
+
+	struct FileMetaData;
+
+	//Search structures over the file lists of a Version, built once by
+	//VersionSet::Finalize() so that a point lookup in Version::Get() does
+	//less work per level:
+	//
+	//* Fractional cascading. For every file of levels 1 and up, the range
+	//  of files in the next level that may hold a key is precomputed for
+	//  each outcome of comparing the key with the file's smallest and
+	//  largest keys. Having placed a key in one level, the lookup binary
+	//  searches only that range of the next level instead of all of it.
+	//
+	//* A flat array per level holding the first 8 bytes of every file's
+	//  smallest and largest user keys as integers. Most comparisons of a
+	//  binary search are decided from this array without following the
+	//  FileMetaData pointers to the keys. Only used with the bytewise
+	//  comparator, whose order the integers preserve.
+	class FileIndexer
+	{
+	public:
+		//Marks an upper bound that leaves the end of the level unbounded.
+		static const int32_t kLevelMaxIndex = 0x7fffffff;
+
+		FileIndexer();
+
+		//Index "files", an array of config::kNumLevels sorted file lists
+		//ordered by "*icmp". Must be called again whenever they change.
+		void Build(const InternalKeyComparator* icmp,
+			const std::vector<FileMetaData*>* files);
+
+		//Returns the value compared with the file key prefixes of this
+		//index for a lookup of "user_key".
+		uint64_t KeyPrefix(const Slice& user_key) const;
+
+		//Return the smallest index i in [left, right] such that the
+		//largest key of file i of "level" is >= "ikey", the internal key
+		//of "user_key" with prefix "key_prefix". Returns right + 1 if there
+		//is none.
+		//REQUIRES: level >= 1, 0 <= left, right < number of files in level,
+		//Build() called
+		int32_t FindFile(int level, const Slice& user_key, uint64_t key_prefix,
+			const Slice& ikey, int32_t left, int32_t right) const;
+
+		//Compare "user_key" with the smallest (largest) user key of file
+		//"index" of "level".
+		int CompareSmallest(int level, int32_t index, const Slice& user_key,
+			uint64_t key_prefix) const;
+		int CompareLargest(int level, int32_t index, const Slice& user_key,
+			uint64_t key_prefix) const;
+
+		//Return the index of the file of "level" that may hold "user_key"
+		//(see FindFile()), or -1 if none may. Only files [*left, *right]
+		//are searched: the range the previous level narrowed the lookup
+		//to, or [0, kLevelMaxIndex] to search all of them. On return
+		//[*left, *right] is the range to search in level + 1.
+		//REQUIRES: level >= 1, Build() called
+		int32_t LocateFile(int level, const Slice& user_key, uint64_t key_prefix,
+			const Slice& ikey, int32_t* left, int32_t* right) const;
+
+		//The lookup of a key compared "cmp_smallest" and "cmp_largest" with
+		//file "index" of "level", the first file of the level whose largest
+		//key is >= the key. Store in [*left, *right] the files of level + 1
+		//that may hold the key; *left > *right if none may.
+		//REQUIRES: level >= 1
+		void GetNextLevelIndex(int level, int32_t index, int cmp_smallest,
+			int cmp_largest, int32_t* left, int32_t* right) const;
+
+	private:
+		//Ranges in the next level for one file, by outcome of comparing
+		//the key with the file's smallest and largest keys.
+		struct IndexUnit
+		{
+			int32_t smallest_lb;	//First file whose largest >= smallest
+			int32_t largest_lb;		//First file whose largest >= largest
+			int32_t smallest_rb;	//Last file whose smallest <= smallest
+			int32_t largest_rb;		//Last file whose smallest <= largest
+		};
+
+		struct KeyPrefixes
+		{
+			uint64_t smallest;
+			uint64_t largest;
+		};
+
+		const InternalKeyComparator* icmp_;
+		const Comparator* ucmp_;
+		bool use_prefixes_;
+		const std::vector<FileMetaData*>* files_;
+		std::vector<IndexUnit> next_level_index_[config::kNumLevels];
+		std::vector<KeyPrefixes> prefixes_[config::kNumLevels];
+
+		//No copying allowed
+		FileIndexer(const FileIndexer&);
+		void operator=(const FileIndexer&);
+	};
+
+}
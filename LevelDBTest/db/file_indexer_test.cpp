@@ -0,0 +1,185 @@
+//Checks the lookups of FileIndexer over random multi-level layouts:
+//walking down the levels as Version::Get() does, the file found in each
+//range narrowed by the level above must be the one a binary search over
+//the whole level finds. Keys share 8-byte prefixes, and some user keys
+//are split across adjacent files. Built as its own console program.
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "db/dbformat.h"
+#include "db/file_indexer.h"
+#include "db/testutil.h"
+#include "db/version_edit.h"
+#include "db/version_set.h"
+#include "leveldb/comparator.h"
+#include "util/random.h"
+
+using namespace leveldb;
+
+//A key from a small alphabet: short, or longer and sharing the 8-byte
+//prefix "commonpf" with many others, so that the prefixes compared by
+//FileIndexer often tie.
+static std::string RandomUserKey(Random* rnd)
+{
+	std::string key;
+	int len;
+	switch (rnd->Uniform(3))
+	{
+	case 0:
+		len = 1 + rnd->Uniform(7);
+		break;
+	case 1:
+		key = "commonpf";
+		len = rnd->Uniform(4);
+		break;
+	default:
+		key = "commonp";
+		len = rnd->Uniform(3);
+		break;
+	}
+	for (int i = 0; i < len; i++)
+	{
+		key.push_back(static_cast<char>('a' + rnd->Uniform(4)));
+	}
+	return key;
+}
+
+//Split the sorted user keys "keys" into the files of one level. A file
+//may end with a user key the next file starts with, at a lower sequence
+//number; "seqs" holds the next sequence number to use for each key.
+static void BuildLevel(Random* rnd, const std::vector<std::string>& keys,
+	std::map<std::string, SequenceNumber>* seqs, std::vector<FileMetaData*>* files)
+{
+	size_t start = 0;
+	while (start < keys.size())
+	{
+		const size_t end = std::min(keys.size() - 1, start + rnd->Uniform(4));
+		FileMetaData* f = new FileMetaData;
+		f->number = files->size() + 1;
+		f->smallest = InternalKey(keys[start], (*seqs)[keys[start]], kTypeValue);
+		(*seqs)[keys[start]] -= 10;
+		f->largest = InternalKey(keys[end], (*seqs)[keys[end]], kTypeValue);
+		(*seqs)[keys[end]] -= 10;
+		files->push_back(f);
+		//Split the last user key into the next file, or move past it.
+		start = (end > start && rnd->OneIn(3)) ? end : end + 1;
+	}
+}
+
+//Return the index of the file of "files" that may hold "ikey", by a
+//binary search over all of them, or -1 if none may.
+static int32_t FullSearch(const InternalKeyComparator& icmp,
+	const std::vector<FileMetaData*>& files, const Slice& user_key, const Slice& ikey)
+{
+	const int index = FindFile(icmp, files, ikey);
+	if (index < static_cast<int>(files.size()) &&
+		icmp.user_comparator()->Compare(user_key, files[index]->smallest.user_key()) >= 0)
+	{
+		return index;
+	}
+	return -1;
+}
+
+static void TestRandomLayout(Random* rnd)
+{
+	InternalKeyComparator icmp(BytewiseComparator());
+	std::vector<std::string> universe;
+	for (int i = 0; i < 200; i++)
+	{
+		universe.push_back(RandomUserKey(rnd));
+	}
+	std::sort(universe.begin(), universe.end());
+	universe.erase(std::unique(universe.begin(), universe.end()), universe.end());
+
+	std::vector<FileMetaData*> files[config::kNumLevels];
+	std::map<std::string, SequenceNumber> seqs;
+	for (size_t i = 0; i < universe.size(); i++)
+	{
+		seqs[universe[i]] = 1000;
+	}
+	for (int level = 1; level < config::kNumLevels; level++)
+	{
+		//Some levels stay empty; the others hold more keys the deeper they are.
+		if (rnd->OneIn(5))
+		{
+			continue;
+		}
+		std::vector<std::string> keys;
+		for (size_t i = 0; i < universe.size(); i++)
+		{
+			if (rnd->Uniform(config::kNumLevels) <= static_cast<uint32_t>(level))
+			{
+				keys.push_back(universe[i]);
+			}
+		}
+		BuildLevel(rnd, keys, &seqs, &files[level]);
+	}
+
+	FileIndexer indexer;
+	indexer.Build(&icmp, files);
+
+	//Look up every key of the layout, keys between them, and keys before
+	//and after all of them, at sequence numbers around those of split keys.
+	std::vector<std::string> lookups = universe;
+	for (int i = 0; i < 100; i++)
+	{
+		lookups.push_back(RandomUserKey(rnd));
+	}
+	lookups.push_back("");
+	lookups.push_back("zzzzzzzzzz");
+	const SequenceNumber kSeqs[] = { kMaxSequenceNumber, 1005, 995, 985, 975, 965, 955, 5 };
+	for (size_t i = 0; i < lookups.size(); i++)
+	{
+		const Slice user_key = lookups[i];
+		const uint64_t key_prefix = indexer.KeyPrefix(user_key);
+		for (size_t j = 0; j < sizeof(kSeqs) / sizeof(kSeqs[0]); j++)
+		{
+			const LookupKey lkey(user_key, kSeqs[j]);
+			const Slice ikey = lkey.internal_key();
+			int32_t left = 0;
+			int32_t right = FileIndexer::kLevelMaxIndex;
+			for (int level = 1; level < config::kNumLevels; level++)
+			{
+				const int32_t num_files = static_cast<int32_t>(files[level].size());
+				const int32_t range_left = left;
+				const int32_t range_right = std::min(right, num_files - 1);
+				const int32_t expected = FullSearch(icmp, files[level], user_key, ikey);
+				const int32_t found = indexer.LocateFile(level, user_key, key_prefix, ikey,
+					&left, &right);
+				LEVELDB_CHECK(found == expected);
+
+				//The narrowed range holds every file that may hold the key.
+				if (expected >= 0)
+				{
+					LEVELDB_CHECK(range_left <= expected && expected <= range_right);
+				}
+				if (num_files > 0)
+				{
+					LEVELDB_CHECK(indexer.FindFile(level, user_key, key_prefix, ikey,
+						0, num_files - 1) == FindFile(icmp, files[level], ikey));
+				}
+			}
+		}
+	}
+
+	for (int level = 0; level < config::kNumLevels; level++)
+	{
+		for (size_t i = 0; i < files[level].size(); i++)
+		{
+			delete files[level][i];
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Random rnd(301);
+	for (int i = 0; i < 300; i++)
+	{
+		TestRandomLayout(&rnd);
+	}
+	fprintf(stderr, "PASS\n");
+	return 0;
+}
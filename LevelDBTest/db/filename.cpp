@@ -151,6 +151,7 @@ namespace leveldb{
 		{
 			env->DeleteFile(tmp);
 		}
+		return s;
 	}
 
 
@@ -0,0 +1,217 @@
+//Checks that point lookups served from memory make no heap allocation:
+//a memtable hit, and a hit on a table whose blocks are in the block
+//cache. Keys are longer than a std::string keeps inline. Replaces the
+//global operator new to count allocations. Built as its own console
+//program.
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "db/dbformat.h"
+#include "db/filename.h"
+#include "db/memtable.h"
+#include "db/merge_context.h"
+#include "db/table_cache.h"
+#include "db/testutil.h"
+#include "db/version_edit.h"
+#include "db/version_set.h"
+#include "leveldb/cache.h"
+#include "leveldb/comparator.h"
+#include "leveldb/env.h"
+#include "leveldb/options.h"
+#include "leveldb/pinnable_slice.h"
+#include "leveldb/table_builder.h"
+#include "port/port.h"
+
+using namespace leveldb;
+using leveldb::test::CheckOk;
+
+static bool counting = false;
+static int allocations = 0;
+
+void* operator new(size_t size)
+{
+	if (counting)
+	{
+		allocations++;
+	}
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+	free(p);
+}
+
+static std::string Key(int i)
+{
+	char buf[100];
+	snprintf(buf, sizeof(buf), "a-key-longer-than-sso-%016d", i);
+	return std::string(buf);
+}
+
+static std::string Value(int i)
+{
+	char buf[100];
+	snprintf(buf, sizeof(buf), "a-value-longer-than-sso-%016d", i);
+	return std::string(buf);
+}
+
+//Look "key" up in "mem" with a pinned value, counting allocations.
+static int MemTableGet(MemTable* mem, port::Mutex* mu, const std::string& key,
+	SequenceNumber seq, std::string* result)
+{
+	allocations = 0;
+	counting = true;
+	bool found;
+	{
+		LookupKey lkey(key, seq);
+		PinnableSlice value;
+		Status s;
+		MergeContext merge_context(NULL);
+		SequenceNumber max_covering_tombstone_seq = 0;
+		found = mem->Get(lkey, &value, &s, &merge_context,
+			&max_covering_tombstone_seq, mu);
+		counting = false;
+		LEVELDB_CHECK(found);
+		CheckOk(s);
+		result->assign(value.data(), value.size());
+		counting = true;
+	}
+	counting = false;
+	return allocations;
+}
+
+//Look "key" up in "v", counting allocations.
+static int VersionGet(Version* v, const std::string& key, SequenceNumber seq,
+	std::string* result)
+{
+	allocations = 0;
+	counting = true;
+	{
+		LookupKey lkey(key, seq);
+		PinnableSlice value;
+		Version::GetStats stats;
+		MergeContext merge_context(NULL);
+		SequenceNumber max_covering_tombstone_seq = 0;
+		Status s = v->Get(ReadOptions(), lkey, &value, &stats, &merge_context,
+			&max_covering_tombstone_seq);
+		counting = false;
+		CheckOk(s);
+		LEVELDB_CHECK(value.IsPinned());
+		result->assign(value.data(), value.size());
+		counting = true;
+	}
+	counting = false;
+	return allocations;
+}
+
+static void TestMemTable()
+{
+	Options options;
+	InternalKeyComparator icmp(options.comparator);
+	MemTable* mem = new MemTable(icmp, options);
+	mem->Ref();
+	for (int i = 0; i < 1000; i++)
+	{
+		mem->Add(i + 1, kTypeValue, Key(i), Value(i));
+	}
+
+	port::Mutex mu;
+	std::string result;
+	for (int i = 0; i < 1000; i += 37)
+	{
+		const int allocated = MemTableGet(mem, &mu, Key(i), 1000, &result);
+		LEVELDB_CHECK(allocated == 0);
+		LEVELDB_CHECK(result == Value(i));
+	}
+	mem->Unref();
+}
+
+//Look keys up in a level-0 table. The first lookup of each key warms
+//the block cache; the second must not allocate.
+static void TestTable(bool cache_index_and_filter_blocks)
+{
+	Env* env = Env::Default();
+	const std::string dbname = test::NewTestDirectory(env, "get_alloc_test");
+
+	Options user_options;
+	user_options.block_cache = NewLRUCache(8 << 20);
+	user_options.cache_index_and_filter_blocks = cache_index_and_filter_blocks;
+	InternalKeyComparator icmp(user_options.comparator);
+	Options options = user_options;
+	options.comparator = &icmp;
+	TableCache* table_cache = new TableCache(dbname, &options,
+		user_options.comparator, 100);
+	VersionSet* versions = new VersionSet(dbname, &options, table_cache, &icmp);
+	test::NewDB(env, dbname, user_options.comparator);
+	CheckOk(versions->Recover());
+	port::Mutex mu;
+	mu.Lock();
+
+	const int kNum = 1000;
+	const uint64_t number = versions->NewFileNumber();
+	leveldb::WritableFile* file;
+	CheckOk(env->NewWritableFile(TableFileName(dbname, number), &file));
+	{
+		TableBuilder builder(options, file);
+		for (int i = 0; i < kNum; i++)
+		{
+			builder.Add(InternalKey(Key(i), i + 1, kTypeValue).Encode(), Value(i));
+		}
+		CheckOk(builder.Finish());
+	}
+	CheckOk(file->Close());
+	delete file;
+	uint64_t file_size;
+	CheckOk(env->GetFileSize(TableFileName(dbname, number), &file_size));
+	VersionEdit edit;
+	edit.AddFile(0, number, file_size,
+		InternalKey(Key(0), 1, kTypeValue), InternalKey(Key(kNum - 1), kNum, kTypeValue), 0);
+	versions->SetLastSequence(kNum);
+	CheckOk(versions->LogAndApply(&edit, &mu));
+
+	Version* v = versions->current();
+	v->Ref();
+	mu.Unlock();
+	std::string result;
+	for (int i = 0; i < kNum; i += 37)
+	{
+		VersionGet(v, Key(i), kNum, &result);
+		LEVELDB_CHECK(result == Value(i));
+		const int allocated = VersionGet(v, Key(i), kNum, &result);
+		LEVELDB_CHECK(allocated == 0);
+		LEVELDB_CHECK(result == Value(i));
+	}
+	mu.Lock();
+	v->Unref();
+	mu.Unlock();
+
+	delete versions;
+	delete table_cache;
+	delete user_options.block_cache;
+}
+
+int main(int argc, char** argv)
+{
+	TestMemTable();
+	TestTable(false);
+	TestTable(true);
+	fprintf(stderr, "PASS\n");
+	return 0;
+}
@@ -0,0 +1,186 @@
+#include <new>
+#include "db/dbformat.h"
+#include "db/memtablerep_util.h"
+#include "leveldb/memtablerep.h"
+#include "leveldb/slice_transform.h"
+#include "port/port.h"
+#include "util/arena.h"
+#include "util/hash.h"
+
+namespace leveldb{
+
+	namespace{
+
+		//Entries are hashed by the prefix of their user key into a fixed
+		//array of buckets, each a singly linked list kept sorted by the
+		//KeyComparator. Since all entries for a user key share a bucket, a
+		//point lookup only walks one (short) list.
+		class HashLinkListRep :public MemTableRep{
+		public:
+			HashLinkListRep(const MemTableRep::KeyComparator& compare, Arena* arena,
+				const SliceTransform* transform, size_t bucket_count);
+
+			virtual void Insert(const char* entry);
+			virtual bool Contains(const char* key) const;
+			virtual size_t ApproximateMemoryUsage(){
+				//All memory is allocated through the arena.
+				return 0;
+			}
+			virtual void Get(const LookupKey& k, void* callback_args,
+				bool(*callback_func)(void* arg, const char* entry));
+			virtual MemTableRep::Iterator* GetIterator();
+
+		private:
+			struct Node{
+				explicit Node(const char* k) :key(k){ }
+
+				const char* const key;
+
+				//Use an 'acquire load' so that we observe a fully initialized
+				//version of the returned Node.
+				Node* Next(){ return reinterpret_cast<Node*>(next_.Acquire_Load()); }
+
+				//Use a 'release store' so that anybody who reads through this
+				//pointer observes a fully initialized version of the inserted node.
+				void SetNext(Node* x){ next_.Release_Store(x); }
+				void NoBarrier_SetNext(Node* x){ next_.NoBarrier_Store(x); }
+
+			private:
+				port::AtomicPointer next_;
+			};
+
+			port::AtomicPointer* GetBucket(const Slice& user_key) const {
+				Slice k = BucketKey(transform_, user_key);
+				return &buckets_[Hash(k.data(), k.size(), 0) % bucket_count_];
+			}
+
+			static Node* Head(const port::AtomicPointer* bucket){
+				return reinterpret_cast<Node*>(bucket->Acquire_Load());
+			}
+
+			//Return the first node of "bucket" at or after "key".
+			Node* FindGreaterOrEqual(const port::AtomicPointer* bucket, const char* key) const;
+
+			const MemTableRep::KeyComparator& compare_;
+			const SliceTransform* const transform_;
+			const size_t bucket_count_;
+			port::AtomicPointer* const buckets_;	//Allocated from the arena
+		};
+
+		HashLinkListRep::HashLinkListRep(const MemTableRep::KeyComparator& compare,
+			Arena* arena, const SliceTransform* transform, size_t bucket_count)
+			:MemTableRep(arena),
+			compare_(compare),
+			transform_(transform),
+			bucket_count_(bucket_count > 0 ? bucket_count : 1),
+			buckets_(reinterpret_cast<port::AtomicPointer*>(
+				arena->AllocateAligned(sizeof(port::AtomicPointer) * bucket_count_)))
+		{
+			for (size_t i = 0; i < bucket_count_; i++)
+			{
+				new (&buckets_[i]) port::AtomicPointer(NULL);
+			}
+		}
+
+		HashLinkListRep::Node* HashLinkListRep::FindGreaterOrEqual(
+			const port::AtomicPointer* bucket, const char* key) const
+		{
+			Node* x = Head(bucket);
+			while (x != NULL && compare_(x->key, key) < 0)
+			{
+				x = x->Next();
+			}
+			return x;
+		}
+
+		void HashLinkListRep::Insert(const char* entry)
+		{
+			port::AtomicPointer* bucket = GetBucket(EntryUserKey(entry));
+			Node* prev = NULL;
+			Node* x = Head(bucket);
+			while (x != NULL && compare_(x->key, entry) < 0)
+			{
+				prev = x;
+				x = x->Next();
+			}
+
+			//Our data structure does not allow duplicate insertion
+			assert(x == NULL || compare_(x->key, entry) != 0);
+
+			Node* node = new (arena_->AllocateAligned(sizeof(Node))) Node(entry);
+			//NoBarrier_SetNext() suffices since we will add a barrier when
+			//we publish a pointer to "node".
+			node->NoBarrier_SetNext(x);
+			if (prev == NULL)
+			{
+				bucket->Release_Store(node);
+			}
+			else
+			{
+				prev->SetNext(node);
+			}
+		}
+
+		bool HashLinkListRep::Contains(const char* key) const
+		{
+			Node* x = FindGreaterOrEqual(GetBucket(EntryUserKey(key)), key);
+			return x != NULL && compare_(x->key, key) == 0;
+		}
+
+		void HashLinkListRep::Get(const LookupKey& k, void* callback_args,
+			bool(*callback_func)(void* arg, const char* entry))
+		{
+			const char* target = k.memtable_key().data();
+			for (Node* x = FindGreaterOrEqual(GetBucket(k.user_key()), target);
+				x != NULL && (*callback_func)(callback_args, x->key);
+				x = x->Next())
+			{
+			}
+		}
+
+		MemTableRep::Iterator* HashLinkListRep::GetIterator()
+		{
+			//Sort on demand: each bucket is ordered, but the buckets are not
+			//ordered with respect to each other.
+			std::vector<const char*> entries;
+			for (size_t i = 0; i < bucket_count_; i++)
+			{
+				for (Node* x = Head(&buckets_[i]); x != NULL; x = x->Next())
+				{
+					entries.push_back(x->key);
+				}
+			}
+			std::sort(entries.begin(), entries.end(), EntryLess(compare_));
+			return new SortedEntriesIterator(&entries, compare_, true);
+		}
+
+		class HashLinkListRepFactory :public MemTableRepFactory{
+		public:
+			HashLinkListRepFactory(const SliceTransform* transform, size_t bucket_count)
+				:transform_(transform),
+				bucket_count_(bucket_count)
+			{
+
+			}
+
+			virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp,
+				Arena* arena){
+				return new HashLinkListRep(cmp, arena, transform_, bucket_count_);
+			}
+
+			virtual const char* Name() const { return "HashLinkListRepFactory"; }
+
+		private:
+			const SliceTransform* const transform_;
+			const size_t bucket_count_;
+		};
+
+	}
+
+	MemTableRepFactory* NewHashLinkListRepFactory(const SliceTransform* transform,
+		size_t bucket_count)
+	{
+		return new HashLinkListRepFactory(transform, bucket_count);
+	}
+
+}
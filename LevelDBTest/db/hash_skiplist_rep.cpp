@@ -0,0 +1,160 @@
+#include <new>
+#include "db/dbformat.h"
+#include "db/memtablerep_util.h"
+#include "db/skiplist.h"
+#include "leveldb/memtablerep.h"
+#include "leveldb/slice_transform.h"
+#include "port/port.h"
+#include "util/arena.h"
+#include "util/hash.h"
+
+namespace leveldb{
+
+	namespace{
+
+		//Entries are hashed by the prefix of their user key into a fixed
+		//array of buckets, each a skiplist created on first use. Lookups
+		//only search the skiplist of their prefix, which stays shallow
+		//even when the memtable holds many prefixes.
+		class HashSkipListRep :public MemTableRep{
+		private:
+			typedef SkipList<const char*, const MemTableRep::KeyComparator&> Bucket;
+
+		public:
+			HashSkipListRep(const MemTableRep::KeyComparator& compare, Arena* arena,
+				const SliceTransform* transform, size_t bucket_count, bool inline_key_prefix);
+
+			virtual void Insert(const char* entry);
+			virtual bool Contains(const char* key) const;
+			virtual size_t ApproximateMemoryUsage(){
+				//All memory is allocated through the arena.
+				return 0;
+			}
+			virtual void Get(const LookupKey& k, void* callback_args,
+				bool(*callback_func)(void* arg, const char* entry));
+			virtual MemTableRep::Iterator* GetIterator();
+
+		private:
+			port::AtomicPointer* GetSlot(const Slice& user_key) const {
+				Slice k = BucketKey(transform_, user_key);
+				return &buckets_[Hash(k.data(), k.size(), 0) % bucket_count_];
+			}
+
+			static Bucket* GetBucket(const port::AtomicPointer* slot){
+				return reinterpret_cast<Bucket*>(slot->Acquire_Load());
+			}
+
+			const MemTableRep::KeyComparator& compare_;
+			const SliceTransform* const transform_;
+			const Bucket::KeyPrefixFunction key_prefix_;	//For new buckets
+			const size_t bucket_count_;
+			port::AtomicPointer* const buckets_;	//Allocated from the arena
+		};
+
+		HashSkipListRep::HashSkipListRep(const MemTableRep::KeyComparator& compare,
+			Arena* arena, const SliceTransform* transform, size_t bucket_count,
+			bool inline_key_prefix)
+			:MemTableRep(arena),
+			compare_(compare),
+			transform_(transform),
+			key_prefix_((inline_key_prefix && compare.HasOrderedKeyPrefix()) ? &EntryKeyPrefix : NULL),
+			bucket_count_(bucket_count > 0 ? bucket_count : 1),
+			buckets_(reinterpret_cast<port::AtomicPointer*>(
+				arena->AllocateAligned(sizeof(port::AtomicPointer) * bucket_count_)))
+		{
+			for (size_t i = 0; i < bucket_count_; i++)
+			{
+				new (&buckets_[i]) port::AtomicPointer(NULL);
+			}
+		}
+
+		void HashSkipListRep::Insert(const char* entry)
+		{
+			port::AtomicPointer* slot = GetSlot(EntryUserKey(entry));
+			Bucket* bucket = GetBucket(slot);
+			if (bucket == NULL)
+			{
+				//Publish the bucket only once it is fully constructed.
+				bucket = new (arena_->AllocateAligned(sizeof(Bucket))) Bucket(compare_, arena_, key_prefix_);
+				slot->Release_Store(bucket);
+			}
+			bucket->Insert(entry);
+		}
+
+		bool HashSkipListRep::Contains(const char* key) const
+		{
+			Bucket* bucket = GetBucket(GetSlot(EntryUserKey(key)));
+			return bucket != NULL && bucket->Contains(key);
+		}
+
+		void HashSkipListRep::Get(const LookupKey& k, void* callback_args,
+			bool(*callback_func)(void* arg, const char* entry))
+		{
+			Bucket* bucket = GetBucket(GetSlot(k.user_key()));
+			if (bucket == NULL)
+			{
+				return;
+			}
+			Bucket::Iterator iter(bucket);
+			for (iter.Seek(k.memtable_key().data());
+				iter.Valid() && (*callback_func)(callback_args, iter.key());
+				iter.Next())
+			{
+			}
+		}
+
+		MemTableRep::Iterator* HashSkipListRep::GetIterator()
+		{
+			//Sort on demand: each bucket is ordered, but the buckets are not
+			//ordered with respect to each other.
+			std::vector<const char*> entries;
+			for (size_t i = 0; i < bucket_count_; i++)
+			{
+				Bucket* bucket = GetBucket(&buckets_[i]);
+				if (bucket != NULL)
+				{
+					Bucket::Iterator iter(bucket);
+					for (iter.SeekToFirst(); iter.Valid(); iter.Next())
+					{
+						entries.push_back(iter.key());
+					}
+				}
+			}
+			std::sort(entries.begin(), entries.end(), EntryLess(compare_));
+			return new SortedEntriesIterator(&entries, compare_, true);
+		}
+
+		class HashSkipListRepFactory :public MemTableRepFactory{
+		public:
+			HashSkipListRepFactory(const SliceTransform* transform, size_t bucket_count,
+				bool inline_key_prefix)
+				:transform_(transform),
+				bucket_count_(bucket_count),
+				inline_key_prefix_(inline_key_prefix)
+			{
+
+			}
+
+			virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp,
+				Arena* arena){
+				return new HashSkipListRep(cmp, arena, transform_, bucket_count_,
+					inline_key_prefix_);
+			}
+
+			virtual const char* Name() const { return "HashSkipListRepFactory"; }
+
+		private:
+			const SliceTransform* const transform_;
+			const size_t bucket_count_;
+			const bool inline_key_prefix_;
+		};
+
+	}
+
+	MemTableRepFactory* NewHashSkipListRepFactory(const SliceTransform* transform,
+		size_t bucket_count, bool inline_key_prefix)
+	{
+		return new HashSkipListRepFactory(transform, bucket_count, inline_key_prefix);
+	}
+
+}
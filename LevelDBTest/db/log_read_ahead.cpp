@@ -0,0 +1,138 @@
+#include "db/log_read_ahead.h"
+
+#include "leveldb/env.h"
+#include "util/mutexlock.h"
+
+namespace leveldb{
+	namespace log{
+
+		//Log recovery progress each time this many more bytes have been read.
+		static const uint64_t kProgressInterval = 64 << 20;
+
+		ReadAheadReader::ReadAheadReader(Env* env, SequentialFile* file,
+			Reader::Reporter* reporter, bool checksum, size_t max_buffered_bytes,
+			Logger* info_log, uint64_t log_number, uint64_t file_size)
+			:reporter_(reporter),
+			reader_(file, &queueing_reporter_, checksum, 0/*initial_offset*/),
+			max_buffered_bytes_(max_buffered_bytes > 0 ? max_buffered_bytes : 1),
+			info_log_(info_log),
+			log_number_(log_number),
+			file_size_(file_size),
+			cv_(&mu_),
+			buffered_bytes_(0),
+			done_(false),
+			shutting_down_(false),
+			running_(true)
+		{
+			queueing_reporter_.owner = this;
+			env->StartThread(&ReadAheadReader::BGWork, this);
+		}
+
+		ReadAheadReader::~ReadAheadReader()
+		{
+			MutexLock l(&mu_);
+			shutting_down_ = true;
+			cv_.SignalAll();
+			while (running_)
+			{
+				cv_.Wait();
+			}
+		}
+
+		void ReadAheadReader::QueueingReporter::Corruption(size_t bytes,
+			const Status& status)
+		{
+			//Called by reader_ on the background thread, which does not
+			//hold mu_ while reading.
+			MutexLock l(&owner->mu_);
+			owner->entries_.push_back(Entry());
+			owner->entries_.back().dropped_bytes = bytes;
+			owner->entries_.back().status = status;
+			owner->cv_.SignalAll();
+		}
+
+		bool ReadAheadReader::ReadRecord(std::string* record)
+		{
+			MutexLock l(&mu_);
+			while (true)
+			{
+				while (entries_.empty() && !done_)
+				{
+					cv_.Wait();
+				}
+				if (entries_.empty())
+				{
+					return false;
+				}
+				Entry& entry = entries_.front();
+				if (entry.status.ok())
+				{
+					record->swap(entry.record);
+					entries_.pop_front();
+					buffered_bytes_ -= record->size();
+					cv_.SignalAll();
+					return true;
+				}
+
+				//Report without holding mu_, which the reporter knows nothing of
+				const size_t bytes = entry.dropped_bytes;
+				const Status status = entry.status;
+				entries_.pop_front();
+				mu_.Unlock();
+				reporter_->Corruption(bytes, status);
+				mu_.Lock();
+			}
+		}
+
+		void ReadAheadReader::BGWork(void* arg)
+		{
+			reinterpret_cast<ReadAheadReader*>(arg)->Run();
+		}
+
+		void ReadAheadReader::Run()
+		{
+			std::string scratch;
+			Slice record;
+			uint64_t next_progress = kProgressInterval;
+			mu_.Lock();
+			while (!shutting_down_)
+			{
+				//An empty queue always accepts a record, so one larger than
+				//the limit cannot stall the reader.
+				if (buffered_bytes_ >= max_buffered_bytes_ && !entries_.empty())
+				{
+					cv_.Wait();
+					continue;
+				}
+
+				mu_.Unlock();
+				const bool ok = reader_.ReadRecord(&record, &scratch);
+				const uint64_t offset = reader_.LastRecordOffset();
+				if (ok && info_log_ != NULL && offset >= next_progress)
+				{
+					Log(info_log_, "Recovering log #%llu: %llu of %llu MB read",
+						static_cast<unsigned long long>(log_number_),
+						static_cast<unsigned long long>(offset >> 20),
+						static_cast<unsigned long long>(file_size_ >> 20));
+					next_progress = offset + kProgressInterval;
+				}
+				mu_.Lock();
+
+				if (!ok)
+				{
+					done_ = true;
+					break;
+				}
+				entries_.push_back(Entry());
+				entries_.back().record.assign(record.data(), record.size());
+				buffered_bytes_ += record.size();
+				cv_.SignalAll();
+			}
+			done_ = true;
+			running_ = false;
+			cv_.SignalAll();
+			mu_.Unlock();
+		}
+
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <stdint.h>
+#include "db/log_reader.h"
+#include "port/port.h"
+
+namespace leveldb{
+
+	class Env;
+	class Logger;
+
+	namespace log{
+
+		//Reads the records of a log on a background thread, at most
+		//"max_buffered_bytes" of records ahead of the caller, so that
+		//reading and checksumming the file overlaps with applying the
+		//records. Meant for replaying write-ahead logs when a DB is opened,
+		//where the single recovery thread otherwise alternates between
+		//waiting for the file and inserting into the memtable.
+		class ReadAheadReader
+		{
+		public:
+			//Start reading "*file" on a thread from "env". Neither "*file"
+			//nor "*reporter" is owned, and both must outlive the reader.
+			//"*reporter" is invoked from ReadRecord(), on the caller's thread,
+			//in order with the records. If
+			//"info_log" is non-NULL, progress through the "file_size" bytes
+			//of log "log_number" is logged to it.
+			ReadAheadReader(Env* env, SequentialFile* file, Reader::Reporter* reporter,
+				bool checksum, size_t max_buffered_bytes,
+				Logger* info_log, uint64_t log_number, uint64_t file_size);
+
+			//Stops the background thread, waiting for it to exit.
+			~ReadAheadReader();
+
+			//Read the next record into *record. Returns true if read
+			//successfully, false if we hit end of the input. Corruption
+			//found before the record is reported first.
+			bool ReadRecord(std::string* record);
+
+		private:
+			//Queues the reports of reader_ for ReadRecord() to deliver.
+			struct QueueingReporter :public Reader::Reporter
+			{
+				ReadAheadReader* owner;
+				virtual void Corruption(size_t bytes, const Status& status);
+			};
+
+			//A record, or a corruption report if "status" is not OK.
+			struct Entry
+			{
+				std::string record;
+				size_t dropped_bytes;
+				Status status;
+			};
+
+			static void BGWork(void* arg);
+			void Run();
+
+			Reader::Reporter* const reporter_;
+			QueueingReporter queueing_reporter_;
+			Reader reader_;	//Only used by the background thread
+			const size_t max_buffered_bytes_;
+			Logger* const info_log_;
+			const uint64_t log_number_;
+			const uint64_t file_size_;
+
+			port::Mutex mu_;
+			port::CondVar cv_;	//Signalled on new records, consumed records and exit
+			std::deque<Entry> entries_;
+			size_t buffered_bytes_;	//Bytes of the records in entries_
+			bool done_;	//The background thread reached the end of the log
+			bool shutting_down_;
+			bool running_;	//The background thread has not exited yet
+
+			//No copying allowed
+			ReadAheadReader(const ReadAheadReader&);
+			void operator=(const ReadAheadReader&);
+		};
+	}
+}
@@ -1,10 +1,16 @@
 
 #include "memtable.h"
 #include "db/dbformat.h"
+#include "db/merge_context.h"
+#include "db/range_del.h"
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
+#include "leveldb/slice_transform.h"
 #include "util/coding.h"
+#include "util/dynamic_bloom.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
 
 namespace leveldb{
 
@@ -15,31 +21,128 @@ namespace leveldb{
 		return Slice(p, len);
 	}
 
-	MemTable::MemTable(const InternalKeyComparator& comparator)
+	class MemTableIterator :public Iterator{
+
+	public:
+		//Takes ownership of "iter". "mem" is the memtable whose values
+		//value() copies under its in-place update locks, or NULL if its
+		//values are never overwritten.
+		MemTableIterator(MemTableRep::Iterator* iter, const MemTable* mem)
+			:iter_(iter), mem_(mem){ }
+		virtual ~MemTableIterator(){ delete iter_; }
+
+		virtual bool Valid() const { return iter_->Valid(); }
+		virtual void Seek(const Slice& k){ iter_->Seek(seek_key_.Encode(k)); }
+		virtual void SeekToFirst(){ iter_->SeekToFirst(); }
+		virtual void SeekToLast(){ iter_->SeekToLast(); }
+		virtual void Next(){ iter_->Next(); }
+		virtual void Prev(){ iter_->Prev(); }
+		virtual Slice key() const { return GetLengthPrefixedSlice(iter_->key()); }
+		virtual Slice value() const{
+			Slice key_slice = GetLengthPrefixedSlice(iter_->key());
+			if (mem_ == NULL)
+			{
+				return GetLengthPrefixedSlice(key_slice.data() + key_slice.size());
+			}
+			//Update() may overwrite the value in place: copy it, length
+			//included, under the lock.
+			MutexLock l(mem_->GetLock(ExtractUserKey(key_slice)));
+			Slice v = GetLengthPrefixedSlice(key_slice.data() + key_slice.size());
+			value_.assign(v.data(), v.size());
+			return value_;
+		}
+
+		virtual Status status() const { return Status::OK(); }
+
+	private:
+		MemTableRep::Iterator* iter_;
+		const MemTable* const mem_;
+		MemTableKeyBuffer seek_key_;	//Encoded target of the last Seek()
+		mutable std::string value_;	//Copy returned by value() if mem_ != NULL
+
+		//No copying allowed
+		MemTableIterator(const MemTableIterator&);
+		void operator=(const MemTableIterator&);
+	};
+
+	//The representation used when Options::memtable_factory is NULL, and
+	//always for range tombstones, which are scanned in order. Created at
+	//load time rather than on first use, since VS2013 does not initialize
+	//function-local statics thread-safely; hence no MemTable may be
+	//constructed during static initialization.
+	static MemTableRepFactory* const default_rep_factory = NewSkipListRepFactory();
+
+	MemTable::MemTable(const InternalKeyComparator& comparator, const Options& options)
 		:comparator_(comparator),
+		merge_operator_(options.merge_operator),
+		max_successive_merges_(options.max_successive_merges),
+		inplace_update_support_(options.inplace_update_support),
+		num_locks_(options.inplace_update_num_locks > 0 ? options.inplace_update_num_locks : 1),
+		locks_(options.inplace_update_support ? new port::Mutex[num_locks_] : NULL),
 		refs_(0),
-		table_(comparator_, &arena_)
+		table_((options.memtable_factory != NULL ? options.memtable_factory :
+			default_rep_factory)->CreateMemTableRep(comparator_, &arena_)),
+		range_del_table_(default_rep_factory->CreateMemTableRep(comparator_, &arena_)),
+		has_range_deletions_(NULL),
+		prefix_extractor_(options.prefix_extractor),
+		bloom_(NULL)
 	{
-
+		if (options.memtable_bloom_size_ratio > 0)
+		{
+			bloom_ = new DynamicBloom(&arena_, static_cast<size_t>(
+				options.write_buffer_size * options.memtable_bloom_size_ratio * 8));
+		}
 	}
 
 	MemTable::~MemTable()
 	{
 		assert(refs_ == 0);
+		delete table_;
+		delete range_del_table_;
+		delete[] locks_;
+		delete bloom_;
+	}
+
+	Slice MemTable::BloomKey(const Slice& internal_key) const
+	{
+		if (prefix_extractor_ != NULL && prefix_extractor_->InDomain(internal_key))
+		{
+			return prefix_extractor_->Transform(internal_key);
+		}
+		return ExtractUserKey(internal_key);
+	}
+
+	port::Mutex* MemTable::GetLock(const Slice& user_key) const
+	{
+		return &locks_[Hash(user_key.data(), user_key.size(), 0) % num_locks_];
 	}
 
 	size_t MemTable::ApproximateMemoryUsage()
 	{
-		return arena_.MemoryUsage();
+		return arena_.MemoryUsage() + table_->ApproximateMemoryUsage() +
+			range_del_table_->ApproximateMemoryUsage();
 	}
 
 	Iterator* MemTable::NewIterator()
 	{
-		return new MemTableIterator(&table_);
+		return new MemTableIterator(table_->GetIterator(),
+			inplace_update_support_ ? this : NULL);
+	}
+
+	Iterator* MemTable::NewRangeTombstoneIterator()
+	{
+		return new MemTableIterator(range_del_table_->GetIterator(), NULL);
 	}
 
 	void MemTable::Add(SequenceNumber seq, ValueType type, const Slice& key, const Slice& value)
 	{
+		std::string folded;
+		if (type == kTypeMerge && FoldMerges(key, value, &folded))
+		{
+			Add(seq, kTypeValue, key, folded);
+			return;
+		}
+
 		//Format of an entry is concatenation of:
 		//key_size	:varint32 of internal_key.size()
 		//key bytes	:char[internal_key.size()]
@@ -60,86 +163,327 @@ namespace leveldb{
 		p = EncodeVarint32(p, val_size);
 		memcpy(p, value.data(), val_size);
 		assert((p + val_size) - buf == encoded_len);
-		table_.Insert(buf);
+		if (type == kTypeRangeDeletion)
+		{
+			range_del_table_->Insert(buf);
+			has_range_deletions_.Release_Store(this);
+		}
+		else
+		{
+			table_->Insert(buf);
+			if (bloom_ != NULL)
+			{
+				bloom_->Add(BloomKey(Slice(buf + VarintLength(internal_key_size),
+					internal_key_size)));
+			}
+		}
 
 	}
 
-	bool MemTable::Get(const LookupKey& key, std::string* value, Status* s)
+	namespace{
+
+		//State of a MemTable::Get() passed through MemTableRep::Get().
+		struct Saver
+		{
+			MemTable* mem;
+			const LookupKey* key;
+			const Comparator* ucmp;
+			PinnableSlice* value;
+			port::Mutex* pin_mutex;	//Pin plain values with this held if non-NULL
+			Status* s;
+			MergeContext* merge_context;
+			SequenceNumber max_covering_tombstone_seq;
+			port::Mutex* lock;	//Held while reading a value if non-NULL
+			bool found;
+		};
+
+		//State of a MemTable::FoldMerges() passed through MemTableRep::Get().
+		struct FoldState
+		{
+			Slice key;
+			const Comparator* ucmp;
+			MergeContext* merge_context;
+			int max_successive_merges;
+			int successive;
+			std::string* result;
+			bool folded;
+		};
+
+	}
+
+	//Releases the reference a pinned value holds on its memtable.
+	static void UnrefPinnedMemTable(void* arg1, void* arg2)
+	{
+		MemTable* mem = reinterpret_cast<MemTable*>(arg1);
+		MutexLock l(reinterpret_cast<port::Mutex*>(arg2));
+		mem->Unref();
+	}
+
+	//Entries for one user key are ordered by decreasing sequence number,
+	//so any merge operands come before the value or deletion they apply to.
+	//Returns false once the lookup is decided or the user key changes.
+	static bool SaveValue(void* arg, const char* entry)
 	{
-		Slice memkey = key.memtable_key();
-		Table::Iterator iter(&table_);
-		iter.Seek(memkey.data());
-		if (iter.Valid())
+		Saver* saver = reinterpret_cast<Saver*>(arg);
+		uint32_t key_length;
+		const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
+		const Slice user_key = saver->key->user_key();
+		if (saver->ucmp->Compare(Slice(key_ptr, key_length - 8), user_key) != 0)
+		{
+			return false;
+		}
+
+		//Correct user key
+		const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+		ValueType type = static_cast<ValueType>(tag&0xff);
+		if ((tag >> 8) < saver->max_covering_tombstone_seq)
 		{
-			const char* entry = iter.key();
-			uint32_t key_length;
-			const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
-			if (comparator_.comparator.user_comparator()->Compare(
-				Slice(key_ptr, key_length-8),
-				key.user_key())==0)
+			//A newer range tombstone covers this entry.
+			type = kTypeDeletion;
+		}
+		switch (type)
+		{
+		case kTypeValue:{
+							std::string copy;
+							Slice v;
+							if (saver->lock != NULL)
+							{
+								//The value may be overwritten in place concurrently.
+								MutexLock l(saver->lock);
+								v = GetLengthPrefixedSlice(key_ptr + key_length);
+								copy.assign(v.data(), v.size());
+								v = copy;
+							}
+							else
+							{
+								v = GetLengthPrefixedSlice(key_ptr + key_length);
+							}
+							if (saver->merge_context->HasOperands())
+							{
+								*saver->s = saver->merge_context->Finish(user_key, &v,
+									saver->value->GetSelf());
+								saver->value->PinSelf();
+							}
+							else if (saver->pin_mutex != NULL && saver->lock == NULL)
+							{
+								{
+									MutexLock l(saver->pin_mutex);
+									saver->mem->Ref();
+								}
+								saver->value->PinSlice(v, &UnrefPinnedMemTable,
+									saver->mem, saver->pin_mutex);
+							}
+							else
+							{
+								saver->value->PinSelf(v);
+							}
+							saver->found = true;
+							return false;
+		}
+		case kTypeDeletion:
+			if (saver->merge_context->HasOperands())
 			{
-				//Correct user key
-				const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
-				switch (static_cast<ValueType>(tag&0xff))
-				{
-				case kTypeValue:{
-									Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
-									value->assign(v.data(), v.size());
-									return true;
-				}
-				case kTypeDeletion:
-					*s = Status::NotFound(Slice());
-					return true;
-				}
+				*saver->s = saver->merge_context->Finish(user_key, NULL,
+					saver->value->GetSelf());
+				saver->value->PinSelf();
 			}
+			else
+			{
+				*saver->s = Status::NotFound(Slice());
+			}
+			saver->found = true;
+			return false;
+		case kTypeMerge:{
+							Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
+							saver->merge_context->PushOlderOperand(user_key, v);
+							return true;
+		}
+		default:
+			return false;
 		}
-		return false;
 	}
 
-	int MemTable::KeyComparator::operator()(const char* a, const char* b) const
+	bool MemTable::Get(const LookupKey& key, PinnableSlice* value, Status* s,
+		MergeContext* merge_context,
+		SequenceNumber* max_covering_tombstone_seq,
+		port::Mutex* pin_mutex)
 	{
-		//Internal keys are encoded as length-prefixed strings.
-		Slice a = GetLengthPrefixedSlice(a);
-		Slice b = GetLengthPrefixedSlice(b);
-		return comparator.Compare(a, b);
+		if (HasRangeDeletions())
+		{
+			Iterator* tombstones = NewRangeTombstoneIterator();
+			SequenceNumber covering = MaxCoveringTombstoneSeq(tombstones,
+				comparator_.comparator.user_comparator(),
+				key.user_key(), key.sequence());
+			delete tombstones;
+			if (covering > *max_covering_tombstone_seq)
+			{
+				*max_covering_tombstone_seq = covering;
+			}
+		}
+
+		if (bloom_ != NULL && !bloom_->MayContain(BloomKey(key.internal_key())))
+		{
+			//Range tombstones were applied above; nothing else here can
+			//affect this key.
+			return false;
+		}
+
+		Saver saver;
+		saver.mem = this;
+		saver.key = &key;
+		saver.ucmp = comparator_.comparator.user_comparator();
+		saver.value = value;
+		saver.pin_mutex = pin_mutex;
+		saver.s = s;
+		saver.merge_context = merge_context;
+		saver.max_covering_tombstone_seq = *max_covering_tombstone_seq;
+		saver.lock = inplace_update_support_ ? GetLock(key.user_key()) : NULL;
+		saver.found = false;
+		table_->Get(key, &saver, SaveValue);
+		return saver.found;
 	}
 
-	//Encode a suitable internal key target for "target" and return it.
-	static const char* EncodeKey(std::string* scratch, const Slice& target){
-		scratch->clear();
-		PutVarint32(scratch, target.size());
-		scratch->append(target.data(), target.size());
-		return scratch->data();
+	namespace{
+
+		//Finds the newest entry for a user key through MemTableRep::Get().
+		struct NewestEntry
+		{
+			Slice key;
+			const Comparator* ucmp;
+			const char* entry;	//NULL if the key has no entry
+		};
+
 	}
 
-	class MemTableIterator :public Iterator{
+	static bool SaveNewestEntry(void* arg, const char* entry)
+	{
+		NewestEntry* newest = reinterpret_cast<NewestEntry*>(arg);
+		uint32_t key_length;
+		const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
+		if (newest->ucmp->Compare(Slice(key_ptr, key_length - 8), newest->key) == 0)
+		{
+			newest->entry = entry;
+		}
+		return false;
+	}
 
-	public:
-		explicit MemTableIterator(MemTable::Table* table) :iter_(table){ }
-
-		virtual bool Valid() const { return iter_.Valid(); }
-		virtual void Seek(const Slice& k){ iter_.Seek(EncodeKey(&tmp_, k)); }
-		virtual void SeekToFirst(){ iter_.SeekToFirst(); }
-		virtual void SeekToLast(){ iter_.SeekToLast(); }
-		virtual void Next(){ iter_.Next(); }
-		virtual void Prev(){ iter_.Prev(); }
-		virtual Slice key() const { return GetLengthPrefixedSlice(iter_.key()); }	
-		virtual Slice value() const{
-			Slice key_slice = GetLengthPrefixedSlice(iter_.key());
-			return GetLengthPrefixedSlice(key_slice.data() + key_slice.size());
+	bool MemTable::Update(const Slice& key, const Slice& value)
+	{
+		assert(inplace_update_support_);
+		if (HasRangeDeletions())
+		{
+			//A tombstone newer than the entry would still cover the value
+			//written under the entry's old sequence number.
+			return false;
 		}
 
-		virtual Status status() const { return Status::OK(); }
+		LookupKey lkey(key, kMaxSequenceNumber);
+		NewestEntry newest;
+		newest.key = key;
+		newest.ucmp = comparator_.comparator.user_comparator();
+		newest.entry = NULL;
+		table_->Get(lkey, &newest, SaveNewestEntry);
+		if (newest.entry == NULL)
+		{
+			return false;
+		}
 
-	private:
-		MemTable::Table::Iterator iter_;
-		std::string tmp_;	//For passing to EncodeKey
+		uint32_t key_length;
+		const char* key_ptr = GetVarint32Ptr(newest.entry, newest.entry + 5, &key_length);
+		const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+		if (static_cast<ValueType>(tag & 0xff) != kTypeValue)
+		{
+			return false;
+		}
 
-		//No copying allowed
-		MemTableIterator(const MemTableIterator&);
-		void operator=(const MemTableIterator&);
-	};
+		//Only this (writer) thread modifies entries, so the old value can
+		//be read without the lock.
+		const Slice prev_value = GetLengthPrefixedSlice(key_ptr + key_length);
+		if (value.size() > prev_value.size())
+		{
+			return false;
+		}
 
-}
+		//A smaller value also has a varint length no longer than the old
+		//one, so the new length and value fit in the old space.
+		MutexLock l(GetLock(key));
+		char* p = EncodeVarint32(const_cast<char*>(key_ptr) + key_length, value.size());
+		memcpy(p, value.data(), value.size());
+		return true;
+	}
+
+	static bool FoldEntry(void* arg, const char* entry)
+	{
+		FoldState* state = reinterpret_cast<FoldState*>(arg);
+		uint32_t key_length;
+		const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
+		if (state->ucmp->Compare(Slice(key_ptr, key_length - 8), state->key) != 0)
+		{
+			return false;
+		}
+
+		const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+		Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
+		switch (static_cast<ValueType>(tag & 0xff))
+		{
+		case kTypeMerge:
+			//Runs only grow past the limit when the base value is older
+			//than this memtable, in which case there is nothing to fold.
+			if (++state->successive > state->max_successive_merges)
+			{
+				return false;
+			}
+			state->merge_context->PushOlderOperand(state->key, v);
+			return true;
+		case kTypeValue:
+			state->folded = state->successive >= state->max_successive_merges &&
+				state->merge_context->Finish(state->key, &v, state->result).ok();
+			return false;
+		case kTypeDeletion:
+			state->folded = state->successive >= state->max_successive_merges &&
+				state->merge_context->Finish(state->key, NULL, state->result).ok();
+			return false;
+		default:
+			return false;
+		}
+	}
+
+	bool MemTable::FoldMerges(const Slice& key, const Slice& operand, std::string* result)
+	{
+		if (merge_operator_ == NULL || max_successive_merges_ <= 0 ||
+			HasRangeDeletions())
+		{
+			//Nothing to fold with, or folding would have to apply range
+			//tombstones as well; leave the operands to be merged on read.
+			return false;
+		}
 
+		LookupKey lkey(key, kMaxSequenceNumber);
+		MergeContext merge_context(merge_operator_);
+		merge_context.PushOlderOperand(key, operand);
+		FoldState state;
+		state.key = key;
+		state.ucmp = comparator_.comparator.user_comparator();
+		state.merge_context = &merge_context;
+		state.max_successive_merges = max_successive_merges_;
+		state.successive = 0;
+		state.result = result;
+		state.folded = false;
+		table_->Get(lkey, &state, FoldEntry);
+		return state.folded;
+	}
 
+	int MemTable::KeyComparator::operator()(const char* aptr, const char* bptr) const
+	{
+		//Internal keys are encoded as length-prefixed strings.
+		Slice a = GetLengthPrefixedSlice(aptr);
+		Slice b = GetLengthPrefixedSlice(bptr);
+		return comparator.Compare(a, b);
+	}
+
+	bool MemTable::KeyComparator::HasOrderedKeyPrefix() const
+	{
+		return comparator.user_comparator() == BytewiseComparator();
+	}
+
+}
@@ -1,20 +1,30 @@
+#pragma once
 #include <string>
 #include "leveldb/db.h"
 #include "db/dbformat.h"
-#include "db/skiplist.h"
+#include "leveldb/memtablerep.h"
+#include "leveldb/pinnable_slice.h"
+#include "port/port.h"
 #include "util/arena.h"
 
 namespace leveldb{
 
+	class DynamicBloom;
 	class InternalKeyComparator;
+	class MergeContext;
+	class MergeOperator;
 	class Mutex;
+	class SliceTransform;
 	class MemTableIterator;
 
 	class MemTable{
 	public:
 		//MemTables are reference counted. The initial reference count
 		//is zero and the caller must call Ref() at least once.
-		explicit MemTable(const InternalKeyComparator& comparator);
+		//"options" are the DB's: options.prefix_extractor, if set, applies
+		//to internal keys, as the DB wraps the user's extractor in an
+		//InternalKeySliceTransform.
+		MemTable(const InternalKeyComparator& comparator, const Options& options);
 		
 		//Increase reference count.
 		void Ref(){ ++refs_; }
@@ -22,48 +32,118 @@ namespace leveldb{
 		//Drop reference count. Delete if no more references exist.
 		void Unref(){
 			--refs_;
-			assert(refs_ <= 0);
+			assert(refs_ >= 0);
 			if (refs_ <= 0)
 			{
 				delete this;
 			}
 		}
 
+		//Called once the memtable has been made immutable, before it is
+		//read for a flush. No Add() may follow.
+		void MarkImmutable(){ table_->MarkReadOnly(); }
+
 		//Returns an estimate of the number of bytes of data in use by this
 		//data structure.
 		size_t ApproximateMemoryUsage();
 
 		//Return an iterator that yields the contents of the memtable.
+		//Range tombstones are not included; see NewRangeTombstoneIterator().
+		//With inplace_update_support, value() returns a copy taken under
+		//the key's lock, valid until the iterator is next used.
 		Iterator* NewIterator();
 
+		//Return an iterator over the range tombstones added to this memtable,
+		//keyed by the internal key of each range's begin key with the
+		//exclusive end user key as value.
+		Iterator* NewRangeTombstoneIterator();
+
 		//Add an entry into memtable that maps key to value at the
 		//specified sequence number and with the specified type.
+		//For kTypeRangeDeletion, "key" is the begin and "value" the exclusive
+		//end of the deleted range.
 		void Add(SequenceNumber seq, ValueType type,
 			const Slice& key,
 			const Slice& value);
 
 		//If memtable contains a value for key, store it in *value and return true.
-		bool Get(const LookupKey& key, std::string* value, Status* s);
+		//If "pin_mutex" is non-NULL a plain value is not copied: *value
+		//refers into the memtable, which stays referenced until *value is
+		//reset. The reference is taken and dropped with *pin_mutex (the DB
+		//mutex) held, which the caller must not hold. Otherwise, or if the
+		//value had to be merged or may be updated in place, it is copied.
+		//If memtable contains a deletion for key, store a NotFound() error
+		//in *status and return true.
+		//Merge operands found on top of the newest value or deletion are
+		//pushed into *merge_context and folded before returning true. If only
+		//merge operands are found, returns false so that the caller keeps
+		//looking for a base value in older data with the same *merge_context.
+		//Entries older than *max_covering_tombstone_seq are treated as
+		//deleted; on return it is raised to the newest visible range
+		//tombstone in this memtable covering key, so that the caller applies
+		//it to older data as well.
+		//Else, return false.
+		bool Get(const LookupKey& key, PinnableSlice* value, Status* s,
+			MergeContext* merge_context,
+			SequenceNumber* max_covering_tombstone_seq,
+			port::Mutex* pin_mutex);
+
+		//If the newest entry for key is a value at least as large as "value",
+		//overwrite it in place and return true. Else return false, and the
+		//caller should Add() the value as usual. The overwritten entry keeps
+		//its sequence number, so nothing is updated in place once the
+		//memtable holds a range tombstone, which may be newer than the entry
+		//and would go on hiding the new value.
+		//REQUIRES: Options::inplace_update_support, and no snapshot or
+		//iterator needs the previous value.
+		bool Update(const Slice& key, const Slice& value);
 
 	private:
 		~MemTable(); //Private since only Unref() should be used to delete it
 
-		struct KeyComparator 
+		struct KeyComparator :public MemTableRep::KeyComparator
 		{
 			const InternalKeyComparator comparator;
-			explicit KeyComparator(const InternalKeyComparator* c) :comparator(c){ }
-			int operator()(const char* a, const char* b) const;
+			explicit KeyComparator(const InternalKeyComparator& c) :comparator(c){ }
+			virtual int operator()(const char* a, const char* b) const;
+			virtual bool HasOrderedKeyPrefix() const;
 		};
 
 		friend class MemTableIterator;
 		friend class MemTableBackwardIterator;
 
-		typedef SkipList<const char*, KeyComparator> Table;
+		//If "operand" completes a run of Options::max_successive_merges
+		//operands on top of a base value held in this memtable, store the
+		//folded value in *result and return true.
+		bool FoldMerges(const Slice& key, const Slice& operand, std::string* result);
+
+		//Return the lock protecting in-place updates of the values of
+		//"user_key".
+		//REQUIRES: inplace_update_support_
+		port::Mutex* GetLock(const Slice& user_key) const;
+
+		//Return the part of "internal_key" indexed by bloom_: its prefix,
+		//or its user key if it is outside the prefix extractor's domain.
+		Slice BloomKey(const Slice& internal_key) const;
+
+		//Returns true iff any range tombstone has been added.
+		bool HasRangeDeletions() const {
+			return has_range_deletions_.Acquire_Load() != NULL;
+		}
 
 		KeyComparator comparator_;
+		const MergeOperator* const merge_operator_;
+		const int max_successive_merges_;
+		const bool inplace_update_support_;
+		const size_t num_locks_;
+		port::Mutex* const locks_;	//Striped over user keys; NULL unless inplace_update_support_
 		int refs_;
 		Arena arena_;
-		Table table_;
+		MemTableRep* table_;
+		MemTableRep* range_del_table_;	//Range tombstones, kept apart from point entries
+		port::AtomicPointer has_range_deletions_;	//Non-NULL once range_del_table_ is non-empty
+		const SliceTransform* const prefix_extractor_;	//Applies to internal keys
+		DynamicBloom* bloom_;	//Keys (or prefixes) added; NULL if disabled
 
 		//No copying allowed
 		MemTable(const MemTable&);
@@ -0,0 +1,119 @@
+#include "db/memtable_list.h"
+
+#include <assert.h>
+#include <algorithm>
+#include "db/memtable.h"
+
+namespace leveldb{
+
+	MemTableList::MemTableList(int min_to_merge)
+		:min_to_merge_(min_to_merge > 0 ? min_to_merge : 1)
+	{
+
+	}
+
+	MemTableList::~MemTableList()
+	{
+		for (size_t i = 0; i < memlist_.size(); i++)
+		{
+			memlist_[i]->Unref();
+		}
+	}
+
+	void MemTableList::Add(MemTable* m)
+	{
+		m->Ref();
+		m->MarkImmutable();
+		memlist_.push_front(m);
+	}
+
+	bool MemTableList::IsFlushPending() const
+	{
+		return flushing_.empty() && static_cast<int>(memlist_.size()) >= min_to_merge_;
+	}
+
+	void MemTableList::PickMemtablesToFlush(std::vector<MemTable*>* mems)
+	{
+		mems->clear();
+		if (!flushing_.empty())
+		{
+			//The running flush holds the oldest memtables; anything picked
+			//now would be newer and could be installed before them.
+			return;
+		}
+		for (std::deque<MemTable*>::const_reverse_iterator it = memlist_.rbegin();
+			it != memlist_.rend(); ++it)
+		{
+			flushing_.insert(*it);
+			mems->push_back(*it);
+		}
+	}
+
+	void MemTableList::RollbackFlush(const std::vector<MemTable*>& mems)
+	{
+		for (size_t i = 0; i < mems.size(); i++)
+		{
+			flushing_.erase(mems[i]);
+		}
+	}
+
+	void MemTableList::RemoveFlushed(const std::vector<MemTable*>& mems)
+	{
+		for (size_t i = 0; i < mems.size(); i++)
+		{
+			MemTable* m = mems[i];
+			assert(flushing_.count(m) == 1);
+			flushing_.erase(m);
+			memlist_.erase(std::find(memlist_.begin(), memlist_.end(), m));
+			m->Unref();
+		}
+	}
+
+	void MemTableList::GetReferenced(std::vector<MemTable*>* mems) const
+	{
+		mems->clear();
+		for (size_t i = 0; i < memlist_.size(); i++)
+		{
+			memlist_[i]->Ref();
+			mems->push_back(memlist_[i]);
+		}
+	}
+
+	void MemTableList::AddIterators(std::vector<Iterator*>* iters) const
+	{
+		for (size_t i = 0; i < memlist_.size(); i++)
+		{
+			iters->push_back(memlist_[i]->NewIterator());
+		}
+	}
+
+	size_t MemTableList::ApproximateMemoryUsage() const
+	{
+		size_t total = 0;
+		for (size_t i = 0; i < memlist_.size(); i++)
+		{
+			total += memlist_[i]->ApproximateMemoryUsage();
+		}
+		return total;
+	}
+
+	extern bool GetFromMemTables(const std::vector<MemTable*>& mems,
+		const LookupKey& key,
+		PinnableSlice* value,
+		Status* s,
+		MergeContext* merge_context,
+		SequenceNumber* max_covering_tombstone_seq,
+		port::Mutex* pin_mutex)
+	{
+		for (size_t i = 0; i < mems.size(); i++)
+		{
+			if (mems[i]->Get(key, value, s, merge_context, max_covering_tombstone_seq,
+				pin_mutex))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+}
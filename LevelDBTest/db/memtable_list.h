@@ -0,0 +1,91 @@
+#pragma once
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+#include "db/dbformat.h"
+#include "port/port.h"
+
+namespace leveldb{
+
+	class Iterator;
+	class MemTable;
+	class MergeContext;
+	class PinnableSlice;
+
+	//The immutable memtables waiting to be flushed to level-0. Rather than
+	//a single immutable memtable, which stalls writers as soon as the next
+	//one fills, up to Options::max_write_buffer_number - 1 memtables may
+	//wait here while the disk catches up. Reads consult all of them,
+	//newest first.
+	//
+	//One flush runs at a time. Level-0 files are ordered by file number,
+	//so a table built from newer memtables must never get a smaller number
+	//than one built from older memtables. If a newer flush could finish
+	//while an older one was still running, and the older one then failed
+	//and was retried, its table would get the larger number and shadow
+	//the newer data.
+	//
+	//All methods require external synchronization (the DB mutex).
+	class MemTableList{
+	public:
+		//A flush is pending once "min_to_merge" memtables are waiting.
+		explicit MemTableList(int min_to_merge);
+		~MemTableList();
+
+		//Return the number of immutable memtables, including those being flushed.
+		int size() const { return static_cast<int>(memlist_.size()); }
+
+		//Add a memtable that has just been made immutable and mark it so.
+		//The list takes its own reference.
+		void Add(MemTable* m);
+
+		//Returns true iff no flush is in progress and at least
+		//min_to_merge memtables are waiting.
+		bool IsFlushPending() const;
+
+		//Store in *mems, oldest first, every memtable and mark them in
+		//progress. They are meant to be merged into a single level-0 table.
+		//Memtables added while that flush runs wait for it to be installed
+		//or rolled back. Stores nothing if a flush is already in progress.
+		void PickMemtablesToFlush(std::vector<MemTable*>* mems);
+
+		//The flush of "mems" failed: make them eligible for PickMemtablesToFlush() again.
+		void RollbackFlush(const std::vector<MemTable*>& mems);
+
+		//The table built from "mems" has been installed: drop them from the list.
+		void RemoveFlushed(const std::vector<MemTable*>& mems);
+
+		//Store in *mems the memtables, newest first, each with an added
+		//reference so that they may be read after the mutex is released.
+		//The caller must Unref() each of them.
+		void GetReferenced(std::vector<MemTable*>* mems) const;
+
+		//Append to *iters an iterator over each memtable.
+		void AddIterators(std::vector<Iterator*>* iters) const;
+
+		//Returns the combined memory usage of all memtables in the list.
+		size_t ApproximateMemoryUsage() const;
+
+	private:
+		const int min_to_merge_;
+		std::deque<MemTable*> memlist_;	//Newest first
+		std::set<MemTable*> flushing_;	//Members of memlist_ being flushed
+
+		//No copying allowed
+		MemTableList(const MemTableList&);
+		void operator=(const MemTableList&);
+	};
+
+	//Look up "key" in "mems", ordered newest first, with the same contract
+	//as MemTable::Get(): returns true once the lookup is decided, false if
+	//older data must be consulted with the same *merge_context and
+	//*max_covering_tombstone_seq.
+	extern bool GetFromMemTables(const std::vector<MemTable*>& mems,
+		const LookupKey& key,
+		PinnableSlice* value,
+		Status* s,
+		MergeContext* merge_context,
+		SequenceNumber* max_covering_tombstone_seq,
+		port::Mutex* pin_mutex);
+}
@@ -0,0 +1,131 @@
+#include "leveldb/memtablerep.h"
+#include "db/dbformat.h"
+#include "db/memtablerep_util.h"
+#include "db/skiplist.h"
+
+namespace leveldb{
+
+	MemTableRep::KeyComparator::~KeyComparator()
+	{
+
+	}
+
+	MemTableRep::~MemTableRep()
+	{
+
+	}
+
+	MemTableRep::Iterator::~Iterator()
+	{
+
+	}
+
+	MemTableRepFactory::~MemTableRepFactory()
+	{
+
+	}
+
+	void MemTableRep::Get(const LookupKey& k, void* callback_args,
+		bool(*callback_func)(void* arg, const char* entry))
+	{
+		Iterator* iter = GetIterator();
+		for (iter->Seek(k.memtable_key().data());
+			iter->Valid() && (*callback_func)(callback_args, iter->key());
+			iter->Next())
+		{
+		}
+		delete iter;
+	}
+
+	namespace{
+
+		//The default representation: all entries in one skiplist.
+		class SkipListRep :public MemTableRep{
+		private:
+			typedef SkipList<const char*, const MemTableRep::KeyComparator&> List;
+
+		public:
+			SkipListRep(const MemTableRep::KeyComparator& compare, Arena* arena,
+				bool inline_key_prefix)
+				:MemTableRep(arena),
+				skip_list_(compare, arena,
+					(inline_key_prefix && compare.HasOrderedKeyPrefix()) ? &EntryKeyPrefix : NULL)
+			{
+
+			}
+
+			virtual void Insert(const char* entry){
+				skip_list_.Insert(entry);
+			}
+
+			virtual bool Contains(const char* key) const {
+				return skip_list_.Contains(key);
+			}
+
+			virtual size_t ApproximateMemoryUsage(){
+				//All memory is allocated through the arena.
+				return 0;
+			}
+
+			virtual void Get(const LookupKey& k, void* callback_args,
+				bool(*callback_func)(void* arg, const char* entry)){
+				//Same as the default, without allocating an iterator.
+				List::Iterator iter(&skip_list_);
+				for (iter.Seek(k.memtable_key().data());
+					iter.Valid() && (*callback_func)(callback_args, iter.key());
+					iter.Next())
+				{
+				}
+			}
+
+			class Iterator :public MemTableRep::Iterator{
+			public:
+				explicit Iterator(const List* list) :iter_(list){ }
+
+				virtual bool Valid() const { return iter_.Valid(); }
+				virtual const char* key() const { return iter_.key(); }
+				virtual void Next(){ iter_.Next(); }
+				virtual void Prev(){ iter_.Prev(); }
+				virtual void Seek(const char* target){ iter_.Seek(target); }
+				virtual void SeekToFirst(){ iter_.SeekToFirst(); }
+				virtual void SeekToLast(){ iter_.SeekToLast(); }
+
+			private:
+				List::Iterator iter_;
+			};
+
+			virtual MemTableRep::Iterator* GetIterator(){
+				return new Iterator(&skip_list_);
+			}
+
+		private:
+			List skip_list_;
+		};
+
+		class SkipListRepFactory :public MemTableRepFactory{
+		public:
+			explicit SkipListRepFactory(bool inline_key_prefix)
+				:inline_key_prefix_(inline_key_prefix)
+			{
+
+			}
+
+			virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp,
+				Arena* arena){
+				return new SkipListRep(cmp, arena, inline_key_prefix_);
+			}
+
+			virtual const char* Name() const { return "SkipListFactory"; }
+
+		private:
+			const bool inline_key_prefix_;
+		};
+
+	}
+
+	MemTableRepFactory* NewSkipListRepFactory(bool inline_key_prefix)
+	{
+		return new SkipListRepFactory(inline_key_prefix);
+	}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "leveldb/memtablerep.h"
+#include "leveldb/slice_transform.h"
+#include "util/coding.h"
+
+//Helpers shared by the MemTableRep implementations.
+
+namespace leveldb{
+
+	//Return the user key of the memtable entry at "entry".
+	inline Slice EntryUserKey(const char* entry){
+		uint32_t key_length;
+		const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
+		return Slice(key_ptr, key_length - 8);
+	}
+
+	//Return the first eight bytes of the user key of "entry", zero-padded,
+	//as a big-endian integer. Used as the inline key prefix of skiplist
+	//nodes when the comparator HasOrderedKeyPrefix().
+	inline uint64_t EntryKeyPrefix(const char* const& entry){
+		const Slice user_key = EntryUserKey(entry);
+		const size_t n = user_key.size() < 8 ? user_key.size() : 8;
+		uint64_t prefix = 0;
+		for (size_t i = 0; i < 8; i++)
+		{
+			prefix <<= 8;
+			if (i < n)
+			{
+				prefix |= static_cast<unsigned char>(user_key[i]);
+			}
+		}
+		return prefix;
+	}
+
+	//Return the part of "user_key" that hash-bucketed reps hash on.
+	inline Slice BucketKey(const SliceTransform* transform, const Slice& user_key){
+		return transform->InDomain(user_key) ? transform->Transform(user_key) : user_key;
+	}
+
+	//Adapts a MemTableRep::KeyComparator to the strict weak ordering
+	//expected by the standard algorithms.
+	struct EntryLess
+	{
+		const MemTableRep::KeyComparator& compare;
+		explicit EntryLess(const MemTableRep::KeyComparator& c) :compare(c){ }
+		bool operator()(const char* a, const char* b) const { return compare(a, b) < 0; }
+	};
+
+	//An iterator over a sorted vector of entries. Used by reps without a
+	//global order to iterate over a sorted snapshot.
+	class SortedEntriesIterator :public MemTableRep::Iterator{
+	public:
+		//*entries must be sorted by "cmp". If "own" is true, takes the
+		//contents of *entries; otherwise *entries must not change or be
+		//destroyed while the iterator is live.
+		SortedEntriesIterator(std::vector<const char*>* entries,
+			const MemTableRep::KeyComparator& cmp, bool own)
+			:less_(cmp)
+		{
+			if (own)
+			{
+				owned_.swap(*entries);
+				entries = &owned_;
+			}
+			entries_ = entries;
+			pos_ = entries_->size();
+		}
+
+		virtual bool Valid() const { return pos_ < entries_->size(); }
+		virtual const char* key() const { assert(Valid()); return (*entries_)[pos_]; }
+		virtual void Next() { assert(Valid()); ++pos_; }
+		virtual void Prev() {
+			assert(Valid());
+			pos_ = (pos_ == 0) ? entries_->size() : pos_ - 1;
+		}
+		virtual void Seek(const char* target) {
+			pos_ = std::lower_bound(entries_->begin(), entries_->end(), target, less_) -
+				entries_->begin();
+		}
+		virtual void SeekToFirst() { pos_ = 0; }
+		virtual void SeekToLast() { pos_ = entries_->empty() ? 0 : entries_->size() - 1; }
+
+	private:
+		EntryLess less_;
+		std::vector<const char*> owned_;
+		const std::vector<const char*>* entries_;
+		size_t pos_;	//entries_->size() when not valid
+	};
+
+}
@@ -0,0 +1,42 @@
+#include "db/merge_context.h"
+
+namespace leveldb{
+
+	void MergeContext::PushOlderOperand(const Slice& user_key, const Slice& operand)
+	{
+		if (operands_ == NULL)
+		{
+			operands_ = new std::deque<std::string>;
+		}
+		else if (merge_operator_ != NULL && !operands_->empty())
+		{
+			std::string combined;
+			if (merge_operator_->PartialMerge(user_key, operand,
+				operands_->front(), &combined))
+			{
+				operands_->front().swap(combined);
+				return;
+			}
+		}
+		operands_->push_front(operand.ToString());
+	}
+
+	Status MergeContext::Finish(const Slice& user_key, const Slice* existing_value,
+		std::string* value) const
+	{
+		if (merge_operator_ == NULL)
+		{
+			return Status::InvalidArgument("merge operand found but no merge_operator was set");
+		}
+		std::string result;
+		const std::deque<std::string> no_operands;
+		if (!merge_operator_->FullMerge(user_key, existing_value,
+			operands_ != NULL ? *operands_ : no_operands, &result))
+		{
+			return Status::Corruption("merge failed for key ", user_key);
+		}
+		value->swap(result);
+		return Status::OK();
+	}
+
+}
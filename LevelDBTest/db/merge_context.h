@@ -0,0 +1,52 @@
+#pragma once
+#include <deque>
+#include <string>
+#include "leveldb/merge_operator.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb{
+
+	//MergeContext collects the merge operands found for a single user key
+	//while a lookup walks from the newest data (the memtable) towards the
+	//oldest (the last level), so operands are always pushed newest first.
+	//The same object is handed from MemTable::Get to Version::Get so that
+	//operands found in the memtable are folded with a base value found in
+	//a table file.
+	class MergeContext{
+	public:
+		explicit MergeContext(const MergeOperator* merge_operator)
+			:merge_operator_(merge_operator), operands_(NULL){ }
+		~MergeContext(){ delete operands_; }
+
+		//Returns true iff at least one operand has been collected.
+		bool HasOperands() const { return operands_ != NULL && !operands_->empty(); }
+
+		//Return the number of operands held (after partial merging).
+		size_t NumOperands() const { return operands_ == NULL ? 0 : operands_->size(); }
+
+		//Add "operand", which is older than every operand pushed so far.
+		//If the merge operator can combine it with the oldest operand held,
+		//the two are collapsed into one.
+		void PushOlderOperand(const Slice& user_key, const Slice& operand);
+
+		//Fold the collected operands on top of *existing_value (NULL if
+		//the key has no base value) and store the result in *value.
+		Status Finish(const Slice& user_key, const Slice* existing_value,
+			std::string* value) const;
+
+		void Clear(){ if (operands_ != NULL) operands_->clear(); }
+
+	private:
+		const MergeOperator* const merge_operator_;
+
+		//Oldest operand at the front, newest at the back. Created with the
+		//first operand: an empty std::deque already allocates, and most
+		//lookups find no operand.
+		std::deque<std::string>* operands_;
+
+		//No copying allowed
+		MergeContext(const MergeContext&);
+		void operator=(const MergeContext&);
+	};
+}
@@ -0,0 +1,38 @@
+#include "db/range_del.h"
+
+#include "leveldb/comparator.h"
+#include "leveldb/iterator.h"
+
+namespace leveldb{
+
+	extern SequenceNumber MaxCoveringTombstoneSeq(Iterator* iter,
+		const Comparator* ucmp,
+		const Slice& user_key,
+		SequenceNumber snapshot)
+	{
+		//Tombstones are sorted by begin key, so only the ones starting at or
+		//before user_key can cover it. There are few of them per memtable or
+		//table, so a linear scan is cheaper than maintaining an interval index.
+		SequenceNumber result = 0;
+		for (iter->SeekToFirst(); iter->Valid(); iter->Next())
+		{
+			ParsedInternalKey begin;
+			if (!ParseInternalKey(iter->key(), &begin))
+			{
+				continue;
+			}
+			if (ucmp->Compare(begin.user_key, user_key) > 0)
+			{
+				break;
+			}
+			if (begin.sequence <= snapshot &&
+				begin.sequence > result &&
+				ucmp->Compare(user_key, iter->value()) < 0)
+			{
+				result = begin.sequence;
+			}
+		}
+		return result;
+	}
+
+}
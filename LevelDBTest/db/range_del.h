@@ -0,0 +1,31 @@
+#pragma once
+#include "db/dbformat.h"
+
+namespace leveldb{
+
+	class Iterator;
+
+	//A range tombstone written by DB::DeleteRange() is stored as an entry
+	//whose internal key is (begin, seq, kTypeRangeDeletion) and whose value
+	//is the exclusive end user key. Memtables keep these entries in a
+	//separate skiplist and tables keep them in their own meta block, so
+	//point lookups only consult them through the helpers below.
+
+	//Scan the tombstones yielded by "iter" and return the largest sequence
+	//number, no larger than "snapshot", of a tombstone whose range covers
+	//"user_key". Returns 0 if no visible tombstone covers the key.
+	//"iter" is positioned by this call; its status is left for the caller.
+	extern SequenceNumber MaxCoveringTombstoneSeq(Iterator* iter,
+		const Comparator* ucmp,
+		const Slice& user_key,
+		SequenceNumber snapshot);
+
+	//Returns true iff the user key range [smallest, largest] lies entirely
+	//inside the tombstone range [begin, end).
+	inline bool TombstoneCoversRange(const Comparator* ucmp,
+		const Slice& begin, const Slice& end,
+		const Slice& smallest, const Slice& largest){
+		return ucmp->Compare(begin, smallest) <= 0 &&
+			ucmp->Compare(largest, end) < 0;
+	}
+}
@@ -1,3 +1,4 @@
+#pragma once
 #include <assert.h>
 #include<stdlib.h>
 #include "port/port.h"
@@ -14,9 +15,16 @@ namespace leveldb{
 		struct Node;
 
 	public:
+		//Returns a 64-bit prefix of "key" such that keys with different
+		//prefixes order as their prefixes do.
+		typedef uint64_t(*KeyPrefixFunction)(const Key& key);
+
 		//Create a new SkipList object that will use "cmp" for comparing keys,
 		//and will allocate memory using "*arena".
-		explicit SkipList(Comparator cmp, Arena* arena);
+		//If "key_prefix" is non-NULL each node also stores the prefix of its
+		//key, so that most comparisons during a search are decided without
+		//dereferencing the key.
+		explicit SkipList(Comparator cmp, Arena* arena, KeyPrefixFunction key_prefix = NULL);
 
 		//Insert key into  the list.
 		void Insert(const Key& key);
@@ -65,6 +73,7 @@ namespace leveldb{
 		//Immutable after construction
 		Comparator const compare_;
 		Arena* const arena_; //Arena used for allocations of nodes
+		KeyPrefixFunction const key_prefix_;	//NULL if nodes store no prefix
 
 		Node* const head_;
 
@@ -83,8 +92,26 @@ namespace leveldb{
 		int RandomHeight();
 		bool Equal(const Key& a, const Key& b) const { return (compare_(a, b) == 0); }
 
+		//The prefix of a node's key is stored just before the node.
+		//REQUIRES: key_prefix_ != NULL
+		static uint64_t* NodePrefix(Node* n){ return reinterpret_cast<uint64_t*>(n) - 1; }
+
+		//Store the prefix of "key" in *prefix and return prefix, or
+		//return NULL if nodes store no prefix.
+		const uint64_t* KeyPrefix(const Key& key, uint64_t* prefix) const {
+			if (key_prefix_ == NULL) {
+				return NULL;
+			}
+			*prefix = (*key_prefix_)(key);
+			return prefix;
+		}
+
+		//Compare the data stored in "n" with key, whose prefix is
+		//"*key_prefix" if key_prefix is non-NULL.
+		int CompareNode(Node* n, const Key& key, const uint64_t* key_prefix) const;
+
 		//Return true if key is greater than the data stored in "n"
-		bool KeyIsAfterNode(const Key& key, Node* n) const;
+		bool KeyIsAfterNode(const Key& key, const uint64_t* key_prefix, Node* n) const;
 
 		//Return the earliest node that comes at or after key.
 		Node* FindGreaterOrEqual(const Key& key, Node** prev) const;
@@ -143,9 +170,10 @@ namespace leveldb{
 	template<typename Key, class Comparator>
 	typename SkipList<Key, Comparator>::Node*
 		SkipList<Key, Comparator>::NewNode(const Key& key, int height){
+			const size_t prefix_space = (key_prefix_ != NULL) ? sizeof(uint64_t) : 0;
 			char* mem = arena_->AllocateAligned(
-				sizeof(Node)+sizeof(port::AtomicPointer)*(height - 1));
-			return new (mem)Node(key);
+				prefix_space + sizeof(Node)+sizeof(port::AtomicPointer)*(height - 1));
+			return new (mem + prefix_space)Node(key);
 		}
 
 	template<typename Key, class Comparator>
@@ -215,19 +243,39 @@ namespace leveldb{
 	}
 
 	template<typename Key, class Comparator>
-	bool SkipList<Key, Comparator>::KeyIsAfterNode(const Key& key, Node* n) const {
+	inline int SkipList<Key, Comparator>::CompareNode(Node* n, const Key& key,
+		const uint64_t* key_prefix) const {
+		if (key_prefix != NULL) {
+			const uint64_t node_prefix = *NodePrefix(n);
+			if (node_prefix != *key_prefix) {
+				return (node_prefix < *key_prefix) ? -1 : +1;
+			}
+		}
+		return compare_(n->key, key);
+	}
+
+	template<typename Key, class Comparator>
+	bool SkipList<Key, Comparator>::KeyIsAfterNode(const Key& key,
+		const uint64_t* key_prefix, Node* n) const {
 		// NULL n is considered infinite
-		return (n != NULL) && (compare_(n->key, key) < 0);
+		return (n != NULL) && (CompareNode(n, key, key_prefix) < 0);
 	}
 
 	template<typename Key, class Comparator>
 	typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindGreaterOrEqual(const Key& key, Node** prev)
 		const {
+		uint64_t prefix;
+		const uint64_t* key_prefix = KeyPrefix(key, &prefix);
 		Node* x = head_;
 		int level = GetMaxHeight() - 1;
 		while (true) {
 			Node* next = x->Next(level);
-			if (KeyIsAfterNode(key, next)) {
+			if (next != NULL) {
+				// Fetch the node we will compare with next if "key" is after
+				// "next", while that comparison is made.
+				LEVELDB_PREFETCH(next->NoBarrier_Next(level));
+			}
+			if (KeyIsAfterNode(key, key_prefix, next)) {
 				// Keep searching in this list
 				x = next;
 			}
@@ -247,12 +295,14 @@ namespace leveldb{
 	template<typename Key, class Comparator>
 	typename SkipList<Key, Comparator>::Node*
 		SkipList<Key, Comparator>::FindLessThan(const Key& key) const {
+			uint64_t prefix;
+			const uint64_t* key_prefix = KeyPrefix(key, &prefix);
 			Node* x = head_;
 			int level = GetMaxHeight() - 1;
 			while (true) {
 				assert(x == head_ || compare_(x->key, key) < 0);
 				Node* next = x->Next(level);
-				if (next == NULL || compare_(next->key, key) >= 0) {
+				if (next == NULL || CompareNode(next, key, key_prefix) >= 0) {
 					if (level == 0) {
 						return x;
 					}
@@ -290,9 +340,11 @@ namespace leveldb{
 	}
 
 	template<typename Key, class Comparator>
-	SkipList<Key, Comparator>::SkipList(Comparator cmp, Arena* arena)
+	SkipList<Key, Comparator>::SkipList(Comparator cmp, Arena* arena,
+		KeyPrefixFunction key_prefix)
 		: compare_(cmp),
 		arena_(arena),
+		key_prefix_(key_prefix),
 		head_(NewNode(0 /* any key will do */, kMaxHeight)),
 		max_height_(reinterpret_cast<void*>(1)),
 		rnd_(0xdeadbeef) {
@@ -329,6 +381,9 @@ namespace leveldb{
 		}
 
 		x = NewNode(key, height);
+		if (key_prefix_ != NULL) {
+			*NodePrefix(x) = (*key_prefix_)(key);
+		}
 		for (int i = 0; i < height; i++) {
 			// NoBarrier_SetNext() suffices since we will add a barrier when
 			// we publish a pointer to "x" in prev[i].
@@ -0,0 +1,91 @@
+//Measures memtable inserts and point lookups with the skiplist rep,
+//with and without inline key prefixes in the nodes. Lookups search a
+//memtable far larger than the CPU caches, where each node a search
+//passes over costs a cache miss unless its prefix settles the compare.
+//Built as its own console program.
+//
+//Usage: skiplist_bench [num_entries [num_lookups]]
+//Default: 1000000 entries, 1000000 lookups.
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "db/dbformat.h"
+#include "db/memtable.h"
+#include "db/merge_context.h"
+#include "leveldb/env.h"
+#include "leveldb/memtablerep.h"
+#include "leveldb/options.h"
+#include "leveldb/pinnable_slice.h"
+#include "util/random.h"
+
+using namespace leveldb;
+
+//Keys share no long prefix, as with hashed or random user ids.
+static std::string Key(uint64_t n)
+{
+	char buf[40];
+	snprintf(buf, sizeof(buf), "%016llx-user-record",
+		static_cast<unsigned long long>(n * 0x9E3779B97F4A7C15ull));
+	return std::string(buf);
+}
+
+static void Run(const char* name, bool inline_key_prefix, int num_entries, int num_lookups)
+{
+	Options options;
+	MemTableRepFactory* factory = NewSkipListRepFactory(inline_key_prefix);
+	options.memtable_factory = factory;
+	InternalKeyComparator icmp(options.comparator);
+	MemTable* mem = new MemTable(icmp, options);
+	mem->Ref();
+
+	std::vector<std::string> keys(num_entries);
+	for (int i = 0; i < num_entries; i++)
+	{
+		keys[i] = Key(i);
+	}
+
+	Env* env = Env::Default();
+	uint64_t start = env->NowMicros();
+	for (int i = 0; i < num_entries; i++)
+	{
+		mem->Add(i + 1, kTypeValue, keys[i], "value");
+	}
+	const uint64_t insert_micros = env->NowMicros() - start;
+
+	Random rnd(301);
+	int found = 0;
+	start = env->NowMicros();
+	for (int i = 0; i < num_lookups; i++)
+	{
+		LookupKey lkey(keys[rnd.Uniform(num_entries)], num_entries);
+		PinnableSlice value;
+		Status s;
+		MergeContext merge_context(NULL);
+		SequenceNumber max_covering_tombstone_seq = 0;
+		if (mem->Get(lkey, &value, &s, &merge_context, &max_covering_tombstone_seq, NULL))
+		{
+			found++;
+		}
+	}
+	const uint64_t lookup_micros = env->NowMicros() - start;
+	assert(found == num_lookups);
+
+	fprintf(stdout, "%-14s insert %7.1f ns/op  lookup %7.1f ns/op  (%d entries)\n",
+		name,
+		insert_micros * 1000.0 / num_entries,
+		lookup_micros * 1000.0 / num_lookups,
+		num_entries);
+	mem->Unref();
+	delete factory;
+}
+
+int main(int argc, char** argv)
+{
+	const int num_entries = (argc > 1) ? atoi(argv[1]) : 1000000;
+	const int num_lookups = (argc > 2) ? atoi(argv[2]) : 1000000;
+	Run("skiplist", false, num_entries, num_lookups);
+	Run("skiplist+prefix", true, num_entries, num_lookups);
+	return 0;
+}
@@ -0,0 +1,142 @@
+#include "db/super_version.h"
+
+#include <assert.h>
+#include "db/memtable.h"
+#include "db/memtable_list.h"
+#include "db/version_set.h"
+#include "util/mutexlock.h"
+
+namespace leveldb{
+
+	//Marks a thread's slot while the thread reads through the
+	//SuperVersion it took from it.
+	static int in_use_dummy;
+	static void* const kInUse = &in_use_dummy;
+
+	SuperVersion::~SuperVersion()
+	{
+		mem->Unref();
+		for (size_t i = 0; i < imm.size(); i++)
+		{
+			imm[i]->Unref();
+		}
+		current->Unref();
+	}
+
+	SuperVersionCache::SuperVersionCache(port::Mutex* mu)
+		:mu_(mu),
+		current_(NULL),
+		epoch_(0),
+		local_(&SuperVersionCache::UnrefThreadLocal)
+	{
+
+	}
+
+	SuperVersionCache::~SuperVersionCache()
+	{
+		MutexLock l(mu_);
+		ResetThreadLocal();
+		if (current_ != NULL)
+		{
+			Unref(current_);
+		}
+	}
+
+	void SuperVersionCache::Unref(SuperVersion* sv)
+	{
+		mu_->AssertHeld();
+		assert(sv->refs > 0);
+		if (--sv->refs == 0)
+		{
+			delete sv;
+		}
+	}
+
+	void SuperVersionCache::ResetThreadLocal()
+	{
+		std::vector<void*> svs;
+		local_.Scrape(&svs, NULL);
+		for (size_t i = 0; i < svs.size(); i++)
+		{
+			//A slot marked kInUse belongs to a read in progress; the
+			//reader's Release() notices the slot was reset and drops its
+			//reference itself.
+			if (svs[i] != kInUse)
+			{
+				Unref(reinterpret_cast<SuperVersion*>(svs[i]));
+			}
+		}
+	}
+
+	void SuperVersionCache::UnrefThreadLocal(void* ptr)
+	{
+		//A thread does not exit in the middle of a read.
+		assert(ptr != kInUse);
+		SuperVersion* sv = reinterpret_cast<SuperVersion*>(ptr);
+		SuperVersionCache* cache = sv->cache;
+		MutexLock l(cache->mu_);
+		cache->Unref(sv);
+	}
+
+	void SuperVersionCache::Install(MemTable* mem, const MemTableList& imm,
+		Version* current)
+	{
+		mu_->AssertHeld();
+		SuperVersion* sv = new SuperVersion;
+		sv->mem = mem;
+		mem->Ref();
+		imm.GetReferenced(&sv->imm);
+		sv->current = current;
+		current->Ref();
+		sv->version_number = ++epoch_;
+		sv->cache = this;
+		sv->refs = 1;
+
+		SuperVersion* old = current_;
+		current_ = sv;
+
+		//Reset the slots before *mu_ is released, so a read that starts
+		//after a write into a new memtable can no longer find an older
+		//SuperVersion without that memtable.
+		ResetThreadLocal();
+		if (old != NULL)
+		{
+			Unref(old);
+		}
+	}
+
+	SuperVersion* SuperVersionCache::Acquire()
+	{
+		void* ptr = local_.Swap(kInUse);
+		//Only the owning thread stores kInUse, and Acquire() does not nest.
+		assert(ptr != kInUse);
+		SuperVersion* sv = reinterpret_cast<SuperVersion*>(ptr);
+		if (sv == NULL)
+		{
+			//First read on this thread since the last Install(). The
+			//reference taken here is cached by Release().
+			MutexLock l(mu_);
+			assert(current_ != NULL);
+			sv = current_;
+			sv->refs++;
+		}
+		return sv;
+	}
+
+	void SuperVersionCache::Release(SuperVersion* sv)
+	{
+		void* expected = kInUse;
+		if (local_.CompareAndSwap(sv, &expected))
+		{
+			//Cached for the next read on this thread.
+			return;
+		}
+
+		//Install() reset the slot while we were reading, so sv is stale
+		//and our reference is no longer owned by the slot.
+		assert(expected == NULL);
+		MutexLock l(mu_);
+		Unref(sv);
+	}
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "port/port.h"
+#include "util/thread_local.h"
+
+namespace leveldb{
+
+	class MemTable;
+	class MemTableList;
+	class SuperVersionCache;
+	class Version;
+
+	//Everything a read consults, referenced together: the mutable
+	//memtable, the immutable memtables and the current Version. A read
+	//that holds a SuperVersion needs no lock to use any of them.
+	struct SuperVersion
+	{
+		MemTable* mem;
+		std::vector<MemTable*> imm;	//Newest first
+		Version* current;
+		uint64_t version_number;	//Epoch at which it was installed
+
+	private:
+		friend class SuperVersionCache;
+
+		SuperVersionCache* cache;	//The cache that installed it
+		int refs;	//Protected by the DB mutex
+
+		SuperVersion() :mem(NULL), current(NULL), version_number(0), cache(NULL), refs(0) { }
+
+		//Drops the references to the memtables and the Version.
+		//REQUIRES: DB mutex held
+		~SuperVersion();
+
+		//No copying allowed
+		SuperVersion(const SuperVersion&);
+		void operator=(const SuperVersion&);
+	};
+
+	//Hands out the current SuperVersion to readers without the DB mutex.
+	//Each thread caches a referenced SuperVersion in a ThreadLocalPtr and
+	//reuses it until Install() bumps the epoch, which takes back every
+	//cached reference. Only the first read on a thread after an Install()
+	//takes the DB mutex, so Get() does not contend on it to Ref() the
+	//memtables and the Version. A thread that exits drops the reference
+	//it cached, taking the DB mutex.
+	class SuperVersionCache
+	{
+	public:
+		//"*mu" is the DB mutex, which protects the reference counts of
+		//memtables and Versions.
+		explicit SuperVersionCache(port::Mutex* mu);
+
+		//Waits for exiting threads to drop the references they cached.
+		//REQUIRES: no Acquire()d SuperVersion is still in use
+		~SuperVersionCache();
+
+		//Make {mem, imm, current} the SuperVersion handed to readers and
+		//bump the epoch. Threads still reading an older SuperVersion keep
+		//it until they Release() it. Call after every memtable switch and
+		//every VersionSet::LogAndApply().
+		//REQUIRES: *mu held
+		void Install(MemTable* mem, const MemTableList& imm, Version* current);
+
+		//Return the current SuperVersion for a read on the calling thread.
+		//Takes *mu only if Install() has run since the thread's last read.
+		//Calls may not nest on a thread: Release() the result first.
+		//REQUIRES: *mu not held, Install() called at least once
+		SuperVersion* Acquire();
+
+		//Hand back a SuperVersion returned by Acquire() on this thread.
+		//REQUIRES: *mu not held
+		void Release(SuperVersion* sv);
+
+		//Return the number of Install() calls so far.
+		//REQUIRES: *mu held
+		uint64_t Epoch() const { return epoch_; }
+
+	private:
+		//REQUIRES: *mu_ held
+		void Unref(SuperVersion* sv);
+
+		//Take back the SuperVersions cached by all threads.
+		//REQUIRES: *mu_ held
+		void ResetThreadLocal();
+
+		//Drop the reference to "ptr", a SuperVersion left in the slot of
+		//an exiting thread.
+		//REQUIRES: *mu_ not held
+		static void UnrefThreadLocal(void* ptr);
+
+		port::Mutex* const mu_;
+		SuperVersion* current_;	//Holds one reference
+		uint64_t epoch_;
+
+		//Per thread: NULL, a referenced SuperVersion, or kInUse while the
+		//thread is reading through the SuperVersion it took from the slot.
+		ThreadLocalPtr local_;
+
+		//No copying allowed
+		SuperVersionCache(const SuperVersionCache&);
+		void operator=(const SuperVersionCache&);
+	};
+
+}
@@ -0,0 +1,360 @@
+#include "db/table_cache.h"
+
+#include <stdio.h>
+#include "db/filename.h"
+#include "db/version_edit.h"
+#include "leveldb/env.h"
+#include "leveldb/table.h"
+#include "util/coding.h"
+
+namespace leveldb{
+
+	struct TableAndFile
+	{
+		RandomAccessFile* file;
+		Table* table;
+	};
+
+	static void DeleteEntry(const Slice& key, void* value)
+	{
+		TableAndFile* tf = reinterpret_cast<TableAndFile*>(value);
+		delete tf->table;
+		delete tf->file;
+		delete tf;
+	}
+
+	static void UnrefEntry(void* arg1, void* arg2)
+	{
+		Cache* cache = reinterpret_cast<Cache*>(arg1);
+		Cache::Handle* h = reinterpret_cast<Cache::Handle*>(arg2);
+		cache->Release(h);
+	}
+
+	static Table* TableOf(Cache* cache, Cache::Handle* handle)
+	{
+		return reinterpret_cast<TableAndFile*>(cache->Value(handle))->table;
+	}
+
+	//Capacity of the cache when every table is kept open: more tables than
+	//a DB can hold, so that no entry is ever evicted.
+	static const int kKeepOpenEntries = 1 << 30;
+
+	TableCache::TableCache(const std::string& dbname,
+		const Options* options,
+		const Comparator* user_comparator,
+		int entries)
+		:env_(options->env),
+		dbname_(dbname),
+		options_(options),
+		external_options_(*options),
+		keep_open_(options->max_open_files < 0),
+		cache_(NewLRUCache(keep_open_ ? kKeepOpenEntries : entries))
+	{
+		external_options_.comparator = user_comparator;
+	}
+
+	TableCache::~TableCache()
+	{
+		delete cache_;
+	}
+
+	Status TableCache::FindTable(uint64_t file_number, uint64_t file_size,
+		bool external, Cache::Handle** handle)
+	{
+		char buf[sizeof(file_number)];
+		EncodeFixed64(buf, file_number);
+		Slice key(buf, sizeof(buf));
+		Shard* shard = ShardFor(file_number);
+		*handle = cache_->Lookup(key);
+		if (*handle != NULL)
+		{
+			shard->hits.Add(1);
+			return Status::OK();
+		}
+		shard->misses.Add(1);
+
+		shard->mu.Lock();
+		if (shard->opening.count(file_number) != 0)
+		{
+			shard->waits.Add(1);
+			do
+			{
+				shard->cv.Wait();
+			} while (shard->opening.count(file_number) != 0);
+		}
+		//The open we waited for, or one that finished between our lookup
+		//and taking the lock, may have cached the table. If it failed we
+		//try again ourselves.
+		*handle = cache_->Lookup(key);
+		if (*handle != NULL)
+		{
+			shard->mu.Unlock();
+			return Status::OK();
+		}
+		shard->opening.insert(file_number);
+		shard->mu.Unlock();
+
+		std::string fname = TableFileName(dbname_, file_number);
+		RandomAccessFile* file = NULL;
+		Table* table = NULL;
+		Status s = env_->NewRandomAccessFile(fname, &file);
+		if (s.ok())
+		{
+			s = Table::Open(external ? external_options_ : *options_,
+				file, file_size, &table);
+		}
+
+		if (!s.ok())
+		{
+			assert(table == NULL);
+			delete file;
+			shard->open_errors.Add(1);
+			//We do not cache error results so that if the error is transient,
+			//or somebody repairs the file, we recover automatically.
+		}
+		else
+		{
+			TableAndFile* tf = new TableAndFile;
+			tf->file = file;
+			tf->table = table;
+			*handle = cache_->Insert(key, tf, 1, &DeleteEntry);
+			shard->opens.Add(1);
+		}
+
+		shard->mu.Lock();
+		shard->opening.erase(file_number);
+		shard->cv.SignalAll();
+		shard->mu.Unlock();
+		return s;
+	}
+
+	Status TableCache::GetTable(FileMetaData* file, Table** table,
+		Cache::Handle** handle)
+	{
+		Cache::Handle* pinned =
+			reinterpret_cast<Cache::Handle*>(file->table_handle.Acquire_Load());
+		if (pinned != NULL)
+		{
+			*table = TableOf(cache_, pinned);
+			*handle = NULL;
+			return Status::OK();
+		}
+
+		Status s = FindTable(file->number, file->file_size,
+			file->global_seqno != 0, handle);
+		if (!s.ok())
+		{
+			return s;
+		}
+		if (keep_open_)
+		{
+			//The handle's reference becomes the file's.
+			Cache::Handle* mine = *handle;
+			*handle = NULL;
+			void* expected = NULL;
+			if (file->table_handle.CompareAndSwap(mine, &expected))
+			{
+				*table = TableOf(cache_, mine);
+			}
+			else
+			{
+				//Another reader pinned the file first; use its handle.
+				cache_->Release(mine);
+				*table = TableOf(cache_, reinterpret_cast<Cache::Handle*>(expected));
+			}
+			return s;
+		}
+		*table = TableOf(cache_, *handle);
+		return s;
+	}
+
+	Iterator* TableCache::NewIterator(const ReadOptions& options,
+		uint64_t file_number,
+		uint64_t file_size,
+		Table** tableptr)
+	{
+		if (tableptr != NULL)
+		{
+			*tableptr = NULL;
+		}
+
+		Cache::Handle* handle = NULL;
+		Status s = FindTable(file_number, file_size, false, &handle);
+		if (!s.ok())
+		{
+			return NewErrorIterator(s);
+		}
+
+		Table* table = TableOf(cache_, handle);
+		Iterator* result = table->NewIterator(options);
+		result->RegisterCleanup(&UnrefEntry, cache_, handle);
+		if (tableptr != NULL)
+		{
+			*tableptr = table;
+		}
+		return result;
+	}
+
+	Iterator* TableCache::NewIterator(const ReadOptions& options,
+		FileMetaData* file,
+		Table** tableptr)
+	{
+		if (tableptr != NULL)
+		{
+			*tableptr = NULL;
+		}
+
+		Table* table;
+		Cache::Handle* handle;
+		Status s = GetTable(file, &table, &handle);
+		if (!s.ok())
+		{
+			return NewErrorIterator(s);
+		}
+
+		Iterator* result = table->NewIterator(options);
+		if (handle != NULL)
+		{
+			result->RegisterCleanup(&UnrefEntry, cache_, handle);
+		}
+		if (tableptr != NULL)
+		{
+			*tableptr = table;
+		}
+		return result;
+	}
+
+	Iterator* TableCache::NewRangeTombstoneIterator(const ReadOptions& options,
+		FileMetaData* file)
+	{
+		Table* table;
+		Cache::Handle* handle;
+		Status s = GetTable(file, &table, &handle);
+		if (!s.ok())
+		{
+			return NewErrorIterator(s);
+		}
+
+		Iterator* result = table->NewRangeTombstoneIterator(options);
+		if (handle != NULL)
+		{
+			if (result == NULL)
+			{
+				cache_->Release(handle);
+			}
+			else
+			{
+				result->RegisterCleanup(&UnrefEntry, cache_, handle);
+			}
+		}
+		return result;
+	}
+
+	Status TableCache::Get(const ReadOptions& options,
+		FileMetaData* file,
+		const Slice& k,
+		void* arg,
+		bool(*handle_result)(void*, const Slice&, const Slice&, Table::BlockPin*))
+	{
+		Table* table;
+		Cache::Handle* handle;
+		Status s = GetTable(file, &table, &handle);
+		if (s.ok())
+		{
+			s = table->InternalGet(options, k, arg, handle_result);
+			if (handle != NULL)
+			{
+				cache_->Release(handle);
+			}
+		}
+		return s;
+	}
+
+	bool TableCache::PrefixMayMatch(const ReadOptions& options,
+		FileMetaData* file,
+		const Slice& prefix)
+	{
+		Table* table;
+		Cache::Handle* handle;
+		Status s = GetTable(file, &table, &handle);
+		if (!s.ok())
+		{
+			//Let the caller open the file and report the error.
+			return true;
+		}
+
+		const bool result = table->PrefixMayMatch(prefix);
+		if (handle != NULL)
+		{
+			cache_->Release(handle);
+		}
+		return result;
+	}
+
+	Status TableCache::Preload(FileMetaData* file)
+	{
+		Table* table;
+		Cache::Handle* handle;
+		Status s = GetTable(file, &table, &handle);
+		if (s.ok() && handle != NULL)
+		{
+			cache_->Release(handle);
+		}
+		return s;
+	}
+
+	void TableCache::Unpin(FileMetaData* file)
+	{
+		Cache::Handle* pinned =
+			reinterpret_cast<Cache::Handle*>(file->table_handle.NoBarrier_Load());
+		if (pinned != NULL)
+		{
+			file->table_handle.NoBarrier_Store(NULL);
+			cache_->Release(pinned);
+		}
+	}
+
+	uint64_t TableCache::BytesRead(uint64_t file_number)
+	{
+		char buf[sizeof(file_number)];
+		EncodeFixed64(buf, file_number);
+		Cache::Handle* handle = cache_->Lookup(Slice(buf, sizeof(buf)));
+		if (handle == NULL)
+		{
+			return 0;
+		}
+		const uint64_t result = TableOf(cache_, handle)->BytesRead();
+		cache_->Release(handle);
+		return result;
+	}
+
+	void TableCache::Evict(uint64_t file_number)
+	{
+		char buf[sizeof(file_number)];
+		EncodeFixed64(buf, file_number);
+		cache_->Erase(Slice(buf, sizeof(buf)));
+	}
+
+	std::string TableCache::Stats() const
+	{
+		std::string result;
+		char buf[200];
+		snprintf(buf, sizeof(buf), "%5s %12s %10s %8s %8s %8s\n",
+			"Shard", "Hits", "Misses", "Waits", "Opens", "Errors");
+		result.append(buf);
+		for (int i = 0; i < kNumShards; i++)
+		{
+			const Shard& shard = shards_[i];
+			snprintf(buf, sizeof(buf), "%5d %12lld %10lld %8lld %8lld %8lld\n",
+				i,
+				static_cast<long long>(shard.hits.Load()),
+				static_cast<long long>(shard.misses.Load()),
+				static_cast<long long>(shard.waits.Load()),
+				static_cast<long long>(shard.opens.Load()),
+				static_cast<long long>(shard.open_errors.Load()));
+			result.append(buf);
+		}
+		return result;
+	}
+
+}
@@ -1,34 +1,132 @@
 #pragma once
+#include <set>
 #include <string>
 #include <stdint.h>
 #include "db/dbformat.h"
 #include "leveldb/cache.h"
+#include "leveldb/options.h"
 #include "leveldb/table.h"
+#include "port/port.h"
 
 namespace leveldb{
 
 	class Env;
+	struct FileMetaData;
 
+	//Keeps the tables of a DB open in a Cache keyed by file number.
+	//Concurrent misses on the same file open it once: later readers wait
+	//for the first one's open instead of opening the file again.
+	//
+	//If options->max_open_files is negative, every table is kept open for
+	//as long as it is live: the first read of a file pins its cache entry
+	//in FileMetaData::table_handle, and later reads use it directly
+	//without a cache lookup.
+	//
+	//Tables the DB built hold internal keys and are opened with *options,
+	//whose comparator is the DB's InternalKeyComparator. Ingested files
+	//(FileMetaData::global_seqno != 0) hold plain user keys and are opened
+	//with a copy of *options whose comparator is "user_comparator".
 	class TableCache{
 	public:
-		TableCache(const std::string& dbname, const Options* options, int entries);
+		TableCache(const std::string& dbname, const Options* options,
+			const Comparator* user_comparator, int entries);
 		~TableCache();
 
 		//Return an iterator for the specified file number(the corresponding
-		//file length must be exactly "file_size" bytes).
+		//file length must be exactly "file_size" bytes). For files not yet
+		//part of a version; tables are not pinned this way.
 		Iterator* NewIterator(const ReadOptions& options,
 			uint64_t file_number,
 			uint64_t file_size,
 			Table** tableptr = NULL);
 
+		//Return an iterator over the contents of "file".
+		Iterator* NewIterator(const ReadOptions& options,
+			FileMetaData* file,
+			Table** tableptr = NULL);
+
+		//Return an iterator over the range tombstones of "file", or NULL if
+		//the file has no range deletion meta block.
+		Iterator* NewRangeTombstoneIterator(const ReadOptions& options,
+			FileMetaData* file);
+
+		//Look "k" up in "file" through Table::InternalGet(), which calls
+		//(*handle_result)(arg, ...) on the entries from "k" on.
+		Status Get(const ReadOptions& options,
+			FileMetaData* file,
+			const Slice& k,
+			void* arg,
+			bool(*handle_result)(void*, const Slice&, const Slice&, Table::BlockPin*));
+
+		//Returns false if "file" certainly holds no key with the prefix
+		//"prefix" under options_->prefix_extractor; see
+		//Table::PrefixMayMatch(). Opens the file if it is not yet cached.
+		bool PrefixMayMatch(const ReadOptions& options,
+			FileMetaData* file,
+			const Slice& prefix);
+
+		//Open "file", unless it is already cached, so that later reads find
+		//its index and filter in memory. Pins it if tables are kept open.
+		Status Preload(FileMetaData* file);
+
+		//Release the table pinned in "file", if any. Called when the file
+		//leaves the last version holding it.
+		void Unpin(FileMetaData* file);
+
+		//Return Table::BytesRead() of the specified file if it is cached,
+		//else zero. Does not open the file.
+		uint64_t BytesRead(uint64_t file_number);
+
 		//Evict any entry for the specified fiel number
 		void Evict(uint64_t file_number);
 
+		//Return a human-readable table of the lookup counters of each
+		//shard, for the "leveldb.table-cache-stats" property.
+		std::string Stats() const;
+
 	private:
+		static const int kNumShards = 16;
+
+		//Misses are serialized per shard, chosen by file number, so that
+		//opens of unrelated files do not contend on one mutex. Hits take
+		//no lock. Reads of pinned tables are not counted.
+		struct Shard{
+			port::Mutex mu;
+			port::CondVar cv;	//Signalled when an open finishes
+			std::set<uint64_t> opening;	//Files being opened; protected by mu
+
+			port::AtomicCounter hits;	//Lookups found in the cache
+			port::AtomicCounter misses;	//Lookups that were not
+			port::AtomicCounter waits;	//Misses served by another thread's open
+			port::AtomicCounter opens;	//Files opened
+			port::AtomicCounter open_errors;	//Opens that failed
+
+			Shard() :cv(&mu) { }
+		};
+
+		Shard* ShardFor(uint64_t file_number) {
+			return &shards_[file_number % kNumShards];
+		}
+
+		//"external" selects external_options_ to open the table with.
+		Status FindTable(uint64_t file_number, uint64_t file_size, bool external,
+			Cache::Handle**);
+
+		//Store the table of "file" in *table. If the table is pinned in
+		//"file", *handle is set to NULL; otherwise it is set to a cache
+		//handle that the caller must release once done with *table.
+		Status GetTable(FileMetaData* file, Table** table, Cache::Handle** handle);
+
 		Env* const env_;
 		const std::string dbname_;
 		const Options* options_;
+		Options external_options_;	//*options_ with the user comparator
+		const bool keep_open_;
 		Cache* cache_;
+		Shard shards_[kNumShards];
 
+		//No copying allowed
+		TableCache(const TableCache&);
+		void operator=(const TableCache&);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "db/filename.h"
+#include "db/log_writer.h"
+#include "db/version_edit.h"
+#include "leveldb/comparator.h"
+#include "leveldb/env.h"
+#include "leveldb/status.h"
+
+//Helpers shared by the standalone test programs (*_test.cpp). Unlike
+//assert(), the checks here stay in release builds.
+
+//Abort with the failed condition and its location unless "cond" holds.
+#define LEVELDB_CHECK(cond)	\
+	do {	\
+		if (!(cond)) {	\
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);	\
+			abort();	\
+		}	\
+	} while (0)
+
+namespace leveldb{
+	namespace test{
+
+		//Abort with the message of "s" unless it is OK.
+		inline void CheckOk(const Status& s)
+		{
+			if (!s.ok())
+			{
+				fprintf(stderr, "%s\n", s.ToString().c_str());
+				abort();
+			}
+		}
+
+		//Return the name of directory "name" under the test directory of
+		//"env", created empty.
+		inline std::string NewTestDirectory(Env* env, const std::string& name)
+		{
+			std::string dir;
+			CheckOk(env->GetTestDirectory(&dir));
+			dir += "/" + name;
+			std::vector<std::string> children;
+			env->GetChildren(dir, &children);
+			for (size_t i = 0; i < children.size(); i++)
+			{
+				env->DeleteFile(dir + "/" + children[i]);
+			}
+			env->CreateDir(dir);
+			return dir;
+		}
+
+		//Write the descriptor of an empty DB, as DB::Open does for a new
+		//one, so that a VersionSet over "dbname" can Recover().
+		inline void NewDB(Env* env, const std::string& dbname, const Comparator* ucmp)
+		{
+			VersionEdit new_db;
+			new_db.SetComparatorName(ucmp->Name());
+			new_db.SetLogNumber(0);
+			new_db.setNextFile(2);
+			new_db.SetLastSequence(0);
+			std::string record;
+			new_db.EncodeTo(&record);
+
+			leveldb::WritableFile* file;
+			CheckOk(env->NewWritableFile(DescriptorFileName(dbname, 1), &file));
+			{
+				log::Writer log(file);
+				CheckOk(log.AddRecord(record));
+			}
+			CheckOk(file->Close());
+			delete file;
+			CheckOk(SetCurrentFile(env, dbname, 1));
+		}
+
+	}
+}
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <vector>
+#include "db/dbformat.h"
+#include "db/memtablerep_util.h"
+#include "leveldb/env.h"
+#include "leveldb/memtablerep.h"
+#include "port/port.h"
+#include "util/mutexlock.h"
+
+namespace leveldb{
+
+	namespace{
+
+		//Below this many entries per thread a parallel sort is not worth
+		//starting threads for.
+		static const size_t kMinEntriesPerSortThread = 64 * 1024;
+
+		struct SortShared
+		{
+			port::Mutex mu;
+			port::CondVar cv;
+			int remaining;	//Chunks still being sorted by other threads
+			SortShared() :cv(&mu), remaining(0){ }
+		};
+
+		struct SortJob
+		{
+			const char** begin;
+			const char** end;
+			const MemTableRep::KeyComparator* cmp;
+			SortShared* shared;
+		};
+
+		static void SortWork(void* arg)
+		{
+			SortJob* job = reinterpret_cast<SortJob*>(arg);
+			std::sort(job->begin, job->end, EntryLess(*job->cmp));
+			MutexLock l(&job->shared->mu);
+			if (--job->shared->remaining == 0)
+			{
+				job->shared->cv.SignalAll();
+			}
+		}
+
+		//Sort *v by splitting it into up to "threads" chunks, sorting them
+		//concurrently and merging the sorted chunks pairwise.
+		static void ParallelSort(std::vector<const char*>* v,
+			const MemTableRep::KeyComparator& cmp, int threads)
+		{
+			size_t chunks = static_cast<size_t>(threads > 1 ? threads : 1);
+			chunks = std::min(chunks, v->size() / kMinEntriesPerSortThread);
+			if (chunks <= 1)
+			{
+				std::sort(v->begin(), v->end(), EntryLess(cmp));
+				return;
+			}
+
+			const char** base = &(*v)[0];
+			std::vector<size_t> bounds(chunks + 1);
+			for (size_t i = 0; i <= chunks; i++)
+			{
+				bounds[i] = v->size() * i / chunks;
+			}
+
+			SortShared shared;
+			std::vector<SortJob> jobs(chunks);
+			for (size_t i = 0; i < chunks; i++)
+			{
+				jobs[i].begin = base + bounds[i];
+				jobs[i].end = base + bounds[i + 1];
+				jobs[i].cmp = &cmp;
+				jobs[i].shared = &shared;
+			}
+			shared.remaining = static_cast<int>(chunks - 1);
+			for (size_t i = 1; i < chunks; i++)
+			{
+				Env::Default()->StartThread(&SortWork, &jobs[i]);
+			}
+			std::sort(jobs[0].begin, jobs[0].end, EntryLess(cmp));
+			{
+				MutexLock l(&shared.mu);
+				while (shared.remaining > 0)
+				{
+					shared.cv.Wait();
+				}
+			}
+
+			for (size_t width = 1; width < chunks; width *= 2)
+			{
+				for (size_t i = 0; i + width < chunks; i += 2 * width)
+				{
+					const size_t end = std::min(i + 2 * width, chunks);
+					std::inplace_merge(base + bounds[i], base + bounds[i + width],
+						base + bounds[end], EntryLess(cmp));
+				}
+			}
+		}
+
+		//Entries are appended to a vector, which is sorted once the
+		//memtable is immutable. Until then every read sorts a copy.
+		class VectorRep :public MemTableRep{
+		public:
+			VectorRep(const MemTableRep::KeyComparator& compare, Arena* arena,
+				size_t reserved_count, int sort_threads)
+				:MemTableRep(arena),
+				compare_(compare),
+				sort_threads_(sort_threads),
+				immutable_(false),
+				sorted_(false)
+			{
+				entries_.reserve(reserved_count);
+			}
+
+			virtual void Insert(const char* entry){
+				MutexLock l(&mu_);
+				assert(!immutable_);
+				entries_.push_back(entry);
+			}
+
+			virtual bool Contains(const char* key) const {
+				MutexLock l(&mu_);
+				for (size_t i = 0; i < entries_.size(); i++)
+				{
+					if (compare_(entries_[i], key) == 0)
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+
+			virtual void MarkReadOnly(){
+				MutexLock l(&mu_);
+				immutable_ = true;
+			}
+
+			virtual size_t ApproximateMemoryUsage(){
+				//The entries live in the arena, the vector does not.
+				MutexLock l(&mu_);
+				return entries_.capacity() * sizeof(const char*);
+			}
+
+			virtual void Get(const LookupKey& k, void* callback_args,
+				bool(*callback_func)(void* arg, const char* entry)){
+				std::vector<const char*> copy;
+				const std::vector<const char*>* entries = Snapshot(&copy);
+				std::vector<const char*>::const_iterator iter = std::lower_bound(
+					entries->begin(), entries->end(), k.memtable_key().data(), EntryLess(compare_));
+				for (; iter != entries->end() && (*callback_func)(callback_args, *iter); ++iter)
+				{
+				}
+			}
+
+			virtual MemTableRep::Iterator* GetIterator(){
+				std::vector<const char*> copy;
+				const std::vector<const char*>* entries = Snapshot(&copy);
+				if (entries == &copy)
+				{
+					return new SortedEntriesIterator(&copy, compare_, true);
+				}
+				return new SortedEntriesIterator(&entries_, compare_, false);
+			}
+
+		private:
+			//Return the sorted entries. Once immutable these are entries_,
+			//sorted in place on first use; before that a sorted copy is
+			//stored in *copy.
+			const std::vector<const char*>* Snapshot(std::vector<const char*>* copy){
+				MutexLock l(&mu_);
+				if (immutable_)
+				{
+					if (!sorted_)
+					{
+						ParallelSort(&entries_, compare_, sort_threads_);
+						sorted_ = true;
+					}
+					return &entries_;
+				}
+				*copy = entries_;
+				mu_.Unlock();
+				std::sort(copy->begin(), copy->end(), EntryLess(compare_));
+				mu_.Lock();
+				return copy;
+			}
+
+			const MemTableRep::KeyComparator& compare_;
+			const int sort_threads_;
+			mutable port::Mutex mu_;
+			std::vector<const char*> entries_;
+			bool immutable_;	//No more inserts; entries_ may be sorted in place
+			bool sorted_;	//entries_ is sorted; it never changes again
+		};
+
+		class VectorRepFactory :public MemTableRepFactory{
+		public:
+			VectorRepFactory(size_t reserved_count, int sort_threads)
+				:reserved_count_(reserved_count),
+				sort_threads_(sort_threads)
+			{
+
+			}
+
+			virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp,
+				Arena* arena){
+				return new VectorRep(cmp, arena, reserved_count_, sort_threads_);
+			}
+
+			virtual const char* Name() const { return "VectorRepFactory"; }
+
+		private:
+			const size_t reserved_count_;
+			const int sort_threads_;
+		};
+
+	}
+
+	MemTableRepFactory* NewVectorRepFactory(size_t reserved_count, int sort_threads)
+	{
+		return new VectorRepFactory(reserved_count, sort_threads);
+	}
+
+}
@@ -1,4 +1,3 @@
-DeletedFileSet
 #include "version_edit.h"
 
 #include "db/version_set.h"
@@ -18,7 +17,8 @@ namespace leveldb{
 		kDeleteFile		= 6,
 		kNewFile		= 7,
 		// 8 was used for large value refs
-		kPrevLogNumber	= 9
+		kPrevLogNumber	= 9,
+		kNewIngestedFile	= 10
 	};
 
 
@@ -72,19 +72,22 @@ namespace leveldb{
 		for (DeletedFileSet::const_iterator iter = deleted_files_.begin();
 			iter != deleted_files_.end();
 			++iter) {
-			PutVarint32(dst, kDeletedFile);
+			PutVarint32(dst, kDeleteFile);
 			PutVarint32(dst, iter->first);   // level
 			PutVarint64(dst, iter->second);  // file number
 		}
 
 		for (size_t i = 0; i < new_files_.size(); i++) {
 			const FileMetaData& f = new_files_[i].second;
-			PutVarint32(dst, kNewFile);
+			PutVarint32(dst, f.global_seqno != 0 ? kNewIngestedFile : kNewFile);
 			PutVarint32(dst, new_files_[i].first);  // level
 			PutVarint64(dst, f.number);
 			PutVarint64(dst, f.file_size);
 			PutLengthPrefixedSlice(dst, f.smallest.Encode());
 			PutLengthPrefixedSlice(dst, f.largest.Encode());
+			if (f.global_seqno != 0) {
+				PutVarint64(dst, f.global_seqno);
+			}
 		}
 	}
 
@@ -115,7 +118,7 @@ namespace leveldb{
 	}
 
 	Status VersionEdit::DecodeFrom(const Slice& src) {
-		Clear();
+		clear();
 		Slice input = src;
 		const char* msg = NULL;
 		uint32_t tag;
@@ -185,7 +188,7 @@ namespace leveldb{
 				}
 				break;
 
-			case kDeletedFile:
+			case kDeleteFile:
 				if (GetLevel(&input, &level) &&
 					GetVarint64(&input, &number)) {
 					deleted_files_.insert(std::make_pair(level, number));
@@ -208,6 +211,21 @@ namespace leveldb{
 				}
 				break;
 
+			case kNewIngestedFile:
+				if (GetLevel(&input, &level) &&
+					GetVarint64(&input, &f.number) &&
+					GetVarint64(&input, &f.file_size) &&
+					GetInternalKey(&input, &f.smallest) &&
+					GetInternalKey(&input, &f.largest) &&
+					GetVarint64(&input, &f.global_seqno)) {
+					new_files_.push_back(std::make_pair(level, f));
+					f.global_seqno = 0;
+				}
+				else {
+					msg = "ingested-file entry";
+				}
+				break;
+
 			default:
 				msg = "unknown tag";
 				break;
@@ -274,6 +292,10 @@ namespace leveldb{
 			r.append(f.smallest.DebugString());
 			r.append(" .. ");
 			r.append(f.largest.DebugString());
+			if (f.global_seqno != 0) {
+				r.append(" @");
+				AppendNumberTo(&r, f.global_seqno);
+			}
 		}
 		r.append("\n}\n");
 		return r;
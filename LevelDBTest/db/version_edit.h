@@ -3,20 +3,32 @@
 #include <utility>
 #include <vector>
 #include "db/dbformat.h"
+#include "port/port.h"
 
 namespace leveldb{
 
 	class VersionSet;
 
+	//Reads served by a table file. Readers update the counters without
+	//locks, so they are approximate while reads are in flight.
+	struct FileReadStats{
+		port::AtomicCounter gets;	//Get() calls that searched the file
+		port::AtomicCounter misses;	//Of those, the ones that were the first of several files searched
+		port::AtomicCounter seeks;	//Iterator Seek() calls that landed in the file
+	};
+
 	struct FileMetaData{
 		int refs;
-		int allowed_seeks;	//Seeks allowed util compaction
+		int allowed_seeks;	//Read misses allowed until compaction
 		uint64_t number;
 		uint64_t file_size;	//File size in bytes
 		InternalKey smallest;	//Smallest internal key served by table
 		InternalKey largest;	//Largest internal key served by table
+		SequenceNumber global_seqno;	//Non-zero for ingested files holding plain user keys
+		FileReadStats read_stats;
+		port::AtomicPointer table_handle;	//Cache::Handle* of the table while TableCache keeps it open, else NULL
 
-		FileMetaData() :refs(0), allowed_seeks(1 << 30), file_size(0){ }
+		FileMetaData() :refs(0), allowed_seeks(1 << 30), file_size(0), global_seqno(0){ }
 	};
 
 	class VersionEdit{
@@ -56,18 +68,31 @@ namespace leveldb{
 		}
 
 		//Add the specified file at the specified number.
+		//A non-zero "global_seqno" marks a file ingested from outside the
+		//DB: its entries are read as (user_key, global_seqno, kTypeValue).
 		void AddFile(int level, uint64_t file,
 			uint64_t file_size,
 			const InternalKey& smallest,
-			const InternalKey& largest){
+			const InternalKey& largest,
+			SequenceNumber global_seqno = 0){
 			FileMetaData f;
 			f.number = file;
 			f.file_size = file_size;
 			f.smallest = smallest;
 			f.largest = largest;
+			f.global_seqno = global_seqno;
 			new_files_.push_back(std::make_pair(level, f));
 		}
 
+		//Delete the specified "file" from the specified "level".
+		void DeleteFile(int level, uint64_t file){
+			deleted_files_.insert(std::make_pair(level, file));
+		}
+
+		void EncodeTo(std::string* dst) const;
+		Status DecodeFrom(const Slice& src);
+
+		std::string DebugString() const;
 
 	private:
 		friend class VersionSet;
@@ -1,9 +1,1591 @@
 #include "version_set.h"
 #include <algorithm>
 #include <stdio.h>
+#include <string.h>
 
+#include "db/external_file.h"
 #include "db/filename.h"
 #include "db/log_reader.h"
+#include "db/log_writer.h"
+#include "db/merge_context.h"
+#include "db/range_del.h"
+#include "db/table_cache.h"
+#include "leveldb/env.h"
+#include "leveldb/pinnable_slice.h"
+#include "leveldb/slice_transform.h"
+#include "table/two_level_iterator.h"
+#include "util/mutexlock.h"
 
+namespace leveldb{
 
+	Version::~Version()
+	{
+		assert(refs_ == 0);
 
+		//Remove from linked list
+		prev_->next_ = next_;
+		next_->prev_ = prev_;
+
+		//Drop references to files
+		for (int level = 0; level < config::kNumLevels; level++)
+		{
+			for (size_t i = 0; i < files_[level].size(); i++)
+			{
+				FileMetaData* f = files_[level][i];
+				assert(f->refs > 0);
+				f->refs--;
+				if (f->refs <= 0)
+				{
+					vset_->table_cache_->Unpin(f);
+					delete f;
+				}
+			}
+		}
+	}
+
+	extern int FindFile(const InternalKeyComparator& icmp,
+		const std::vector<FileMetaData*>& files,
+		const Slice& key)
+	{
+		uint32_t left = 0;
+		uint32_t right = files.size();
+		while (left < right)
+		{
+			uint32_t mid = (left + right) / 2;
+			const FileMetaData* f = files[mid];
+			if (icmp.Compare(f->largest.Encode(), key) < 0)
+			{
+				//Key at "mid.largest" is < "target". Therefore all
+				//files at or before "mid" are uninteresting.
+				left = mid + 1;
+			}
+			else
+			{
+				//Key at "mid.largest" is >= "target". Therefore all files
+				//after "mid" are uninteresting.
+				right = mid;
+			}
+		}
+		return right;
+	}
+
+	static bool AfterFile(const Comparator* ucmp,
+		const Slice* user_key, const FileMetaData* f)
+	{
+		//NULL user_key occurs before all keys and is therefore never after *f
+		return (user_key != NULL &&
+			ucmp->Compare(*user_key, f->largest.user_key()) > 0);
+	}
+
+	static bool BeforeFile(const Comparator* ucmp,
+		const Slice* user_key, const FileMetaData* f)
+	{
+		//NULL user_key occurs after all keys and is therefore never before *f
+		return (user_key != NULL &&
+			ucmp->Compare(*user_key, f->smallest.user_key()) < 0);
+	}
+
+	extern bool SomeFileOverlapsRange(
+		const InternalKeyComparator& icmp,
+		bool disjoint_sorted_files,
+		const std::vector<FileMetaData*>& files,
+		const Slice* smallest_user_key,
+		const Slice* largest_user_key)
+	{
+		const Comparator* ucmp = icmp.user_comparator();
+		if (!disjoint_sorted_files)
+		{
+			//Need to check against all files
+			for (size_t i = 0; i < files.size(); i++)
+			{
+				const FileMetaData* f = files[i];
+				if (AfterFile(ucmp, smallest_user_key, f) ||
+					BeforeFile(ucmp, largest_user_key, f))
+				{
+					//No overlap
+				}
+				else
+				{
+					return true;	//Overlap
+				}
+			}
+			return false;
+		}
+
+		//Binary search over file list
+		uint32_t index = 0;
+		if (smallest_user_key != NULL)
+		{
+			//Find the earliest possible internal key for smallest_user_key
+			InternalKey small(*smallest_user_key, kMaxSequenceNumber, kValueTypeForSeek);
+			index = FindFile(icmp, files, small.Encode());
+		}
+
+		if (index >= files.size())
+		{
+			//beginning of range is after all files, so no overlap.
+			return false;
+		}
+
+		return !BeforeFile(ucmp, largest_user_key, files[index]);
+	}
+
+	static bool NewestFirst(FileMetaData* a, FileMetaData* b)
+	{
+		return a->number > b->number;
+	}
+
+	//Returns false if the prefix filter of file "f" rules out the prefix
+	//of "internal_key" under "prefix_extractor", which applies to internal
+	//keys (see InternalKeySliceTransform).
+	static bool FileMayMatchPrefix(TableCache* table_cache,
+		const ReadOptions& options,
+		const SliceTransform* prefix_extractor,
+		FileMetaData* f,
+		const Slice& internal_key)
+	{
+		if (!prefix_extractor->InDomain(internal_key))
+		{
+			return true;
+		}
+		return table_cache->PrefixMayMatch(options, f,
+			prefix_extractor->Transform(internal_key));
+	}
+
+	//The bounds of a bounded read as internal keys, which is how the files
+	//the DB built compare them: the smallest internal key of a user key
+	//orders every entry for that user key at or after it. Tables apply
+	//ReadOptions bounds in their own key space, so "options" carries these
+	//in place of the user's. Allocated per iterator and freed with it.
+	struct InternalBounds
+	{
+		InternalKey lower;
+		InternalKey upper;
+		Slice lower_key;
+		Slice upper_key;
+		ReadOptions options;
+	};
+
+	//Returns NULL if "options" is unbounded.
+	static InternalBounds* NewInternalBounds(const ReadOptions& options)
+	{
+		if (options.iterate_lower_bound == NULL && options.iterate_upper_bound == NULL)
+		{
+			return NULL;
+		}
+		InternalBounds* b = new InternalBounds;
+		b->options = options;
+		if (options.iterate_lower_bound != NULL)
+		{
+			b->lower = InternalKey(*options.iterate_lower_bound,
+				kMaxSequenceNumber, kValueTypeForSeek);
+			b->lower_key = b->lower.Encode();
+			b->options.iterate_lower_bound = &b->lower_key;
+		}
+		if (options.iterate_upper_bound != NULL)
+		{
+			b->upper = InternalKey(*options.iterate_upper_bound,
+				kMaxSequenceNumber, kValueTypeForSeek);
+			b->upper_key = b->upper.Encode();
+			b->options.iterate_upper_bound = &b->upper_key;
+		}
+		return b;
+	}
+
+	static void DeleteInternalBounds(void* arg1, void* arg2)
+	{
+		delete reinterpret_cast<InternalBounds*>(arg1);
+	}
+
+	//Ingested files hold user keys, for which the level iterators have
+	//already pruned by the bounds.
+	static ReadOptions UnboundedOptions(const ReadOptions& options)
+	{
+		ReadOptions result = options;
+		result.iterate_lower_bound = NULL;
+		result.iterate_upper_bound = NULL;
+		return result;
+	}
+
+	//An internal iterator. For a given version/level pair, yields
+	//information about the files in the level. For a given entry, key()
+	//is the largest key that occurs in the file, and value() holds the
+	//file's FileMetaData*, copied in with memcpy. The version being
+	//iterated keeps the FileMetaData alive.
+	//
+	//For a prefix_same_as_start read, a Seek() that lands on a file whose
+	//prefix filter rules out the target's prefix leaves the iterator
+	//invalid: every later file in the level starts past that prefix, so
+	//the level has nothing to yield for it.
+	//
+	//For a bounded read (whose bounds in "options" are internal keys, see
+	//InternalBounds) it never moves onto a file that lies wholly outside
+	//the bounds, so such files are not even opened.
+	class Version::LevelFileNumIterator :public Iterator{
+	public:
+		LevelFileNumIterator(const InternalKeyComparator& icmp,
+			const std::vector<FileMetaData*>* flist,
+			TableCache* table_cache,
+			const ReadOptions& options,
+			const SliceTransform* prefix_extractor)
+			:icmp_(icmp),
+			flist_(flist),
+			index_(flist->size()),	//Marks as invalid
+			table_cache_(table_cache),
+			options_(options),
+			prefix_extractor_(prefix_extractor)
+		{
+
+		}
+		virtual bool Valid() const {
+			return index_ < flist_->size();
+		}
+		virtual void Seek(const Slice& target) {
+			const Slice* lower = options_.iterate_lower_bound;
+			index_ = FindFile(icmp_, *flist_,
+				(lower != NULL && icmp_.Compare(target, *lower) < 0) ? *lower : target);
+			CheckUpperBound();
+			if (prefix_extractor_ != NULL && Valid() &&
+				!FileMayMatchPrefix(table_cache_, options_, prefix_extractor_,
+				(*flist_)[index_], target))
+			{
+				index_ = flist_->size();
+			}
+			if (Valid())
+			{
+				(*flist_)[index_]->read_stats.seeks.Add(1);
+			}
+		}
+		virtual void SeekToFirst() {
+			const Slice* lower = options_.iterate_lower_bound;
+			index_ = (lower != NULL) ? FindFile(icmp_, *flist_, *lower) : 0;
+			CheckUpperBound();
+		}
+		virtual void SeekToLast() {
+			const Slice* upper = options_.iterate_upper_bound;
+			index_ = flist_->size();
+			if (upper != NULL)
+			{
+				//The first file ending at or past the bound may still start
+				//before it.
+				index_ = FindFile(icmp_, *flist_, *upper);
+				if (index_ < flist_->size() &&
+					icmp_.Compare((*flist_)[index_]->smallest.Encode(), *upper) < 0)
+				{
+					CheckLowerBound();
+					return;
+				}
+			}
+			index_ = (index_ == 0) ? flist_->size() : index_ - 1;
+			CheckLowerBound();
+		}
+		virtual void Next() {
+			assert(Valid());
+			index_++;
+			CheckUpperBound();
+		}
+		virtual void Prev() {
+			assert(Valid());
+			if (index_ == 0)
+			{
+				index_ = flist_->size();	//Marks as invalid
+			}
+			else
+			{
+				index_--;
+				CheckLowerBound();
+			}
+		}
+		Slice key() const {
+			assert(Valid());
+			return (*flist_)[index_]->largest.Encode();
+		}
+		Slice value() const {
+			assert(Valid());
+			FileMetaData* f = (*flist_)[index_];
+			memcpy(value_buf_, &f, sizeof(f));
+			return Slice(value_buf_, sizeof(value_buf_));
+		}
+		virtual Status status() const { return Status::OK(); }
+	private:
+		//Invalidate the iterator if the current file starts at or past the
+		//upper bound.
+		void CheckUpperBound() {
+			const Slice* upper = options_.iterate_upper_bound;
+			if (upper != NULL && Valid() &&
+				icmp_.Compare((*flist_)[index_]->smallest.Encode(), *upper) >= 0)
+			{
+				index_ = flist_->size();
+			}
+		}
+
+		//Invalidate the iterator if the current file ends before the lower
+		//bound.
+		void CheckLowerBound() {
+			const Slice* lower = options_.iterate_lower_bound;
+			if (lower != NULL && Valid() &&
+				icmp_.Compare((*flist_)[index_]->largest.Encode(), *lower) < 0)
+			{
+				index_ = flist_->size();
+			}
+		}
+
+		const InternalKeyComparator icmp_;
+		const std::vector<FileMetaData*>* const flist_;
+		uint32_t index_;
+		TableCache* const table_cache_;
+		const ReadOptions options_;
+		const SliceTransform* const prefix_extractor_;	//NULL unless skipping by prefix
+
+		//Backing store for value(). Holds the FileMetaData*, which the
+		//version being iterated keeps alive.
+		mutable char value_buf_[sizeof(FileMetaData*)];
+	};
+
+	namespace {
+		//Iterator over one level-0 file. Counts Seek() calls in the file's
+		//read stats. For a prefix_same_as_start read ("prefix_extractor"
+		//non-NULL), a Seek() whose prefix the file's prefix filter rules
+		//out leaves it invalid without reading any block of the file.
+		class Level0FileIterator :public Iterator{
+		public:
+			Level0FileIterator(Iterator* iter, TableCache* table_cache,
+				const ReadOptions& options,
+				const SliceTransform* prefix_extractor,
+				FileMetaData* f)
+				:iter_(iter),
+				table_cache_(table_cache),
+				options_(options),
+				prefix_extractor_(prefix_extractor),
+				file_(f),
+				skipped_(false)
+			{
+
+			}
+			virtual ~Level0FileIterator() { delete iter_; }
+			virtual bool Valid() const { return !skipped_ && iter_->Valid(); }
+			virtual void Seek(const Slice& target) {
+				skipped_ = prefix_extractor_ != NULL &&
+					!FileMayMatchPrefix(table_cache_, options_,
+					prefix_extractor_, file_, target);
+				if (!skipped_)
+				{
+					iter_->Seek(target);
+					if (iter_->Valid())
+					{
+						file_->read_stats.seeks.Add(1);
+					}
+				}
+			}
+			virtual void SeekToFirst() { skipped_ = false; iter_->SeekToFirst(); }
+			virtual void SeekToLast() { skipped_ = false; iter_->SeekToLast(); }
+			virtual void Next() { assert(Valid()); iter_->Next(); }
+			virtual void Prev() { assert(Valid()); iter_->Prev(); }
+			virtual Slice key() const { assert(Valid()); return iter_->key(); }
+			virtual Slice value() const { assert(Valid()); return iter_->value(); }
+			virtual Status status() const { return iter_->status(); }
+		private:
+			Iterator* const iter_;
+			TableCache* const table_cache_;
+			const ReadOptions options_;
+			const SliceTransform* const prefix_extractor_;	//May be NULL
+			FileMetaData* const file_;
+			bool skipped_;	//Last Seek() was ruled out by the prefix filter
+		};
+	}
+
+	Iterator* Version::GetFileIterator(void* arg,
+		const ReadOptions& options,
+		const Slice& file_value)
+	{
+		VersionSet* vset = reinterpret_cast<VersionSet*>(arg);
+		FileMetaData* f;
+		if (file_value.size() != sizeof(f))
+		{
+			return NewErrorIterator(
+				Status::Corruption("FileReader invoked with unexpected value"));
+		}
+		memcpy(&f, file_value.data(), sizeof(f));
+		if (f->global_seqno != 0)
+		{
+			//Ingested file: its entries carry plain user keys.
+			Iterator* iter = vset->table_cache_->NewIterator(UnboundedOptions(options), f);
+			return NewGlobalSeqnoIterator(iter, f->global_seqno, vset->icmp_.user_comparator());
+		}
+		return vset->table_cache_->NewIterator(options, f);
+	}
+
+	//Returns the prefix extractor to skip files with, or NULL if "options"
+	//does not ask for it.
+	static const SliceTransform* SeekPrefixExtractor(const Options* db_options,
+		const ReadOptions& options)
+	{
+		return options.prefix_same_as_start ? db_options->prefix_extractor : NULL;
+	}
+
+	Iterator* Version::NewConcatenatingIterator(const ReadOptions& options,
+		int level) const
+	{
+		InternalBounds* bounds = NewInternalBounds(options);
+		const ReadOptions& file_options = (bounds != NULL) ? bounds->options : options;
+		Iterator* result = NewTwoLevelIterator(
+			new LevelFileNumIterator(vset_->icmp_, &files_[level], vset_->table_cache_,
+			file_options, SeekPrefixExtractor(vset_->options_, options)),
+			&GetFileIterator, vset_, file_options);
+		if (bounds != NULL)
+		{
+			result->RegisterCleanup(&DeleteInternalBounds, bounds, NULL);
+		}
+		return result;
+	}
+
+	void Version::AddIterators(const ReadOptions& options,
+		std::vector<Iterator*>* iters)
+	{
+		const SliceTransform* prefix_extractor = SeekPrefixExtractor(vset_->options_, options);
+		const Comparator* ucmp = vset_->icmp_.user_comparator();
+
+		//Merge all level zero files together since they may overlap
+		for (size_t i = 0; i < files_[0].size(); i++)
+		{
+			FileMetaData* f = files_[0][i];
+			//Skip files wholly outside the bounds
+			if ((options.iterate_lower_bound != NULL &&
+				ucmp->Compare(f->largest.user_key(), *options.iterate_lower_bound) < 0) ||
+				(options.iterate_upper_bound != NULL &&
+				ucmp->Compare(f->smallest.user_key(), *options.iterate_upper_bound) >= 0))
+			{
+				continue;
+			}
+
+			Iterator* iter;
+			if (f->global_seqno != 0)
+			{
+				iter = vset_->table_cache_->NewIterator(
+					UnboundedOptions(options), f);
+				iter = NewGlobalSeqnoIterator(iter, f->global_seqno, ucmp);
+			}
+			else
+			{
+				InternalBounds* bounds = NewInternalBounds(options);
+				iter = vset_->table_cache_->NewIterator(
+					(bounds != NULL) ? bounds->options : options, f);
+				if (bounds != NULL)
+				{
+					iter->RegisterCleanup(&DeleteInternalBounds, bounds, NULL);
+				}
+			}
+			iters->push_back(new Level0FileIterator(iter, vset_->table_cache_,
+				options, prefix_extractor, f));
+		}
+
+		//For levels > 0, we can use a concatenating iterator that sequentially
+		//walks through the non-overlapping files in the level, opening them
+		//lazily.
+		for (int level = 1; level < config::kNumLevels; level++)
+		{
+			if (!files_[level].empty())
+			{
+				iters->push_back(NewConcatenatingIterator(options, level));
+			}
+		}
+	}
+
+	namespace{
+
+		//State of a Version::Get() lookup in one file, passed through
+		//TableCache::Get().
+		struct Saver
+		{
+			Slice user_key;
+			SequenceNumber global_seqno;	//Of an ingested file, else 0
+			SequenceNumber max_covering_tombstone_seq;
+			PinnableSlice* value;
+			MergeContext* merge_context;
+			Status* s;
+			bool done;	//The lookup is decided
+		};
+
+	}
+
+	//Entries for one user key are ordered by decreasing sequence number,
+	//so any merge operands come before the value or deletion they apply to.
+	//Once the lookup is decided sets saver->done: *value holds the
+	//(possibly merged) value, pinned in its block if plain, or *s holds
+	//NotFound() or an error. Returns false when done or once the user key
+	//changes, leaving older files to settle a run of merge operands.
+	static bool SaveValue(void* arg, const Slice& key, const Slice& v,
+		Table::BlockPin* pin)
+	{
+		Saver* saver = reinterpret_cast<Saver*>(arg);
+		ParsedInternalKey parsed_key;
+		if (saver->global_seqno != 0)
+		{
+			//Ingested file: its entries carry plain user keys.
+			parsed_key = ParsedInternalKey(key, saver->global_seqno, kTypeValue);
+		}
+		else if (!ParseInternalKey(key, &parsed_key))
+		{
+			*saver->s = Status::Corruption("corrupted key for ", saver->user_key);
+			saver->done = true;
+			return false;
+		}
+		if (parsed_key.user_key != saver->user_key)
+		{
+			return false;
+		}
+		if (parsed_key.sequence < saver->max_covering_tombstone_seq)
+		{
+			//A newer range tombstone covers this entry.
+			parsed_key.type = kTypeDeletion;
+		}
+		PinnableSlice* value = saver->value;
+		MergeContext* merge_context = saver->merge_context;
+		switch (parsed_key.type)
+		{
+		case kTypeDeletion:
+			if (merge_context->HasOperands())
+			{
+				*saver->s = merge_context->Finish(saver->user_key, NULL, value->GetSelf());
+				value->PinSelf();
+			}
+			else
+			{
+				*saver->s = Status::NotFound(Slice());	//Use an empty error message for speed
+			}
+			saver->done = true;
+			return false;
+		case kTypeValue:
+			if (merge_context->HasOperands())
+			{
+				*saver->s = merge_context->Finish(saver->user_key, &v, value->GetSelf());
+				value->PinSelf();
+			}
+			else
+			{
+				value->PinSlice(v, pin->release, pin->arg1, pin->arg2);
+				pin->taken = true;
+			}
+			saver->done = true;
+			return false;
+		case kTypeMerge:
+			merge_context->PushOlderOperand(saver->user_key, v);
+			break;
+		case kTypeRangeDeletion:
+			//Range tombstones live in their own meta block.
+			break;
+		}
+		return true;
+	}
+
+	Status Version::Get(const ReadOptions& options,
+		const LookupKey& k,
+		PinnableSlice* value,
+		GetStats* stats,
+		MergeContext* merge_context,
+		SequenceNumber* max_covering_tombstone_seq)
+	{
+		Slice ikey = k.internal_key();
+		Slice user_key = k.user_key();
+		const Comparator* ucmp = vset_->icmp_.user_comparator();
+		Status s;
+		//Iteration bounds do not apply to point lookups.
+		const ReadOptions file_options = UnboundedOptions(options);
+
+		stats->seek_file = NULL;
+		stats->seek_file_level = -1;
+		FileMetaData* last_file_read = NULL;
+		int last_file_read_level = -1;
+
+		//We can search level-by-level since entries never hop across
+		//levels. Therefore we are guaranteed that if we find data
+		//in an smaller level, later levels are irrelevant.
+		//Level-0 candidates are collected on the stack unless unusually
+		//many level-0 files exist, so that a lookup does not allocate.
+		FileMetaData* tmp_space[config::kL0_StopWritesTrigger];
+		std::vector<FileMetaData*> tmp_overflow;
+		FileMetaData* tmp2;
+		//Range of files to search in the next level, narrowed by the file
+		//examined in the current one (see FileIndexer).
+		const uint64_t key_prefix = file_indexer_.KeyPrefix(user_key);
+		int32_t search_left = 0;
+		int32_t search_right = FileIndexer::kLevelMaxIndex;
+		for (int level = 0; level < config::kNumLevels; level++)
+		{
+			size_t num_files = files_[level].size();
+			if (num_files == 0)
+			{
+				search_left = 0;
+				search_right = FileIndexer::kLevelMaxIndex;
+				continue;
+			}
+
+			//Get the list of files to search in this level
+			FileMetaData* const* files = &files_[level][0];
+			if (level == 0)
+			{
+				//Level-0 files may overlap each other. Find all files that
+				//overlap user_key and process them in order from newest to oldest.
+				FileMetaData** tmp = tmp_space;
+				if (num_files > config::kL0_StopWritesTrigger)
+				{
+					tmp_overflow.resize(num_files);
+					tmp = &tmp_overflow[0];
+				}
+				size_t num_tmp = 0;
+				for (uint32_t i = 0; i < num_files; i++)
+				{
+					FileMetaData* f = files[i];
+					if (ucmp->Compare(user_key, f->smallest.user_key()) >= 0 &&
+						ucmp->Compare(user_key, f->largest.user_key()) <= 0)
+					{
+						tmp[num_tmp++] = f;
+					}
+				}
+				if (num_tmp == 0) continue;
+
+				std::sort(tmp, tmp + num_tmp, NewestFirst);
+				files = tmp;
+				num_files = num_tmp;
+			}
+			else
+			{
+				//Binary search to find earliest index whose largest key >= ikey,
+				//among the files the level above left possible.
+				const int32_t index = file_indexer_.LocateFile(level, user_key,
+					key_prefix, ikey, &search_left, &search_right);
+				if (index < 0)
+				{
+					continue;
+				}
+				tmp2 = files_[level][index];
+				files = &tmp2;
+				num_files = 1;
+			}
+
+			for (uint32_t i = 0; i < num_files; ++i)
+			{
+				FileMetaData* f = files[i];
+				if (f->global_seqno > k.sequence())
+				{
+					//Ingested after the lookup's snapshot
+					continue;
+				}
+
+				if (last_file_read != NULL && stats->seek_file == NULL)
+				{
+					//We have had more than one seek for this read. Charge the 1st file.
+					last_file_read->read_stats.misses.Add(1);
+					stats->seek_file = last_file_read;
+					stats->seek_file_level = last_file_read_level;
+				}
+
+				f->read_stats.gets.Add(1);
+				last_file_read = f;
+				last_file_read_level = level;
+
+				Iterator* tombstones = vset_->table_cache_->NewRangeTombstoneIterator(
+					file_options, f);
+				if (tombstones != NULL)
+				{
+					SequenceNumber covering = MaxCoveringTombstoneSeq(tombstones,
+						ucmp, user_key, k.sequence());
+					delete tombstones;
+					if (covering > *max_covering_tombstone_seq)
+					{
+						*max_covering_tombstone_seq = covering;
+					}
+				}
+
+				Saver saver;
+				saver.user_key = user_key;
+				saver.global_seqno = f->global_seqno;
+				saver.max_covering_tombstone_seq = *max_covering_tombstone_seq;
+				saver.value = value;
+				saver.merge_context = merge_context;
+				saver.s = &s;
+				saver.done = false;
+				//Ingested files hold plain user keys, all at global_seqno.
+				Status read = vset_->table_cache_->Get(file_options, f,
+					f->global_seqno != 0 ? user_key : ikey, &saver, &SaveValue);
+				if (!read.ok())
+				{
+					return read;
+				}
+				if (saver.done)
+				{
+					return s;
+				}
+			}
+		}
+
+		if (merge_context->HasOperands())
+		{
+			//Only merge operands exist for this key; fold them onto an
+			//empty base value.
+			s = merge_context->Finish(user_key, NULL, value->GetSelf());
+			value->PinSelf();
+			return s;
+		}
+		return Status::NotFound(Slice());	//Use an empty error message for speed
+	}
+
+	bool Version::UpdateStats(const GetStats& stats)
+	{
+		FileMetaData* f = stats.seek_file;
+		if (f != NULL && file_to_compact_ == NULL &&
+			f->read_stats.misses.Load() >= f->allowed_seeks)
+		{
+			file_to_compact_ = f;
+			file_to_compact_level_ = stats.seek_file_level;
+			return true;
+		}
+		return false;
+	}
+
+	bool Version::OverlapInLevel(int level,
+		const Slice* smallest_user_key,
+		const Slice* largest_user_key)
+	{
+		return SomeFileOverlapsRange(vset_->icmp_, (level > 0), files_[level],
+			smallest_user_key, largest_user_key);
+	}
+
+	int Version::PickLevelForExternalFile(const Slice& smallest_user_key,
+		const Slice& largest_user_key)
+	{
+		//The ingested file is newer than everything in the version, so it
+		//must sit above every file it overlaps. Unlike a memtable output
+		//it is not capped at kMaxMemCompactLevel: bulk loads go straight to
+		//the deepest level that is free, where they will not be rewritten.
+		int level = 0;
+		if (!OverlapInLevel(0, &smallest_user_key, &largest_user_key))
+		{
+			while (level + 1 < config::kNumLevels &&
+				!OverlapInLevel(level + 1, &smallest_user_key, &largest_user_key))
+			{
+				level++;
+			}
+		}
+		return level;
+	}
+
+	void Version::GetFilesCoveredByRange(int level,
+		const Slice& begin, const Slice& end,
+		std::vector<std::pair<int, FileMetaData*> >* covered)
+	{
+		const Comparator* ucmp = vset_->icmp_.user_comparator();
+		covered->clear();
+		for (int which = level + 1; which < config::kNumLevels; which++)
+		{
+			const std::vector<FileMetaData*>& files = files_[which];
+			for (size_t i = 0; i < files.size(); i++)
+			{
+				FileMetaData* f = files[i];
+				if (TombstoneCoversRange(ucmp, begin, end,
+					f->smallest.user_key(), f->largest.user_key()))
+				{
+					covered->push_back(std::make_pair(which, f));
+				}
+			}
+		}
+	}
+
+	void Version::Ref()
+	{
+		++refs_;
+	}
+
+	void Version::Unref()
+	{
+		assert(this != &vset_->dummy_versions_);
+		assert(refs_ >= 1);
+		--refs_;
+		if (refs_ == 0)
+		{
+			delete this;
+		}
+	}
+
+	static double MaxBytesForLevel(int level)
+	{
+		//Note: the result for level zero is not really used since we set
+		//the level-0 compaction threshold based on number of files.
+		double result = 10 * 1048576.0;	//Result for both level-0 and level-1
+		while (level > 1)
+		{
+			result *= 10;
+			level--;
+		}
+		return result;
+	}
+
+	static int64_t TotalFileSize(const std::vector<FileMetaData*>& files)
+	{
+		int64_t sum = 0;
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			sum += files[i]->file_size;
+		}
+		return sum;
+	}
+
+	//A helper class so we can efficiently apply a whole sequence
+	//of edits to a particular state without creating intermediate
+	//Versions that contain full copies of the intermediate state.
+	class VersionSet::Builder
+	{
+	private:
+		//Helper to sort by v->files_[file_number].smallest
+		struct BySmallestKey
+		{
+			const InternalKeyComparator* internal_comparator;
+
+			bool operator()(FileMetaData* f1, FileMetaData* f2) const
+			{
+				int r = internal_comparator->Compare(f1->smallest, f2->smallest);
+				if (r != 0)
+				{
+					return (r < 0);
+				}
+				else
+				{
+					//Break ties by file number
+					return (f1->number < f2->number);
+				}
+			}
+		};
+
+		typedef std::set<FileMetaData*, BySmallestKey> FileSet;
+		struct LevelState
+		{
+			std::set<uint64_t> deleted_files;
+			FileSet* added_files;
+		};
+
+		VersionSet* vset_;
+		Version* base_;
+		LevelState levels_[config::kNumLevels];
+
+	public:
+		//Initialize a builder with the files from *base and other info from *vset
+		Builder(VersionSet* vset, Version* base)
+			:vset_(vset),
+			base_(base)
+		{
+			base_->Ref();
+			BySmallestKey cmp;
+			cmp.internal_comparator = &vset_->icmp_;
+			for (int level = 0; level < config::kNumLevels; level++)
+			{
+				levels_[level].added_files = new FileSet(cmp);
+			}
+		}
+
+		~Builder()
+		{
+			for (int level = 0; level < config::kNumLevels; level++)
+			{
+				const FileSet* added = levels_[level].added_files;
+				std::vector<FileMetaData*> to_unref;
+				to_unref.reserve(added->size());
+				for (FileSet::const_iterator it = added->begin();
+					it != added->end(); ++it)
+				{
+					to_unref.push_back(*it);
+				}
+				delete added;
+				for (size_t i = 0; i < to_unref.size(); i++)
+				{
+					FileMetaData* f = to_unref[i];
+					f->refs--;
+					if (f->refs <= 0)
+					{
+						delete f;
+					}
+				}
+			}
+			base_->Unref();
+		}
+
+		//Apply all of the edits in *edit to the current state.
+		void Apply(VersionEdit* edit)
+		{
+			//Update compaction pointers
+			for (size_t i = 0; i < edit->compact_pointers_.size(); i++)
+			{
+				const int level = edit->compact_pointers_[i].first;
+				vset_->compact_pointer_[level] =
+					edit->compact_pointers_[i].second.Encode().ToString();
+			}
+
+			//Delete files
+			const VersionEdit::DeletedFileSet& del = edit->deleted_files_;
+			for (VersionEdit::DeletedFileSet::const_iterator iter = del.begin();
+				iter != del.end(); ++iter)
+			{
+				const int level = iter->first;
+				const uint64_t number = iter->second;
+				levels_[level].deleted_files.insert(number);
+			}
+
+			//Add new files
+			for (size_t i = 0; i < edit->new_files_.size(); i++)
+			{
+				const int level = edit->new_files_[i].first;
+				FileMetaData* f = new FileMetaData(edit->new_files_[i].second);
+				f->refs = 1;
+
+				//We arrange to automatically compact this file after a
+				//certain number of read misses (see
+				//Options::read_compaction_bytes_per_miss).
+				f->allowed_seeks = vset_->AllowedReadMisses(f->file_size);
+
+				levels_[level].deleted_files.erase(f->number);
+				levels_[level].added_files->insert(f);
+			}
+		}
+
+		//Save the current state in *v.
+		void SaveTo(Version* v)
+		{
+			BySmallestKey cmp;
+			cmp.internal_comparator = &vset_->icmp_;
+			for (int level = 0; level < config::kNumLevels; level++)
+			{
+				//Merge the set of added files with the set of pre-existing files.
+				//Drop any deleted files. Store the result in *v.
+				const std::vector<FileMetaData*>& base_files = base_->files_[level];
+				std::vector<FileMetaData*>::const_iterator base_iter = base_files.begin();
+				std::vector<FileMetaData*>::const_iterator base_end = base_files.end();
+				const FileSet* added = levels_[level].added_files;
+				v->files_[level].reserve(base_files.size() + added->size());
+				for (FileSet::const_iterator added_iter = added->begin();
+					added_iter != added->end(); ++added_iter)
+				{
+					//Add all smaller files listed in base_
+					for (std::vector<FileMetaData*>::const_iterator bpos
+						= std::upper_bound(base_iter, base_end, *added_iter, cmp);
+						base_iter != bpos; ++base_iter)
+					{
+						MaybeAddFile(v, level, *base_iter);
+					}
+
+					MaybeAddFile(v, level, *added_iter);
+				}
+
+				//Add remaining base files
+				for (; base_iter != base_end; ++base_iter)
+				{
+					MaybeAddFile(v, level, *base_iter);
+				}
+			}
+		}
+
+		void MaybeAddFile(Version* v, int level, FileMetaData* f)
+		{
+			if (levels_[level].deleted_files.count(f->number) > 0)
+			{
+				//File is deleted: do nothing
+			}
+			else
+			{
+				std::vector<FileMetaData*>* files = &v->files_[level];
+				if (level > 0 && !files->empty())
+				{
+					//Must not overlap
+					assert(vset_->icmp_.Compare((*files)[files->size() - 1]->largest,
+						f->smallest) < 0);
+				}
+				f->refs++;
+				files->push_back(f);
+			}
+		}
+	};
+
+	int VersionSet::AllowedReadMisses(uint64_t file_size) const
+	{
+		const uint64_t bytes_per_miss = options_->read_compaction_bytes_per_miss;
+		if (bytes_per_miss == 0)
+		{
+			return 1 << 30;	//Never
+		}
+		const uint64_t misses = file_size / bytes_per_miss;
+		if (misses < static_cast<uint64_t>(options_->read_compaction_min_misses))
+		{
+			return options_->read_compaction_min_misses;
+		}
+		return misses < (1 << 30) ? static_cast<int>(misses) : (1 << 30);
+	}
+
+	VersionSet::VersionSet(const std::string& dbname,
+		const Options* options,
+		TableCache* table_cache,
+		const InternalKeyComparator* cmp)
+		:env_(options->env),
+		dbname_(dbname),
+		options_(options),
+		table_cache_(table_cache),
+		icmp_(*cmp),
+		next_file_number_(2),
+		manifest_file_number_(0),	//Filled by Recover()
+		last_sequence_(0),
+		log_number_(0),
+		prev_log_number_(0),
+		descriptor_file_(NULL),
+		descriptor_log_(NULL),
+		manifest_file_size_(0),
+		manifest_snapshot_size_(0),
+		dummy_versions_(this),
+		current_(NULL)
+	{
+		AppendVersion(new Version(this));
+	}
+
+	VersionSet::~VersionSet()
+	{
+		current_->Unref();
+		assert(dummy_versions_.next_ == &dummy_versions_);	//List must be empty
+		delete descriptor_log_;
+		delete descriptor_file_;
+	}
+
+	void VersionSet::AppendVersion(Version* v)
+	{
+		//Make "v" current
+		assert(v->refs_ == 0);
+		assert(v != current_);
+		if (current_ != NULL)
+		{
+			current_->Unref();
+		}
+		current_ = v;
+		v->Ref();
+
+		//Append to linked list
+		v->prev_ = dummy_versions_.prev_;
+		v->next_ = &dummy_versions_;
+		v->prev_->next_ = v;
+		v->next_->prev_ = v;
+	}
+
+	bool VersionSet::ManifestNeedsRollover() const
+	{
+		//Requiring the edits to outweigh the snapshot keeps a DB whose live
+		//file list alone exceeds the limit from rolling over on every edit.
+		return descriptor_log_ != NULL &&
+			manifest_file_size_ >= options_->max_manifest_file_size &&
+			manifest_file_size_ >= 2 * manifest_snapshot_size_;
+	}
+
+	Status VersionSet::LogAndApply(VersionEdit* edit, port::Mutex* mu)
+	{
+		//Roll over to a new MANIFEST before recording the next file number,
+		//so that recovery never hands out the new MANIFEST's number again.
+		uint64_t old_manifest_file_number = 0;
+		WritableFile* old_descriptor_file = NULL;
+		log::Writer* old_descriptor_log = NULL;
+		const uint64_t old_manifest_file_size = manifest_file_size_;
+		const uint64_t old_manifest_snapshot_size = manifest_snapshot_size_;
+		if (ManifestNeedsRollover())
+		{
+			old_manifest_file_number = manifest_file_number_;
+			old_descriptor_file = descriptor_file_;
+			old_descriptor_log = descriptor_log_;
+			descriptor_file_ = NULL;
+			descriptor_log_ = NULL;
+			manifest_file_number_ = NewFileNumber();
+		}
+
+		if (edit->has_log_number_)
+		{
+			assert(edit->log_number_ >= log_number_);
+			assert(edit->log_number_ < next_file_number_);
+		}
+		else
+		{
+			edit->SetLogNumber(log_number_);
+		}
+
+		if (!edit->has_prev_log_number_)
+		{
+			edit->SetPrevLogNumber(prev_log_number_);
+		}
+
+		edit->setNextFile(next_file_number_);
+		edit->SetLastSequence(last_sequence_);
+
+		Version* v = new Version(this);
+		{
+			Builder builder(this, current_);
+			builder.Apply(edit);
+			builder.SaveTo(v);
+		}
+		Finalize(v);
+
+		//Initialize new descriptor log file if necessary by creating
+		//a temporary file that contains a snapshot of the current version.
+		std::string new_manifest_file;
+		Status s;
+		if (descriptor_log_ == NULL)
+		{
+			//No reason to unlock *mu here since we only hit this path in the
+			//first call to LogAndApply (when opening the database) and on the
+			//rare rollover, which must snapshot exactly the current version.
+			assert(descriptor_file_ == NULL);
+			new_manifest_file = DescriptorFileName(dbname_, manifest_file_number_);
+			s = env_->NewWritableFile(new_manifest_file, &descriptor_file_);
+			if (s.ok())
+			{
+				descriptor_log_ = new log::Writer(descriptor_file_);
+				manifest_file_size_ = 0;
+				s = WriteSnapshot(descriptor_log_);
+				manifest_snapshot_size_ = manifest_file_size_;
+			}
+		}
+
+		//Unlock during expensive MANIFEST log write
+		{
+			mu->Unlock();
+
+			//Write new record to MANIFEST log
+			if (s.ok())
+			{
+				std::string record;
+				edit->EncodeTo(&record);
+				s = descriptor_log_->AddRecord(record);
+				if (s.ok())
+				{
+					manifest_file_size_ += log::kHeaderSize + record.size();
+					s = descriptor_file_->Sync();
+				}
+				if (!s.ok())
+				{
+					Log(options_->info_log, "MANIFEST write: %s\n", s.ToString().c_str());
+				}
+			}
+
+			//If we just created a new descriptor file, install it by writing a
+			//new CURRENT file that points to it. The rename inside
+			//SetCurrentFile() makes the switch atomic: a crash leaves CURRENT
+			//naming either the old, still complete, MANIFEST or the new one.
+			if (s.ok() && !new_manifest_file.empty())
+			{
+				s = SetCurrentFile(env_, dbname_, manifest_file_number_);
+			}
+
+			mu->Lock();
+		}
+
+		//Install the new version
+		if (s.ok())
+		{
+			AppendVersion(v);
+			log_number_ = edit->log_number_;
+			prev_log_number_ = edit->prev_log_number_;
+			if (old_descriptor_log != NULL)
+			{
+				Log(options_->info_log, "MANIFEST #%llu reached %llu bytes; "
+					"switched to #%llu of %llu bytes\n",
+					static_cast<unsigned long long>(old_manifest_file_number),
+					static_cast<unsigned long long>(old_manifest_file_size),
+					static_cast<unsigned long long>(manifest_file_number_),
+					static_cast<unsigned long long>(manifest_file_size_));
+				delete old_descriptor_log;
+				delete old_descriptor_file;
+				env_->DeleteFile(DescriptorFileName(dbname_, old_manifest_file_number));
+			}
+		}
+		else
+		{
+			delete v;
+			if (!new_manifest_file.empty())
+			{
+				delete descriptor_log_;
+				delete descriptor_file_;
+				descriptor_log_ = NULL;
+				descriptor_file_ = NULL;
+				env_->DeleteFile(new_manifest_file);
+			}
+			if (old_descriptor_log != NULL)
+			{
+				//CURRENT still names the old MANIFEST; keep appending to it.
+				descriptor_log_ = old_descriptor_log;
+				descriptor_file_ = old_descriptor_file;
+				manifest_file_number_ = old_manifest_file_number;
+				manifest_file_size_ = old_manifest_file_size;
+				manifest_snapshot_size_ = old_manifest_snapshot_size;
+			}
+		}
+
+		return s;
+	}
+
+	namespace {
+		struct LogReporter :public log::Reader::Reporter
+		{
+			Status* status;
+			virtual void Corruption(size_t bytes, const Status& s)
+			{
+				if (this->status->ok())
+				{
+					*this->status = s;
+				}
+			}
+		};
+	}
+
+	Status VersionSet::Recover()
+	{
+		//Read "CURRENT" file, which contains a pointer to the current manifest file
+		std::string current;
+		Status s = ReadFileToString(env_, CurrentFileName(dbname_), &current);
+		if (!s.ok())
+		{
+			return s;
+		}
+		if (current.empty() || current[current.size() - 1] != '\n')
+		{
+			return Status::Corruption("CURRENT file does not end with newline");
+		}
+		current.resize(current.size() - 1);
+
+		std::string dscname = dbname_ + "/" + current;
+		SequentialFile* file;
+		s = env_->NewSequentialFile(dscname, &file);
+		if (!s.ok())
+		{
+			return s;
+		}
+
+		bool have_log_number = false;
+		bool have_prev_log_number = false;
+		bool have_next_file = false;
+		bool have_last_sequence = false;
+		uint64_t next_file = 0;
+		uint64_t last_sequence = 0;
+		uint64_t log_number = 0;
+		uint64_t prev_log_number = 0;
+		Builder builder(this, current_);
+
+		{
+			LogReporter reporter;
+			reporter.status = &s;
+			log::Reader reader(file, &reporter, true/*checksum*/, 0/*initial_offset*/);
+			Slice record;
+			std::string scratch;
+			while (reader.ReadRecord(&record, &scratch) && s.ok())
+			{
+				VersionEdit edit;
+				s = edit.DecodeFrom(record);
+				if (s.ok())
+				{
+					if (edit.has_comparator_ &&
+						edit.comparator_ != icmp_.user_comparator()->Name())
+					{
+						s = Status::InvalidArgument(
+							edit.comparator_ + " does not match existing comparator ",
+							icmp_.user_comparator()->Name());
+					}
+				}
+
+				if (s.ok())
+				{
+					builder.Apply(&edit);
+				}
+
+				if (edit.has_log_number_)
+				{
+					log_number = edit.log_number_;
+					have_log_number = true;
+				}
+
+				if (edit.has_prev_log_number_)
+				{
+					prev_log_number = edit.prev_log_number_;
+					have_prev_log_number = true;
+				}
+
+				if (edit.has_next_file_number_)
+				{
+					next_file = edit.next_file_number_;
+					have_next_file = true;
+				}
+
+				if (edit.has_last_sequence_)
+				{
+					last_sequence = edit.last_sequence_;
+					have_last_sequence = true;
+				}
+			}
+		}
+		delete file;
+		file = NULL;
+
+		if (s.ok())
+		{
+			if (!have_next_file)
+			{
+				s = Status::Corruption("no meta-nextfile entry in descriptor");
+			}
+			else if (!have_log_number)
+			{
+				s = Status::Corruption("no meta-lognumber entry in descriptor");
+			}
+			else if (!have_last_sequence)
+			{
+				s = Status::Corruption("no last-sequence-number entry in descriptor");
+			}
+
+			if (!have_prev_log_number)
+			{
+				prev_log_number = 0;
+			}
+
+			MarkFileNumberUsed(prev_log_number);
+			MarkFileNumberUsed(log_number);
+		}
+
+		if (s.ok())
+		{
+			Version* v = new Version(this);
+			builder.SaveTo(v);
+			//Install recovered version
+			Finalize(v);
+			AppendVersion(v);
+			manifest_file_number_ = next_file;
+			next_file_number_ = next_file + 1;
+			last_sequence_ = last_sequence;
+			log_number_ = log_number;
+			prev_log_number_ = prev_log_number;
+		}
+
+		return s;
+	}
+
+	void VersionSet::MarkFileNumberUsed(uint64_t number)
+	{
+		if (next_file_number_ <= number)
+		{
+			next_file_number_ = number + 1;
+		}
+	}
+
+	void VersionSet::Finalize(Version* v)
+	{
+		//Precomputed best level for next compaction
+		int best_level = -1;
+		double best_score = -1;
+
+		for (int level = 0; level < config::kNumLevels - 1; level++)
+		{
+			double score;
+			if (level == 0)
+			{
+				//We treat level-0 specially by bounding the number of files
+				//instead of number of bytes, since with larger write-buffer
+				//sizes it is nice not to do too many level-0 compactions, and
+				//the files in level-0 are merged on every read.
+				score = v->files_[level].size() /
+					static_cast<double>(config::kL0_CompactionTrigger);
+			}
+			else
+			{
+				//Compute the ratio of current size to size limit.
+				const uint64_t level_bytes = TotalFileSize(v->files_[level]);
+				score = static_cast<double>(level_bytes) / MaxBytesForLevel(level);
+			}
+
+			if (score > best_score)
+			{
+				best_level = level;
+				best_score = score;
+			}
+		}
+
+		v->compaction_level_ = best_level;
+		v->compaction_score_ = best_score;
+
+		v->file_indexer_.Build(&icmp_, v->files_);
+	}
+
+	void VersionSet::AddLiveFiles(std::set<uint64_t>* live)
+	{
+		for (Version* v = dummy_versions_.next_;
+			v != &dummy_versions_;
+			v = v->next_)
+		{
+			for (int level = 0; level < config::kNumLevels; level++)
+			{
+				const std::vector<FileMetaData*>& files = v->files_[level];
+				for (size_t i = 0; i < files.size(); i++)
+				{
+					live->insert(files[i]->number);
+				}
+			}
+		}
+	}
+
+	void VersionSet::AddSnapshotTo(VersionEdit* edit, std::set<uint64_t>* files) const
+	{
+		edit->SetComparatorName(icmp_.user_comparator()->Name());
+
+		//Save compaction pointers
+		for (int level = 0; level < config::kNumLevels; level++)
+		{
+			if (!compact_pointer_[level].empty())
+			{
+				InternalKey key;
+				key.DecodeFrom(compact_pointer_[level]);
+				edit->SetComparatorPointer(level, key);
+			}
+		}
+
+		//Save files
+		for (int level = 0; level < config::kNumLevels; level++)
+		{
+			const std::vector<FileMetaData*>& level_files = current_->files_[level];
+			for (size_t i = 0; i < level_files.size(); i++)
+			{
+				const FileMetaData* f = level_files[i];
+				edit->AddFile(level, f->number, f->file_size, f->smallest, f->largest,
+					f->global_seqno);
+				if (files != NULL)
+				{
+					files->insert(f->number);
+				}
+			}
+		}
+	}
+
+	Status VersionSet::WriteSnapshot(log::Writer* log)
+	{
+		//Save metadata
+		VersionEdit edit;
+		AddSnapshotTo(&edit, NULL);
+
+		std::string record;
+		edit.EncodeTo(&record);
+		Status s = log->AddRecord(record);
+		if (s.ok())
+		{
+			manifest_file_size_ += log::kHeaderSize + record.size();
+		}
+		return s;
+	}
+
+	int VersionSet::NumLevelFiles(int level) const
+	{
+		assert(level >= 0);
+		assert(level < config::kNumLevels);
+		return current_->files_[level].size();
+	}
+
+	int64_t VersionSet::NumLevelBytes(int level) const
+	{
+		assert(level >= 0);
+		assert(level < config::kNumLevels);
+		return TotalFileSize(current_->files_[level]);
+	}
+
+	std::string VersionSet::FileStats() const
+	{
+		std::string result;
+		char buf[200];
+		snprintf(buf, sizeof(buf), "%5s %10s %10s %10s %10s %10s %12s %10s\n",
+			"Level", "File", "Size(KB)", "Gets", "Misses", "Seeks",
+			"Read(KB)", "MissLimit");
+		result.append(buf);
+		for (int level = 0; level < config::kNumLevels; level++)
+		{
+			const std::vector<FileMetaData*>& files = current_->files_[level];
+			for (size_t i = 0; i < files.size(); i++)
+			{
+				FileMetaData* f = files[i];
+				snprintf(buf, sizeof(buf), "%5d %10llu %10llu %10lld %10lld %10lld %12llu %10d\n",
+					level,
+					static_cast<unsigned long long>(f->number),
+					static_cast<unsigned long long>(f->file_size >> 10),
+					static_cast<long long>(f->read_stats.gets.Load()),
+					static_cast<long long>(f->read_stats.misses.Load()),
+					static_cast<long long>(f->read_stats.seeks.Load()),
+					static_cast<unsigned long long>(table_cache_->BytesRead(f->number) >> 10),
+					f->allowed_seeks);
+				result.append(buf);
+			}
+		}
+		return result;
+	}
+
+	namespace {
+		//Work shared by the threads of VersionSet::OpenTables().
+		struct OpenTablesState
+		{
+			TableCache* table_cache;
+			std::vector<FileMetaData*> files;
+			port::Mutex mu;
+			port::CondVar cv;	//Signalled when a thread exits
+			size_t next;	//Index in files of the next table to open
+			int live_threads;
+			Status status;	//First error seen
+
+			OpenTablesState() :cv(&mu), next(0), live_threads(0) { }
+		};
+	}
+
+	static void OpenTablesWork(void* arg)
+	{
+		OpenTablesState* state = reinterpret_cast<OpenTablesState*>(arg);
+		state->mu.Lock();
+		while (state->next < state->files.size())
+		{
+			FileMetaData* f = state->files[state->next++];
+			state->mu.Unlock();
+			Status s = state->table_cache->Preload(f);
+			state->mu.Lock();
+			if (!s.ok() && state->status.ok())
+			{
+				state->status = s;
+			}
+		}
+		state->live_threads--;
+		state->cv.SignalAll();
+		state->mu.Unlock();
+	}
+
+	Status VersionSet::OpenTables(int num_threads, int max_tables)
+	{
+		OpenTablesState state;
+		state.table_cache = table_cache_;
+		for (int level = 0; level < config::kNumLevels; level++)
+		{
+			const std::vector<FileMetaData*>& files = current_->files_[level];
+			for (size_t i = 0; i < files.size() &&
+				static_cast<int>(state.files.size()) < max_tables; i++)
+			{
+				state.files.push_back(files[i]);
+			}
+		}
+		if (state.files.empty() || num_threads <= 0)
+		{
+			return Status::OK();
+		}
+		if (static_cast<size_t>(num_threads) > state.files.size())
+		{
+			num_threads = static_cast<int>(state.files.size());
+		}
+
+		MutexLock l(&state.mu);
+		state.live_threads = num_threads;
+		for (int i = 0; i < num_threads; i++)
+		{
+			env_->StartThread(&OpenTablesWork, &state);
+		}
+		while (state.live_threads > 0)
+		{
+			state.cv.Wait();
+		}
+		return state.status;
+	}
+
+}
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "db/dbformat.h"
+#include "db/file_indexer.h"
 #include "db/version_edit.h"
 #include "port/port.h"
 
@@ -14,6 +15,8 @@ namespace leveldb{
 	class Compaction;
 	class Iterator;
 	class MemTable;
+	class MergeContext;
+	class PinnableSlice;
 	class TableBuilder;
 	class TableCache;
 	class Version;
@@ -29,7 +32,7 @@ namespace leveldb{
 	//[*smallest,*largest].
 	extern bool SomeFileOverlapsRange(
 		const InternalKeyComparator& icmp,
-		bool disjiont_sorted_files,
+		bool disjoint_sorted_files,
 		const std::vector<FileMetaData*>& files,
 		const Slice* smallest_user_key,
 		const Slice* largest_user_key);
@@ -40,13 +43,23 @@ namespace leveldb{
 		//yield the contents of this Version when merged together.
 		void AddIterators(const ReadOptions&, std::vector<Iterator*>* iters);
 
-		//Lookup the value for key.
+		//Lookup the value for key. If found, store it in *val and
+		//return OK. Else return a non-OK status. Fills *stats.
+		//Merge operands already collected by the memtables are passed in
+		//*merge_context and folded with the base value found here. Entries
+		//older than *max_covering_tombstone_seq (the newest range tombstone
+		//covering key seen so far) are treated as deleted. A plain value is
+		//not copied: *val keeps the block it was read from alive until *val
+		//is reset. A hit on a table whose blocks are cached makes no heap
+		//allocation (see Table::InternalGet()).
+		//REQUIRES: lock is not held
 		struct GetStats{
 			FileMetaData* seek_file;
 			int seek_file_level;
 		};
-		Status Get(const ReadOptions&, const LookupKey& key, std::string* val,
-			GetStats* stats);
+		Status Get(const ReadOptions&, const LookupKey& key, PinnableSlice* val,
+			GetStats* stats, MergeContext* merge_context,
+			SequenceNumber* max_covering_tombstone_seq);
 
 		//Adds "stats" into the current state.
 		bool UpdateStats(const GetStats& stats);
@@ -67,11 +80,26 @@ namespace leveldb{
 		bool OverlapInLevel(int level,
 			const Slice* smallest_user_key, const Slice* largest_user_key);
 
+		//Store in *covered the (level, file) pairs below "level" whose
+		//entire user key range lies inside the range tombstone [begin, end).
+		//Every entry in such a file is older than a tombstone stored at
+		//"level", so compaction may delete the file without reading it once
+		//no snapshot older than the tombstone remains.
+		void GetFilesCoveredByRange(int level,
+			const Slice& begin, const Slice& end,
+			std::vector<std::pair<int, FileMetaData*> >* covered);
+
 		//Returns the level at which we should place a new memtable compaction
 		//result that covers the range [smallest_user_key, largest_user_key].
 		int PickLevelForMemTableOutput(const Slice& smallest_user_key,
 									   const Slice& largest_user_key);
 
+		//Returns the deepest level at which an ingested file covering
+		//[smallest_user_key, largest_user_key] can be placed such that no
+		//file in that level or above overlaps it.
+		int PickLevelForExternalFile(const Slice& smallest_user_key,
+									 const Slice& largest_user_key);
+
 		int NumFiles(int level) const { return files_[level].size(); }
 
 		//Return a human readable string that describes this version's contents.
@@ -82,6 +110,8 @@ namespace leveldb{
 		friend class VersionSet;
 		class LevelFileNumIterator;
 		Iterator* NewConcatenatingIterator(const ReadOptions&, int level) const;
+		static Iterator* GetFileIterator(void* arg, const ReadOptions& options,
+			const Slice& file_value);
 
 		VersionSet* vset_;	//VersionSet to which this Version belongs
 		Version* next_;		//Next version in linked list
@@ -99,6 +129,9 @@ namespace leveldb{
 		double compaction_score_;
 		int compaction_level_;
 
+		//Speeds up the search of files_ in Get(). Built by Finalize().
+		FileIndexer file_indexer_;
+
 		explicit Version(VersionSet* vset)
 			:vset_(vset), next_(this), prev_(this), refs_(0),
 			file_to_compact_(NULL),
@@ -133,6 +166,15 @@ namespace leveldb{
 		//Recover the last saved descriptor from persistent storage.
 		Status Recover();
 
+		//Open up to "max_tables" tables of the current version on
+		//"num_threads" threads, level by level starting at level 0, and
+		//wait for them. Called by DB::Open after Recover() when
+		//options.table_open_threads > 0. A table that fails to open is
+		//left to report its error on first use; the first such error is
+		//returned.
+		//REQUIRES: no other thread is using the VersionSet
+		Status OpenTables(int num_threads, int max_tables);
+
 		//Return the current version.
 		Version* current() const { return current_; }
 
@@ -140,7 +182,7 @@ namespace leveldb{
 		uint64_t ManifestFileNumber() const { return manifest_file_number_; }
 
 		//Allocate and return a new file number
-		uint64_t NewFileNumber() { return next_file_number_; }
+		uint64_t NewFileNumber() { return next_file_number_++; }
 
 		//Return the number of Table files at the specified level.
 		int NumLevelFiles(int level) const;
@@ -191,6 +233,11 @@ namespace leveldb{
 		//Add all files listed in any live version to *live.
 		void AddLiveFiles(std::set<uint64_t>* live);
 
+		//Store in *edit the comparator name, compaction pointers and files
+		//of the current version, which is enough to start a new descriptor,
+		//and add the numbers of those files to *files if it is non-NULL.
+		void AddSnapshotTo(VersionEdit* edit, std::set<uint64_t>* files) const;
+
 		//Return the approximate offset in the database of the data for 
 		//"key" as of version "v".
 		uint64_t ApproximateOffsetOf(Version* v, const InternalKey& key);
@@ -204,6 +251,11 @@ namespace leveldb{
 
 		const char* LevelSummary(LevelSummaryStorage* scratch) const;
 
+		//Return a human-readable table of the read counters of every file
+		//in the current version, one line per file, for the
+		//"leveldb.file-stats" property.
+		std::string FileStats() const;
+
 
 	private:
 		class Builder;
@@ -213,6 +265,10 @@ namespace leveldb{
 
 		void Finalize(Version* v);
 
+		//Number of read misses a file of "file_size" bytes may take before
+		//it is compacted (see Options::read_compaction_bytes_per_miss).
+		int AllowedReadMisses(uint64_t file_size) const;
+
 		void GetRange(const std::vector<FileMetaData*>& inputs,
 			InternalKey* smallest,
 			InternalKey* largest);
@@ -224,8 +280,13 @@ namespace leveldb{
 
 		void SetupOtherInputs(Compaction* c);
 
-		//Save current contents to *log
+		//Save current contents to *log, which must be descriptor_log_,
+		//and count the bytes in manifest_file_size_.
 		Status WriteSnapshot(log::Writer* log);
+
+		//Returns true iff the next LogAndApply() should start a new
+		//MANIFEST (see Options::max_manifest_file_size).
+		bool ManifestNeedsRollover() const;
 		void AppendVersion(Version* v);
 
 		Env* const env_;
@@ -242,6 +303,8 @@ namespace leveldb{
 		//Opened lazily
 		WritableFile* descriptor_file_;
 		log::Writer* descriptor_log_;
+		uint64_t manifest_file_size_;	//Bytes written to descriptor_log_
+		uint64_t manifest_snapshot_size_;	//Bytes of the snapshot it starts with
 		Version dummy_versions_;	//Head of circular doubly-linked list of versions.
 		Version* current_;	//== dummy_versions_.prev_
 
@@ -0,0 +1,108 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "leveldb/status.h"
+
+namespace leveldb{
+
+	class DB;
+	class Env;
+	class Logger;
+
+	//Options to control the behavior of a backup engine(passed to
+	//BackupEngine::Open)
+	struct BackupOptions
+	{
+		//Directory that holds the backups. It is created if missing.
+		//Table files are kept once under "shared/", named by file number,
+		//crc32c and size, and referenced by every backup that contains
+		//them; each backup adds only its own
+		//descriptor under "private/<id>/" and a metadata file "meta/<id>".
+		std::string backup_dir;
+
+		//Use the specified object to interact with the environment, both
+		//for the backup directory and for the databases backed up or restored.
+		//Default: Env::Default()
+		Env* env;
+
+		//Progress and errors are written to info_log if it is non-NULL.
+		//Default: NULL
+		Logger* info_log;
+
+		//Number of threads that copy files during a backup or a restore.
+		//Default: 4
+		int max_background_copies;
+
+		//If non-zero, copies are throttled so that they write no more than
+		//this many bytes per second in total, to bound the I/O a backup
+		//steals from the live database.
+		//Default: 0
+		uint64_t rate_limit_bytes_per_sec;
+
+		//Create a BackupOptions object with default values for all fields.
+		BackupOptions();
+	};
+
+	struct BackupInfo
+	{
+		uint32_t backup_id;
+		uint64_t timestamp;	//Seconds since the epoch when the backup was taken
+		uint64_t size;		//Bytes of all files in the backup, shared or not
+		uint32_t number_files;
+	};
+
+	//Takes incremental backups of a database: a table file already present
+	//in the backup directory is never copied again, so each backup costs
+	//only the tables written since the previous one. Every file is
+	//recorded with its crc32c, which is verified when it is restored.
+	//A BackupEngine may not be used by several threads at once, nor may two
+	//engines share a backup directory.
+	class BackupEngine
+	{
+	public:
+		//Open the backup directory named by options.backup_dir and load the
+		//metadata of the backups it holds. Backups whose metadata is
+		//damaged are ignored and reported to options.info_log.
+		//Stores a pointer to a heap-allocated engine in *result and returns
+		//OK on success, and a non-OK status on error.
+		static Status Open(const BackupOptions& options, BackupEngine** result);
+
+		BackupEngine(){ }
+		virtual ~BackupEngine();
+
+		//Take a new backup of "db", which was opened with name "dbname".
+		//The database is checkpointed into a temporary directory under
+		//"dbname", which only links files, and the tables missing from the
+		//backup directory are copied from there while writes go on. Every
+		//table is read once to checksum it, since only its number, crc32c
+		//and size together tell whether the backup directory holds it.
+		virtual Status CreateNewBackup(DB* db, const std::string& dbname) = 0;
+
+		//Delete all but the "num_backups_to_keep" newest backups, and every
+		//shared table file no remaining backup refers to.
+		virtual Status PurgeOldBackups(uint32_t num_backups_to_keep) = 0;
+
+		//Delete the backup with the specified id.
+		virtual Status DeleteBackup(uint32_t backup_id) = 0;
+
+		//Store in *info a description of every backup, oldest first.
+		virtual void GetBackupInfo(std::vector<BackupInfo>* info) = 0;
+
+		//Replace the database in "db_dir", which must not be open, with the
+		//contents of the backup with the specified id. Table, log and
+		//descriptor files already in "db_dir" are deleted first. Returns
+		//Corruption if a file read from the backup does not match its
+		//recorded checksum.
+		virtual Status RestoreDBFromBackup(uint32_t backup_id,
+			const std::string& db_dir) = 0;
+
+		//Same as RestoreDBFromBackup() with the id of the newest backup.
+		virtual Status RestoreDBFromLatestBackup(const std::string& db_dir) = 0;
+
+	private:
+		//No copying allowed
+		BackupEngine(const BackupEngine&);
+		void operator=(const BackupEngine&);
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 #include "leveldb/slice.h"
+#include "leveldb/status.h"
 
 namespace leveldb{
 
@@ -10,6 +11,15 @@ namespace leveldb{
 	//of Cache uses a least-recently-used eviction policy.
 	extern Cache* NewLRUCache(size_t capacity);
 
+	//Create a least-recently-used cache in which up to
+	//"high_pri_pool_ratio" of the capacity is kept for entries inserted
+	//with Cache::HIGH priority: low-priority entries are evicted first,
+	//and high-priority ones only once they outgrow that share. If
+	//"strict_capacity_limit" is set, inserts that cannot fit fail instead
+	//of taking the cache over capacity (see Cache::Insert()).
+	extern Cache* NewLRUCache(size_t capacity, double high_pri_pool_ratio,
+		bool strict_capacity_limit);
+
 	class Cache
 	{
 	public:
@@ -21,11 +31,35 @@ namespace leveldb{
 		//Opaque handle to an entry stored in the cache.
 		struct Handle{ };
 
+		//Eviction order of an entry. Blocks that every read of a table
+		//needs, such as its index and filter, are inserted with HIGH
+		//priority so that a scan over data blocks does not push them out.
+		enum Priority{
+			HIGH,
+			LOW
+		};
+
 		//Insert a mapping from key->value into the cache and assign it the specified charge
 		//against the total cache capacity.
+		//The entry has LOW priority and belongs to owner 0. This form never
+		//fails: under a strict capacity limit the entry is admitted anyway.
 		virtual Handle* Insert(const Slice& key, void* value, size_t charge,
 			void(*deleter)(const Slice& key, void* value)) = 0;
 
+		//Insert a mapping from key->value with the given priority, and count
+		//its charge against "owner" (see GetOwnerUsage()). On success stores
+		//in *handle a handle to the entry, which the caller must Release(),
+		//and returns OK.
+		//If the cache has a strict capacity limit and the entry does not fit
+		//even once every evictable entry is gone, returns Incomplete and
+		//stores NULL in *handle; the caller keeps ownership of "value" and
+		//"deleter" is not called. If "handle" is NULL such an entry is
+		//instead deleted at once and OK is returned, as if it had been
+		//inserted and evicted.
+		virtual Status Insert(const Slice& key, void* value, size_t charge,
+			void(*deleter)(const Slice& key, void* value),
+			Handle** handle, Priority priority, uint64_t owner) = 0;
+
 		//If the cache has no mapping for "key", returns NULL.
 		virtual Handle* Lookup(const Slice& key) = 0;
 
@@ -42,6 +76,19 @@ namespace leveldb{
 		//sharing the same cache to partition the key space.
 		virtual uint64_t NewId() = 0;
 
+		//Make later inserts fail rather than overcommit, or allow them to
+		//again. See Insert().
+		virtual void SetStrictCapacityLimit(bool strict_capacity_limit) = 0;
+
+		//Return the total charge of the entries in the cache, counting
+		//evicted entries still in use.
+		virtual size_t GetUsage() = 0;
+
+		//Return the part of GetUsage() charged to "owner". Several DBs
+		//sharing one cache give it distinct owners (for instance from
+		//NewId()) to see what each one holds.
+		virtual size_t GetOwnerUsage(uint64_t owner) = 0;
+
 	protected:
 	private:
 		void LRU_Remove(Handle* e);
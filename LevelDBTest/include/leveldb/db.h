@@ -11,6 +11,7 @@ namespace leveldb{
 	static const int kMinorVersion = 2;
 
 	struct Options;
+	class PinnableSlice;
 	struct ReadOptions;
 	struct WriteOptions;
 	class WriteBatch;
@@ -62,6 +63,23 @@ namespace leveldb{
 		//database. 
 		//Note:consider setting options.sync = true.
 		virtual Status Delete(const WriteOptions& options, const Slice& key) = 0;
+
+		//Remove the database entries (if any) for every key in the range
+		//["begin", "end"). The range is recorded as a single tombstone, so the
+		//cost does not depend on the number of keys removed. Returns OK on
+		//success, and a non-OK status on error.
+		//Note: consider setting options.sync = true.
+		virtual Status DeleteRange(const WriteOptions& options,
+			const Slice& begin, const Slice& end) = 0;
+
+		//Record "value" as a merge operand for "key". The operand is folded
+		//into the existing value with options.merge_operator when the key is
+		//read or compacted, so no read is needed at write time. Returns OK on
+		//success, and a non-OK status on error.
+		//REQUIRES: options.merge_operator was non-NULL when the DB was opened.
+		//Note: consider setting options.sync = true.
+		virtual Status Merge(const WriteOptions& options,
+			const Slice& key, const Slice& value) = 0;
 		
 		//Apply the specified updates to the database.
 		//Returns OK on success, non-OK on failure.
@@ -73,6 +91,30 @@ namespace leveldb{
 		virtual Status Get(const ReadOptions& options,
 			const Slice& key, std::string* value) = 0;
 
+		//Like Get() above, but a large value need not be copied: *value may
+		//refer directly to the memtable or cached table block holding it,
+		//which is kept alive until *value is reset or destroyed.
+		//The default implementation copies the value.
+		virtual Status Get(const ReadOptions& options,
+			const Slice& key, PinnableSlice* value);
+
+		//Add the table file "fname", built outside of the database with
+		//TableBuilder using the same comparator, to the database. The file is
+		//moved (not copied) into the database directory and bypasses the
+		//memtable and the log; all of its entries become visible at once with
+		//a single new sequence number, shadowing older values of their keys.
+		//Returns OK on success, and a non-OK status if the file is not a
+		//valid table or could not be installed.
+		virtual Status IngestExternalFile(const std::string& fname) = 0;
+
+		//Flush the memtable and create in "checkpoint_dir", which must not
+		//exist, an openable copy of the database as of the flush. Table files
+		//are hard-linked rather than copied where the Env supports it, so a
+		//checkpoint takes milliseconds whatever the size of the database and
+		//shares disk space with it until the files are compacted away.
+		//Writes continue while the checkpoint is taken.
+		virtual Status CreateCheckpoint(const std::string& checkpoint_dir) = 0;
+
 		//Return a heap-allocated iterator over the over the contents of the database.
 		virtual Iterator* NewIterator(const ReadOptions& options) = 0;
 
@@ -83,6 +125,21 @@ namespace leveldb{
 		virtual void ReleaseSnapshot(const Snapshot* snapshot) = 0;
 
 		//DB implementations can export properties about their state via this method.
+		//If "property" is a valid property understood by this DB implementation,
+		//fills "*value" with its current value and returns true. Otherwise
+		//returns false.
+		//
+		//Valid property names include:
+		//
+		//"leveldb.file-stats" - returns a multi-line string with the read
+		//	counters of every table file: the Get() calls that searched it,
+		//	the read misses charged to it (a Get() that searches several
+		//	files charges the first), iterator seeks, bytes read from disk,
+		//	and the misses allowed before it is compacted.
+		//"leveldb.table-cache-stats" - returns a multi-line string with the
+		//	table cache counters of each shard: hits, misses, misses that
+		//	waited for another reader's open of the same file, files opened
+		//	and failed opens.
 		virtual bool GetProperty(const Slice& property, std::string* value) = 0;
 
 		//For each i in [0,n-1], store in "sizes[i]", the approximate file system space
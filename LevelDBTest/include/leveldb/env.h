@@ -60,6 +60,13 @@ namespace leveldb{
 		virtual Status RenameFile(const std::string& src,
 			const std::string& target) = 0;
 
+		//Create "target" as a hard link to the existing file "src", so that
+		//both names refer to the same data. "target" must not exist.
+		//The default implementation returns a NotSupported status; callers
+		//are expected to fall back to copying the file.
+		virtual Status LinkFile(const std::string& src,
+			const std::string& target);
+
 		//Lock the specified file. Used to prevent concurrent access to 
 		//the same db by multiple processes. On failure, stores NULL in
 		//*lock and returns non-OK.
@@ -219,6 +226,9 @@ namespace leveldb{
 		Status RenameFile(const std::string& s, const std::string& t) {
 			return target_->RenameFile(s, t);
 		}
+		Status LinkFile(const std::string& s, const std::string& t) {
+			return target_->LinkFile(s, t);
+		}
 		Status LockFile(const std::string& f, FileLock** l) {
 			return target_->LockFile(f, l);
 		}
@@ -61,5 +61,5 @@ namespace leveldb{
 	//Return an empty iterator (yields nothing)
 	extern Iterator* NewEmptyIterator();
 	//Return an empty iterator with the specified status.
-	extern Iterator* NeErrorIterator(const Status& status);
+	extern Iterator* NewErrorIterator(const Status& status);
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+#include <stddef.h>
+#include "leveldb/slice.h"
+
+namespace leveldb{
+
+	class Arena;
+	class LookupKey;
+	class SliceTransform;
+
+	//A MemTableRep is the in-memory index a MemTable keeps its entries
+	//in. Entries are opaque byte strings allocated from the memtable's
+	//arena, each starting with its varint32 length-prefixed internal key;
+	//a rep only orders them with the supplied KeyComparator.
+	//
+	//Insert() requires external synchronization, but readers may use a
+	//rep concurrently with a single writer and without locking.
+	class MemTableRep
+	{
+	public:
+		//Orders memtable entries by their internal key.
+		class KeyComparator
+		{
+		public:
+			virtual ~KeyComparator();
+
+			//Three-way comparison of the internal keys at the start of
+			//the entries "a" and "b".
+			virtual int operator()(const char* a, const char* b) const = 0;
+
+			//Returns true iff the first eight bytes of the user keys of
+			//two entries, zero-padded and compared as big-endian integers,
+			//order the entries whenever they differ, as they do under a
+			//bytewise user comparator.
+			virtual bool HasOrderedKeyPrefix() const { return false; }
+		};
+
+		explicit MemTableRep(Arena* arena) :arena_(arena){ }
+		virtual ~MemTableRep();
+
+		//Insert "entry" into the rep. The entry is owned by the arena and
+		//outlives the rep.
+		//REQUIRES: nothing that compares equal to entry is in the rep.
+		virtual void Insert(const char* entry) = 0;
+
+		//Returns true iff an entry that compares equal to "key" is in the rep.
+		virtual bool Contains(const char* key) const = 0;
+
+		//Notify the rep that no more entries will be inserted, as its
+		//memtable has been made immutable. Reps that defer ordering work
+		//may use this to do it once.
+		virtual void MarkReadOnly(){ }
+
+		//Returns an estimate of the memory used by the rep, not counting
+		//memory allocated from the arena.
+		virtual size_t ApproximateMemoryUsage() = 0;
+
+		//Invoke callback_func(callback_args, entry) on each entry at or
+		//after k.memtable_key(), in order, until it returns false or the
+		//entries sharing k.user_key() are exhausted. Reps that partition
+		//their entries may stop as soon as they leave the partition of
+		//k.user_key(), so the callback must check the user key itself.
+		//
+		//The default implementation seeks an iterator from GetIterator().
+		virtual void Get(const LookupKey& k, void* callback_args,
+			bool(*callback_func)(void* arg, const char* entry));
+
+		//Iteration over the entries of a rep, in KeyComparator order.
+		class Iterator
+		{
+		public:
+			virtual ~Iterator();
+
+			//Returns true iff the iterator is positioned at a valid entry.
+			virtual bool Valid() const = 0;
+
+			//Returns the entry at the current position.
+			//REQUIRES: Valid()
+			virtual const char* key() const = 0;
+
+			//Advances to the next position.
+			//REQUIRES: Valid()
+			virtual void Next() = 0;
+
+			//Advances to the previous position.
+			//REQUIRES: Valid()
+			virtual void Prev() = 0;
+
+			//Advance to the first entry at or after "target", a
+			//length-prefixed internal key.
+			virtual void Seek(const char* target) = 0;
+
+			//Position at the first entry.
+			virtual void SeekToFirst() = 0;
+
+			//Position at the last entry.
+			virtual void SeekToLast() = 0;
+		};
+
+		//Return an iterator over all entries. Reps without a global order
+		//may sort a snapshot of their entries here, so this should be used
+		//for scans and flushes rather than point lookups.
+		virtual Iterator* GetIterator() = 0;
+
+	protected:
+		Arena* const arena_;
+
+	private:
+		//No copying allowed
+		MemTableRep(const MemTableRep&);
+		void operator=(const MemTableRep&);
+	};
+
+	//Creates the MemTableRep of every memtable of a DB.
+	class MemTableRepFactory
+	{
+	public:
+		virtual ~MemTableRepFactory();
+
+		//Return a new rep that orders entries with "cmp" and allocates from
+		//"arena". Both outlive the returned rep.
+		virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp,
+			Arena* arena) = 0;
+
+		//The name of the representation, for logging.
+		virtual const char* Name() const = 0;
+	};
+
+	//Return a factory for the default representation: a single skiplist,
+	//giving O(log n) inserts and lookups and ordered iteration.
+	//If "inline_key_prefix" is true and the comparator HasOrderedKeyPrefix(),
+	//each node also stores the first eight bytes of its user key, so that
+	//searches rarely have to dereference the entries they pass over.
+	extern MemTableRepFactory* NewSkipListRepFactory(bool inline_key_prefix = false);
+
+	//Return a factory for reps that hash each user key's prefix, under
+	//"transform", into one of "bucket_count" buckets holding a sorted
+	//linked list. Point lookups and inserts cost O(1) plus the length of a
+	//bucket, which suits workloads with few keys per prefix. Full
+	//iteration sorts a snapshot of all entries on demand.
+	//"transform" must outlive the factory and every DB using it.
+	extern MemTableRepFactory* NewHashLinkListRepFactory(
+		const SliceTransform* transform, size_t bucket_count = 50000);
+
+	//Like NewHashLinkListRepFactory(), but each bucket is a skiplist, for
+	//workloads with many keys per prefix. "inline_key_prefix" is as for
+	//NewSkipListRepFactory().
+	extern MemTableRepFactory* NewHashSkipListRepFactory(
+		const SliceTransform* transform, size_t bucket_count = 50000,
+		bool inline_key_prefix = false);
+
+	//Return a factory for reps that append entries to a vector and sort
+	//them once the memtable becomes immutable, splitting the sort across
+	//"sort_threads" threads for large memtables. Inserts are much cheaper
+	//than with a skiplist, which suits bulk loads, but reads of a mutable
+	//memtable sort a copy of all entries. "reserved_count" entries are
+	//reserved up front.
+	extern MemTableRepFactory* NewVectorRepFactory(size_t reserved_count = 0,
+		int sort_threads = 1);
+
+}
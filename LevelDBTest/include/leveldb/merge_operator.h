@@ -0,0 +1,50 @@
+#pragma once
+#include <deque>
+#include <string>
+#include "leveldb/slice.h"
+
+namespace leveldb{
+
+	//A MergeOperator defines the semantics of a read-modify-write update
+	//(e.g. increment a counter, append to a list). DB::Merge() records
+	//only the operand; the operands for a key are folded together with
+	//the existing value lazily, when the key is read or compacted.
+	//
+	//A MergeOperator must be thread-safe since its methods may be invoked
+	//concurrently from multiple threads.
+	class MergeOperator
+	{
+	public:
+		virtual ~MergeOperator();
+
+		//Combine "operands" with "*existing_value" and store the result
+		//in *new_value. "existing_value" is NULL if the key has no value
+		//(it never existed or the newest base entry is a deletion).
+		//"operands" is ordered from oldest to newest.
+		//
+		//Returns true on success. Returning false marks the key as
+		//corrupted and the read fails with a Corruption status.
+		virtual bool FullMerge(const Slice& key,
+			const Slice* existing_value,
+			const std::deque<std::string>& operands,
+			std::string* new_value) const = 0;
+
+		//Combine two adjacent operands into a single operand that has the
+		//same effect as applying "left_operand" followed by
+		//"right_operand". Stores the result in *new_value and returns true
+		//on success. Returns false if the two operands cannot be combined
+		//without the existing value, in which case both are kept.
+		//
+		//The default implementation never combines operands.
+		virtual bool PartialMerge(const Slice& key,
+			const Slice& left_operand,
+			const Slice& right_operand,
+			std::string* new_value) const;
+
+		//The name of the merge operator. Used to check for operator
+		//mismatches (i.e., a DB created with one merge operator is
+		//accessed using a different one).
+		virtual const char* Name() const = 0;
+	};
+
+}
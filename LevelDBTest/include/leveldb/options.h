@@ -1,11 +1,16 @@
 #pragma once
 #include <stddef.h>
+#include <stdint.h>
 namespace leveldb{
 
 	class Cache;
 	class Comparator;
 	class Env;
 	class Logger;
+	class MemTableRepFactory;
+	class MergeOperator;
+	class Slice;
+	class SliceTransform;
 	class Snapshot;
 
 	//DB contents ars stored in a set of blocks, each of which holds a 
@@ -35,6 +40,12 @@ namespace leveldb{
 		//comparator provided to previous open calls on the same DB.
 		const Comparator* comparator;
 
+		//Operator used to fold the operands written by DB::Merge() into
+		//the existing value of a key. Must be non-NULL if DB::Merge() is
+		//used. Like the comparator, it must not change between opens.
+		//Default: NULL
+		const MergeOperator* merge_operator;
+
 		//If true, the database will be created if it is missing.
 		//Default: false
 		bool create_if_missing;
@@ -60,13 +71,85 @@ namespace leveldb{
 		//before converting to a sorted on-disk file.
 		size_t write_buffer_size;
 
+		//Maximum number of memtables, the active one included, held in
+		//memory. When the active memtable fills it joins a queue of
+		//immutable memtables waiting to be flushed; writers only stall once
+		//this many memtables exist. Reads consult every queued memtable.
+		//Default: 2 (a single immutable memtable)
+		int max_write_buffer_number;
+
+		//Minimum number of immutable memtables that must be queued before
+		//a flush starts. All queued memtables are merged into a single
+		//level-0 table, so larger values mean fewer, larger level-0 files.
+		//Default: 1
+		int min_write_buffer_number_to_merge;
+
+		//If non-NULL, user keys are grouped by their prefix under this
+		//transformation. The memtable bloom filter then indexes prefixes
+		//rather than whole keys; keys outside the transformation's domain
+		//are still indexed whole. Each table also stores a bloom filter of
+		//its prefixes, which ReadOptions::prefix_same_as_start iterators
+		//use to skip tables. Prefixes must preserve key order: keys that
+		//share a prefix must be contiguous under the comparator.
+		//Default: NULL
+		const SliceTransform* prefix_extractor;
+
+		//If positive, each memtable keeps a bloom filter of the keys (or
+		//prefixes, see prefix_extractor) added to it, using this fraction
+		//of write_buffer_size as bits. Get() then skips the memtables that
+		//certainly do not hold the key. About 0.02 gives roughly 10 bits
+		//per key for 100 byte entries.
+		//Default: 0 (no filter)
+		double memtable_bloom_size_ratio;
+
+		//If true, a Put() whose key already has a value in the memtable
+		//that is at least as large overwrites that value in place instead
+		//of adding an entry, so that overwrite-heavy workloads fill the
+		//memtable far more slowly. Point lookups and memtable iterators
+		//take one of inplace_update_num_locks striped locks while copying
+		//a value, so iterators pay a copy per value() call.
+		//Older versions of an updated key are lost, so this must not be
+		//combined with snapshots. Nor does it mix with DeleteRange(): once
+		//the memtable holds a range tombstone every Put() adds an entry,
+		//until the next memtable.
+		//Default: false
+		bool inplace_update_support;
+
+		//Number of locks protecting in-place updates, striped over keys.
+		//Default: 10000
+		size_t inplace_update_num_locks;
+
+		//Creates the in-memory index of each memtable. Hash-bucketed reps
+		//(see leveldb/memtablerep.h) make point lookups O(1) at the cost of
+		//sorting on demand for scans and flushes.
+		//Default: NULL, which keeps each memtable in a skiplist
+		MemTableRepFactory* memtable_factory;
+
 		//Number of open fiels that can be used by the DB.
+		//If negative, every table is kept open from its first use until it
+		//is deleted, and reads reach it through its file metadata without
+		//a table cache lookup. Suits DBs whose tables all fit the process
+		//file limit; index and filter blocks of every table stay in memory.
 		int max_open_files;
 
 		//Control over blocks (user data is stored in a set of blocks, and a block
 		//is the unit of reading from disk).
 		Cache* block_cache;
 
+		//If true, the index and prefix filter blocks of each table are kept
+		//in block_cache with Cache::HIGH priority instead of for as long as
+		//the table is open. The memory they take is then bounded by the
+		//cache capacity and shared with the data blocks of every DB using
+		//the same cache. Has no effect if block_cache is NULL.
+		//Default: false
+		bool cache_index_and_filter_blocks;
+
+		//Blocks this DB adds to block_cache are charged to this owner (see
+		//Cache::GetOwnerUsage()). DBs sharing one cache should use distinct
+		//owners.
+		//Default: 0
+		uint64_t block_cache_owner;
+
 		//Approximate size of user data packed per block.
 		size_t block_size;
 
@@ -76,6 +159,58 @@ namespace leveldb{
 		//Compress blocks using the specified compression algorithm.
 		CompressionType compression;
 
+		//Number of worker threads each TableBuilder uses to compress and
+		//checksum finished data blocks while the caller keeps adding
+		//entries. Blocks are still written to the file in order, so a
+		//table holds the same bytes as one built synchronously. But
+		//TableBuilder::FileSize() counts queued blocks uncompressed, so
+		//with compression a compaction that cuts its output files by size
+		//may cut them a little earlier. Zero builds on the calling thread
+		//only.
+		//Default: 0
+		int table_build_threads;
+
+		//If positive, DB::Open opens the live tables on this many threads
+		//before returning, level 0 first and no more than the table cache
+		//holds (see max_open_files). Opening a table reads its index and
+		//prefix filter blocks, so the first reads after a restart do not
+		//pay for them. Zero opens each table on first use.
+		//Default: 0
+		int table_open_threads;
+
+		//If a Merge() finds at least this many successive operands for its
+		//key in the memtable, sitting on top of a base value that is also in
+		//the memtable, the operands are folded and a plain value is written
+		//instead of another operand. This bounds the work of reading hot
+		//counters. Zero disables write-time folding.
+		//Default: 0
+		int max_successive_merges;
+
+		//Once the MANIFEST has grown past this many bytes, and to at least
+		//twice the size of the snapshot of live files it starts with, the
+		//next version change writes a fresh snapshot to a new MANIFEST and
+		//points CURRENT at it. This keeps the time DB::Open spends replaying
+		//the MANIFEST proportional to the number of live files rather than
+		//to the number of changes made since the DB was opened.
+		//Default: 64MB
+		uint64_t max_manifest_file_size;
+
+		//Compaction driven by read amplification: a Get() that searches
+		//more than one table file counts as a miss against the first file
+		//it searched, which did not settle the lookup. Once a file has had one
+		//miss for every read_compaction_bytes_per_miss bytes of its size,
+		//but no fewer than read_compaction_min_misses, it is compacted into
+		//the next level so later lookups find one file fewer on their way.
+		//A lower value compacts hot files sooner at the cost of more write
+		//amplification. Zero disables read-triggered compaction.
+		//Default: 16KB, roughly where a miss costs as much as compacting
+		//the bytes it is charged for.
+		uint64_t read_compaction_bytes_per_miss;
+
+		//See read_compaction_bytes_per_miss.
+		//Default: 100
+		int read_compaction_min_misses;
+
 		//Create an Options object with default values for all fields.
 		Options();
 	};
@@ -96,10 +231,30 @@ namespace leveldb{
 		//not have been released).
 		const Snapshot* snapshot;
 
+		//If true and Options::prefix_extractor is set, an iterator only
+		//needs to yield keys that share the prefix of its Seek() target;
+		//it becomes invalid once the prefix changes. Table files whose
+		//prefix filter rules out that prefix are then skipped without
+		//reading any of their blocks. SeekToFirst() and SeekToLast() are
+		//not restricted.
+		bool prefix_same_as_start;
+
+		//If non-NULL, an iterator yields no key before *iterate_lower_bound
+		//and stops at the first key at or past *iterate_upper_bound, and
+		//table files and blocks wholly outside these bounds are never read.
+		//The bounds are user keys and must outlive the iterator. Point
+		//lookups ignore them. A Table iterator compares them directly with
+		//the keys stored in the table.
+		const Slice* iterate_lower_bound;
+		const Slice* iterate_upper_bound;
+
 		ReadOptions()
 			:verify_checksums(false),
 			fill_cache(true),
-			snapshot(NULL)
+			snapshot(NULL),
+			prefix_same_as_start(false),
+			iterate_lower_bound(NULL),
+			iterate_upper_bound(NULL)
 		{
 
 		}
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include "leveldb/slice.h"
+
+namespace leveldb{
+
+	//A Slice that keeps the memory it refers to alive. A read can either
+	//pin the storage a value already lives in (a memtable, a cached
+	//table block) and hand out a Slice into it without copying, or copy
+	//the value into a buffer the PinnableSlice owns. Either way the
+	//referenced data stays valid until Reset() or destruction.
+	//
+	//Like a std::string, a PinnableSlice must not be used from multiple
+	//threads without external synchronization.
+	class PinnableSlice :public Slice
+	{
+	public:
+		typedef void(*CleanupFunction)(void* arg1, void* arg2);
+
+		//Copies made by PinSelf() are stored in an internal buffer.
+		PinnableSlice();
+
+		//Copies made by PinSelf() are stored in *buf, which must outlive
+		//this object.
+		explicit PinnableSlice(std::string* buf);
+
+		~PinnableSlice();
+
+		//Refer to "s" without copying it. The memory behind s must stay
+		//valid until (*function)(arg1, arg2) is called by Reset().
+		//REQUIRES: !IsPinned()
+		void PinSlice(const Slice& s, CleanupFunction function, void* arg1, void* arg2);
+
+		//Copy "s" into the buffer and refer to the copy.
+		//REQUIRES: !IsPinned()
+		void PinSelf(const Slice& s);
+
+		//Refer to the contents of the buffer, as filled through GetSelf().
+		//REQUIRES: !IsPinned()
+		void PinSelf();
+
+		//Return the buffer used by PinSelf(), to be filled in directly.
+		std::string* GetSelf(){ return buf_; }
+
+		//Returns true iff the slice refers to pinned external storage
+		//rather than to the buffer.
+		bool IsPinned() const { return function_ != NULL; }
+
+		//Release the pinned storage, if any, and become empty.
+		void Reset();
+
+	private:
+		std::string self_space_;
+		std::string* const buf_;
+		CleanupFunction function_;	//NULL unless pinned
+		void* arg1_;
+		void* arg2_;
+
+		//No copying allowed
+		PinnableSlice(const PinnableSlice&);
+		void operator=(const PinnableSlice&);
+	};
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "leveldb/slice.h"
+
+namespace leveldb{
+
+	//A SliceTransform maps a user key to a prefix of it (e.g. the first
+	//eight bytes of a key, or the table id in a "table_id:row" scheme).
+	//Keys sharing a prefix are grouped together by structures that only
+	//need to distinguish prefixes, such as hash-bucketed memtables.
+	//
+	//A SliceTransform must be thread-safe since its methods may be invoked
+	//concurrently from multiple threads.
+	class SliceTransform
+	{
+	public:
+		virtual ~SliceTransform();
+
+		//The name of the transformation.
+		virtual const char* Name() const = 0;
+
+		//Return the prefix of "key".
+		//REQUIRES: InDomain(key)
+		virtual Slice Transform(const Slice& key) const = 0;
+
+		//Returns true iff "key" has a prefix under this transformation.
+		//Keys outside the domain are treated as their own prefix.
+		virtual bool InDomain(const Slice& key) const = 0;
+	};
+
+	//Return a transformation that maps a key to its first "prefix_len"
+	//bytes. Keys shorter than that are outside its domain. The caller
+	//owns the result.
+	extern const SliceTransform* NewFixedPrefixTransform(size_t prefix_len);
+
+	//Return a transformation that maps every key to itself. The caller
+	//owns the result.
+	extern const SliceTransform* NewNoopTransform();
+
+}
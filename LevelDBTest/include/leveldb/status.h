@@ -34,6 +34,9 @@ namespace leveldb{
 		static Status IOError(const Slice& msg, const Slice& msg2 = Slice()){
 			return Status(kIOError, msg, msg2);
 		}
+		static Status Incomplete(const Slice& msg, const Slice& msg2 = Slice()){
+			return Status(kIncomplete, msg, msg2);
+		}
 
 		//Returns true iff the status indicate success.
 		bool ok() const { return (state_ == NULL); }
@@ -41,6 +44,9 @@ namespace leveldb{
 		//Return true iff the status indicates a NotFound error
 		bool IsNotFound() const { return code() == kNotFound; }
 
+		//Return true iff the status indicates an Incomplete error
+		bool IsIncomplete() const { return code() == kIncomplete; }
+
 		//Return a string representation of this status suitable for printing.
 		//Returns the string "OK" for success.
 		std::string ToString() const;
@@ -60,7 +66,8 @@ namespace leveldb{
 			kCorruption =2,
 			kNotSupported = 3,
 			kInvalidArgument = 4,
-			kIOError = 5
+			kIOError = 5,
+			kIncomplete = 6
 		};
 
 		Code code() const {
@@ -1,11 +1,13 @@
 #pragma once
 #include <stdint.h>
+#include "leveldb/cache.h"
 #include "leveldb/iterator.h"
 
 namespace leveldb{
 
 	class Block;
 	class BlockHandle;
+	class Footer;
 	struct Options;
 	class RandomAccessFile;
 	struct ReadOptions;
@@ -29,18 +31,75 @@ namespace leveldb{
 		//Returns a new iterator voer the table contents.
 		Iterator* NewIterator(const ReadOptions&) const;
 
+		//Returns a new iterator over the contents of the table's range
+		//deletion meta block, or NULL if the table has none.
+		Iterator* NewRangeTombstoneIterator(const ReadOptions&) const;
+
 		//Given a key,return an approximate byte offset in the file where
 		//the data for that key begins(or would begin if the key were
 		//present in the file).The returned value is in terms of file
 		//bytes, and so includes effects like compression of the underlying data.
 		uint64_t ApproximateOffsetOf(const Slice& key) const;
 
+		//Returns false if no key in the table has the prefix "prefix" under
+		//the options.prefix_extractor the table was opened with. Returns
+		//true if the table has no prefix filter, or one built by another
+		//extractor.
+		bool PrefixMayMatch(const Slice& prefix) const;
+
+		//Returns the number of bytes of data blocks read from the file
+		//since the table was opened. Blocks found in the block cache are
+		//not counted.
+		uint64_t BytesRead() const;
+
+		//The data block holding an entry passed to an InternalGet()
+		//callback. A callback that keeps a Slice into the block sets
+		//"taken", and (*release)(arg1, arg2) must then be called once the
+		//Slice is no longer used.
+		struct BlockPin
+		{
+			Iterator::CleanupFunction release;
+			void* arg1;
+			void* arg2;
+			bool taken;
+		};
+
+		//Calls (*handle_result)(arg, key, value, pin) on the entries of the
+		//table from the first one >= "key", in order, until it returns
+		//false or the table ends. Unlike a lookup through NewIterator()
+		//this does not allocate when the blocks are in memory. A callback
+		//that takes the pin must return false.
+		Status InternalGet(const ReadOptions& options,
+			const Slice& key,
+			void* arg,
+			bool(*handle_result)(void* arg, const Slice& k, const Slice& v, BlockPin* pin)) const;
+
 	private:
 		struct Rep;
 		Rep* rep_;
 
 		explicit Table(Rep* rep){ rep_ = rep; }
 		static Iterator* BlockReader(void*, const ReadOptions&, const Slice&);
+		void ReadMeta(const Footer& footer);
+
+		//Return an iterator over the index block, which is read through
+		//the block cache if options.cache_index_and_filter_blocks is set.
+		Iterator* NewIndexIterator() const;
+
+		//Store the index block in *block. If it is not held by the table,
+		//*cache_handle is set to the handle to release once done with it,
+		//or to NULL if the caller must delete it.
+		Status ReadIndexBlock(Block** block, Cache::Handle** cache_handle) const;
+
+		//Read the data block at "index_value", an encoded BlockHandle,
+		//through the block cache if there is one. On success *cache_handle
+		//is the handle to release once done with *block, or NULL if the
+		//caller must delete it.
+		Status ReadDataBlock(const ReadOptions& options, const Slice& index_value,
+			Block** block, Cache::Handle** cache_handle) const;
+
+		//PrefixMayMatch() for a prefix filter kept in the block cache.
+		bool CachedPrefixMayMatch(const Slice& prefix) const;
 
 		//No copying allowed
 		Table(const Table&);
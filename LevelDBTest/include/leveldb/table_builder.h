@@ -15,16 +15,30 @@ namespace leveldb{
 	public:
 		//Create a builder that will store the contents of the table it is 
 		//building in *file.
+		//If options.table_build_threads > 0, that many worker threads are
+		//started to compress and checksum finished data blocks; they are
+		//stopped by Finish() or Abandon().
 		TableBuilder(const Options& options, WritableFile* file);
 		~TableBuilder();
 
 		//Change the options used by this builder.
+		//Note: the number of worker threads is fixed at construction.
 		Status ChangeOptions(const Options);
 
 		//Add key, value to the table being constructed.
 		void Add(const Slice& key, const Slice& value);
 
+		//Add a range tombstone to the table's range deletion meta block
+		//rather than to the data blocks. "key" is the encoded begin key and
+		//"value" the exclusive end of the deleted range. Tombstones may be
+		//added in any order relative to Add(), but must be sorted among
+		//themselves. The caller should widen the file's recorded key range to
+		//cover every tombstone so that lookups consult the block.
+		void AddRangeTombstone(const Slice& key, const Slice& value);
+
 		//Advanced operation: flush any buffered key/value pairs to file.
+		//With Options::table_build_threads the block is only queued; it
+		//reaches the file once the next key is added or Finish() is called.
 		void Flush();
 
 		//Return non-ok iff some error has been detected.
@@ -39,12 +53,23 @@ namespace leveldb{
 		//Number of calls to Add() so far.
 		uint64_t NumEntries() const;
 
-		//Size of the file generated so far.
+		//Size of the file generated so far. With
+		//Options::table_build_threads this includes the blocks queued for
+		//the workers at their uncompressed size.
 		uint64_t FileSize() const;
 	protected:
 	private:
 		bool ok() const { return status().ok(); }
 		void WriteBlock(BlockBuilder* block, BlockHandle* handle);
+		void WriteRawBlock(const Slice& block_contents, const char* trailer,
+			BlockHandle* handle);
+
+		//Pipelined mode (options.table_build_threads > 0)
+		void QueueBlock(BlockBuilder* block);
+		void WriteQueuedBlocks(size_t max_in_flight);
+		void AddIndexEntry(const Slice& key, const BlockHandle& handle);
+		void StopWorkers();
+		static void BGWork(void* rep);
 
 		struct Rep;
 		Rep* rep_;
@@ -11,4 +11,22 @@
 #include "port/port_android.h"
 #elif defined(LEVELDB_PLATFORM_WINDOWS)
 #include "port/port_win.h"
-#endif
\ No newline at end of file
+#endif
+
+//Hint the processor to fetch the cache line holding "addr" ahead of use.
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#define LEVELDB_PREFETCH(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
+#elif defined(__GNUC__)
+#define LEVELDB_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define LEVELDB_PREFETCH(addr)
+#endif
+
+//Storage class for a variable with one instance per thread. Only
+//plain data such as pointers may be declared with it.
+#if defined(_MSC_VER)
+#define LEVELDB_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define LEVELDB_THREAD_LOCAL __thread
+#endif
@@ -0,0 +1,31 @@
+#include "port/port_win.h"
+
+#include <windows.h>
+
+namespace leveldb {
+	namespace port {
+
+		void* AtomicPointer::Swap(void* v) {
+			return InterlockedExchangePointer(&rep_, v);
+		}
+
+		bool AtomicPointer::CompareAndSwap(void* v, void** expected) {
+			void* old = InterlockedCompareExchangePointer(&rep_, v, *expected);
+			if (old == *expected) {
+				return true;
+			}
+			*expected = old;
+			return false;
+		}
+
+		int64_t AtomicCounter::Add(int64_t n) {
+			return InterlockedExchangeAdd64(&rep_, n) + n;
+		}
+
+		int64_t AtomicCounter::Load() const {
+			// Adding zero reads all 64 bits at once, also on 32-bit targets
+			return InterlockedExchangeAdd64(const_cast<volatile int64_t*>(&rep_), 0);
+		}
+
+	}  // namespace port
+}  // namespace leveldb
@@ -105,6 +105,29 @@ namespace leveldb {
 			void* NoBarrier_Load() const;
 
 			void NoBarrier_Store(void* v);
+
+			// Atomically replaces the pointer with "v" and returns the old
+			// value. Acts as a full memory barrier.
+			void* Swap(void* v);
+
+			// Atomically replaces the pointer with "v" if it equals *expected
+			// and returns true. Otherwise stores the current value in
+			// *expected and returns false. Acts as a full memory barrier.
+			bool CompareAndSwap(void* v, void** expected);
+		};
+
+		// A 64-bit counter that many threads may update without a lock.
+		class AtomicCounter {
+		private:
+			volatile int64_t rep_;
+		public:
+			AtomicCounter() : rep_(0) { }
+
+			// Atomically adds "n" and returns the new value.
+			int64_t Add(int64_t n);
+
+			// Returns the current value.
+			int64_t Load() const;
 		};
 
 		inline bool Snappy_Compress(const char* input, size_t length,
@@ -253,6 +276,29 @@ namespace leveldb {
 			void* NoBarrier_Load() const;
 
 			void NoBarrier_Store(void* v);
+
+			// Atomically replaces the pointer with "v" and returns the old
+			// value. Acts as a full memory barrier.
+			void* Swap(void* v);
+
+			// Atomically replaces the pointer with "v" if it equals *expected
+			// and returns true. Otherwise stores the current value in
+			// *expected and returns false. Acts as a full memory barrier.
+			bool CompareAndSwap(void* v, void** expected);
+		};
+
+		// A 64-bit counter that many threads may update without a lock.
+		class AtomicCounter {
+		private:
+			volatile int64_t rep_;
+		public:
+			AtomicCounter() : rep_(0) { }
+
+			// Atomically adds "n" and returns the new value.
+			int64_t Add(int64_t n);
+
+			// Returns the current value.
+			int64_t Load() const;
 		};
 
 		inline bool Snappy_Compress(const char* input, size_t length,
@@ -6,6 +6,7 @@
 
 #include "table/block.h"
 
+#include <string.h>
 #include <vector>
 #include <algorithm>
 #include "leveldb/comparator.h"
@@ -70,189 +71,285 @@ namespace leveldb {
 		return p;
 	}
 
-	class Block::Iter : public Iterator{
-	private:
-		const Comparator* const comparator_;
-		const char* const data_;      // underlying block contents
-		uint32_t const restarts_;     // Offset of restart array (list of fixed32)
-		uint32_t const num_restarts_; // Number of uint32_t entries in restart array
-
-		// current_ is offset in data_ of current entry.  >= restarts_ if !Valid
-		uint32_t current_;
-		uint32_t restart_index_;  // Index of restart block in which current_ falls
-		std::string key_;
-		Slice value_;
-		Status status_;
-
-		inline int Compare(const Slice& a, const Slice& b) const {
-			return comparator_->Compare(a, b);
-		}
+	BlockIter::BlockIter()
+		: comparator_(NULL),
+		data_(NULL),
+		restarts_(0),
+		num_restarts_(0),
+		current_(0),
+		restart_index_(0),
+		key_(key_space_),
+		key_size_(0),
+		key_capacity_(sizeof(key_space_)),
+		lower_bound_(NULL),
+		upper_bound_(NULL) {
+	}
 
-		// Return the offset in data_ just past the end of the current entry.
-		inline uint32_t NextEntryOffset() const {
-			return (value_.data() + value_.size()) - data_;
+	BlockIter::~BlockIter() {
+		if (key_ != key_space_) {
+			delete[] key_;
 		}
+	}
 
-		uint32_t GetRestartPoint(uint32_t index) {
-			assert(index < num_restarts_);
-			return DecodeFixed32(data_ + restarts_ + index * sizeof(uint32_t));
-		}
+	void BlockIter::Initialize(const Comparator* comparator,
+		const char* data,
+		uint32_t restarts,
+		uint32_t num_restarts,
+		const Slice* lower_bound,
+		const Slice* upper_bound) {
+		assert(num_restarts > 0);
+		comparator_ = comparator;
+		data_ = data;
+		restarts_ = restarts;
+		num_restarts_ = num_restarts;
+		current_ = restarts_;
+		restart_index_ = num_restarts_;
+		status_ = Status::OK();
+		key_size_ = 0;
+		lower_bound_ = lower_bound;
+		upper_bound_ = upper_bound;
+	}
 
-		void SeekToRestartPoint(uint32_t index) {
-			key_.clear();
-			restart_index_ = index;
-			// current_ will be fixed by ParseNextKey();
+	void BlockIter::Invalidate(const Status& status) {
+		data_ = NULL;
+		restarts_ = 0;
+		num_restarts_ = 0;
+		current_ = 0;
+		restart_index_ = 0;
+		status_ = status;
+		key_size_ = 0;
+		value_.clear();
+	}
 
-			// ParseNextKey() starts at the end of value_, so set value_ accordingly
-			uint32_t offset = GetRestartPoint(index);
-			value_ = Slice(data_ + offset, 0);
-		}
+	inline int BlockIter::Compare(const Slice& a, const Slice& b) const {
+		return comparator_->Compare(a, b);
+	}
 
-	public:
-		Iter(const Comparator* comparator,
-			const char* data,
-			uint32_t restarts,
-			uint32_t num_restarts)
-			: comparator_(comparator),
-			data_(data),
-			restarts_(restarts),
-			num_restarts_(num_restarts),
-			current_(restarts_),
-			restart_index_(num_restarts_) {
-			assert(num_restarts_ > 0);
-		}
+	// Return the offset in data_ just past the end of the current entry.
+	inline uint32_t BlockIter::NextEntryOffset() const {
+		return (value_.data() + value_.size()) - data_;
+	}
 
-		virtual bool Valid() const { return current_ < restarts_; }
-		virtual Status status() const { return status_; }
-		virtual Slice key() const {
-			assert(Valid());
-			return key_;
-		}
-		virtual Slice value() const {
-			assert(Valid());
-			return value_;
-		}
+	inline uint32_t BlockIter::GetRestartPoint(uint32_t index) {
+		assert(index < num_restarts_);
+		return DecodeFixed32(data_ + restarts_ + index * sizeof(uint32_t));
+	}
 
-		virtual void Next() {
-			assert(Valid());
-			ParseNextKey();
-		}
+	void BlockIter::SeekToRestartPoint(uint32_t index) {
+		key_size_ = 0;
+		restart_index_ = index;
+		// current_ will be fixed by ParseNextKey();
 
-		virtual void Prev() {
-			assert(Valid());
-
-			// Scan backwards to a restart point before current_
-			const uint32_t original = current_;
-			while (GetRestartPoint(restart_index_) >= original) {
-				if (restart_index_ == 0) {
-					// No more entries
-					current_ = restarts_;
-					restart_index_ = num_restarts_;
-					return;
-				}
-				restart_index_--;
-			}
+		// ParseNextKey() starts at the end of value_, so set value_ accordingly
+		uint32_t offset = GetRestartPoint(index);
+		value_ = Slice(data_ + offset, 0);
+	}
 
-			SeekToRestartPoint(restart_index_);
-			do {
-				// Loop until end of current entry hits the start of original entry
-			} while (ParseNextKey() && NextEntryOffset() < original);
-		}
+	Slice BlockIter::key() const {
+		assert(Valid());
+		return Slice(key_, key_size_);
+	}
 
-		virtual void Seek(const Slice& target) {
-			// Binary search in restart array to find the first restart point
-			// with a key >= target
-			uint32_t left = 0;
-			uint32_t right = num_restarts_ - 1;
-			while (left < right) {
-				uint32_t mid = (left + right + 1) / 2;
-				uint32_t region_offset = GetRestartPoint(mid);
-				uint32_t shared, non_shared, value_length;
-				const char* key_ptr = DecodeEntry(data_ + region_offset,
-					data_ + restarts_,
-					&shared, &non_shared, &value_length);
-				if (key_ptr == NULL || (shared != 0)) {
-					CorruptionError();
-					return;
-				}
-				Slice mid_key(key_ptr, non_shared);
-				if (Compare(mid_key, target) < 0) {
-					// Key at "mid" is smaller than "target".  Therefore all
-					// blocks before "mid" are uninteresting.
-					left = mid;
-				}
-				else {
-					// Key at "mid" is >= "target".  Therefore all blocks at or
-					// after "mid" are uninteresting.
-					right = mid - 1;
-				}
-			}
+	Slice BlockIter::value() const {
+		assert(Valid());
+		return value_;
+	}
 
-			// Linear search (within restart block) for first key >= target
-			SeekToRestartPoint(left);
-			while (true) {
-				if (!ParseNextKey()) {
-					return;
-				}
-				if (Compare(key_, target) >= 0) {
-					return;
-				}
-			}
+	void BlockIter::Next() {
+		assert(Valid());
+		ParseNextKey();
+		CheckUpperBound();
+	}
+
+	void BlockIter::Prev() {
+		assert(Valid());
+		PrevEntry();
+		CheckLowerBound();
+	}
+
+	void BlockIter::Seek(const Slice& target) {
+		// Nothing below the lower bound may be yielded, so start there
+		if (lower_bound_ != NULL && Compare(target, *lower_bound_) < 0) {
+			SeekEntry(*lower_bound_);
 		}
+		else {
+			SeekEntry(target);
+		}
+		CheckUpperBound();
+	}
 
-		virtual void SeekToFirst() {
+	void BlockIter::SeekToFirst() {
+		if (lower_bound_ != NULL) {
+			SeekEntry(*lower_bound_);
+		}
+		else {
 			SeekToRestartPoint(0);
 			ParseNextKey();
 		}
+		CheckUpperBound();
+	}
 
-		virtual void SeekToLast() {
-			SeekToRestartPoint(num_restarts_ - 1);
-			while (ParseNextKey() && NextEntryOffset() < restarts_) {
-				// Keep skipping
+	void BlockIter::SeekToLast() {
+		if (upper_bound_ != NULL) {
+			// The last entry in bounds precedes the first one >= the bound
+			SeekEntry(*upper_bound_);
+			if (Valid()) {
+				PrevEntry();
+			}
+			else if (status_.ok()) {
+				SeekToLastEntry();
 			}
 		}
+		else {
+			SeekToLastEntry();
+		}
+		CheckLowerBound();
+	}
 
-	private:
-		void CorruptionError() {
-			current_ = restarts_;
-			restart_index_ = num_restarts_;
-			status_ = Status::Corruption("bad entry in block");
-			key_.clear();
-			value_.clear();
+	void BlockIter::MarkInvalid() {
+		current_ = restarts_;
+		restart_index_ = num_restarts_;
+	}
+
+	void BlockIter::CheckUpperBound() {
+		if (upper_bound_ != NULL && Valid() && Compare(key(), *upper_bound_) >= 0) {
+			MarkInvalid();
+		}
+	}
+
+	void BlockIter::CheckLowerBound() {
+		if (lower_bound_ != NULL && Valid() && Compare(key(), *lower_bound_) < 0) {
+			MarkInvalid();
 		}
+	}
 
-		bool ParseNextKey() {
-			current_ = NextEntryOffset();
-			const char* p = data_ + current_;
-			const char* limit = data_ + restarts_;  // Restarts come right after data
-			if (p >= limit) {
-				// No more entries to return.  Mark as invalid.
+	void BlockIter::PrevEntry() {
+		// Scan backwards to a restart point before current_
+		const uint32_t original = current_;
+		while (GetRestartPoint(restart_index_) >= original) {
+			if (restart_index_ == 0) {
+				// No more entries
 				current_ = restarts_;
 				restart_index_ = num_restarts_;
-				return false;
+				return;
 			}
+			restart_index_--;
+		}
+
+		SeekToRestartPoint(restart_index_);
+		do {
+			// Loop until end of current entry hits the start of original entry
+		} while (ParseNextKey() && NextEntryOffset() < original);
+	}
 
-			// Decode next entry
+	void BlockIter::SeekEntry(const Slice& target) {
+		// Binary search in restart array to find the first restart point
+		// with a key >= target
+		uint32_t left = 0;
+		uint32_t right = num_restarts_ - 1;
+		while (left < right) {
+			uint32_t mid = (left + right + 1) / 2;
+			uint32_t region_offset = GetRestartPoint(mid);
 			uint32_t shared, non_shared, value_length;
-			p = DecodeEntry(p, limit, &shared, &non_shared, &value_length);
-			if (p == NULL || key_.size() < shared) {
+			const char* key_ptr = DecodeEntry(data_ + region_offset,
+				data_ + restarts_,
+				&shared, &non_shared, &value_length);
+			if (key_ptr == NULL || (shared != 0)) {
 				CorruptionError();
-				return false;
+				return;
+			}
+			Slice mid_key(key_ptr, non_shared);
+			if (Compare(mid_key, target) < 0) {
+				// Key at "mid" is smaller than "target".  Therefore all
+				// blocks before "mid" are uninteresting.
+				left = mid;
 			}
 			else {
-				key_.resize(shared);
-				key_.append(p, non_shared);
-				value_ = Slice(p + non_shared, value_length);
-				while (restart_index_ + 1 < num_restarts_ &&
-					GetRestartPoint(restart_index_ + 1) < current_) {
-					++restart_index_;
-				}
-				return true;
+				// Key at "mid" is >= "target".  Therefore all blocks at or
+				// after "mid" are uninteresting.
+				right = mid - 1;
 			}
 		}
-	};
 
-	Iterator* Block::NewIterator(const Comparator* cmp) {
+		// Linear search (within restart block) for first key >= target
+		SeekToRestartPoint(left);
+		while (true) {
+			if (!ParseNextKey()) {
+				return;
+			}
+			if (Compare(key(), target) >= 0) {
+				return;
+			}
+		}
+	}
+
+	void BlockIter::SeekToLastEntry() {
+		SeekToRestartPoint(num_restarts_ - 1);
+		while (ParseNextKey() && NextEntryOffset() < restarts_) {
+			// Keep skipping
+		}
+	}
+
+	void BlockIter::CorruptionError() {
+		current_ = restarts_;
+		restart_index_ = num_restarts_;
+		status_ = Status::Corruption("bad entry in block");
+		key_size_ = 0;
+		value_.clear();
+	}
+
+	void BlockIter::UpdateKey(uint32_t shared, const char* p, size_t n) {
+		const size_t size = shared + n;
+		if (size > key_capacity_) {
+			// Grow geometrically; the shared prefix moves along
+			size_t capacity = key_capacity_ * 2;
+			while (capacity < size) {
+				capacity *= 2;
+			}
+			char* buf = new char[capacity];
+			memcpy(buf, key_, shared);
+			if (key_ != key_space_) {
+				delete[] key_;
+			}
+			key_ = buf;
+			key_capacity_ = capacity;
+		}
+		memcpy(key_ + shared, p, n);
+		key_size_ = size;
+	}
+
+	bool BlockIter::ParseNextKey() {
+		current_ = NextEntryOffset();
+		const char* p = data_ + current_;
+		const char* limit = data_ + restarts_;  // Restarts come right after data
+		if (p >= limit) {
+			// No more entries to return.  Mark as invalid.
+			current_ = restarts_;
+			restart_index_ = num_restarts_;
+			return false;
+		}
+
+		// Decode next entry
+		uint32_t shared, non_shared, value_length;
+		p = DecodeEntry(p, limit, &shared, &non_shared, &value_length);
+		if (p == NULL || key_size_ < shared) {
+			CorruptionError();
+			return false;
+		}
+		else {
+			UpdateKey(shared, p, non_shared);
+			value_ = Slice(p + non_shared, value_length);
+			while (restart_index_ + 1 < num_restarts_ &&
+				GetRestartPoint(restart_index_ + 1) < current_) {
+				++restart_index_;
+			}
+			return true;
+		}
+	}
+
+	Iterator* Block::NewIterator(const Comparator* cmp,
+		const Slice* lower_bound,
+		const Slice* upper_bound) {
 		if (size_ < 2 * sizeof(uint32_t)) {
 			return NewErrorIterator(Status::Corruption("bad block contents"));
 		}
@@ -261,7 +358,24 @@ namespace leveldb {
 			return NewEmptyIterator();
 		}
 		else {
-			return new Iter(cmp, data_, restart_offset_, num_restarts);
+			BlockIter* iter = new BlockIter;
+			iter->Initialize(cmp, data_, restart_offset_, num_restarts,
+				lower_bound, upper_bound);
+			return iter;
+		}
+	}
+
+	void Block::InitIterator(const Comparator* cmp, BlockIter* iter) {
+		if (size_ < 2 * sizeof(uint32_t)) {
+			iter->Invalidate(Status::Corruption("bad block contents"));
+			return;
+		}
+		const uint32_t num_restarts = NumRestarts();
+		if (num_restarts == 0) {
+			iter->Invalidate(Status::OK());
+		}
+		else {
+			iter->Initialize(cmp, data_, restart_offset_, num_restarts, NULL, NULL);
 		}
 	}
 
@@ -5,6 +5,7 @@
 
 namespace leveldb{
 
+	class BlockIter;
 	class Comparator;
 
 	class Block{
@@ -14,7 +15,16 @@ namespace leveldb{
 		~Block();
 
 		size_t size() const { return size_; }
-		iterator* NewIterator(const Comparator* comparator);
+		//Returns an iterator over the block. If "lower_bound" or
+		//"upper_bound" is non-NULL, the iterator only yields keys in
+		//[*lower_bound, *upper_bound), which must outlive it.
+		Iterator* NewIterator(const Comparator* comparator,
+			const Slice* lower_bound = NULL,
+			const Slice* upper_bound = NULL);
+
+		//Point *iter, which may live on the stack, at the contents of the
+		//block, so that a lookup can search it without allocating.
+		void InitIterator(const Comparator* comparator, BlockIter* iter);
 
 	private:
 		uint32_t NumRestarts() const;
@@ -24,7 +34,85 @@ namespace leveldb{
 		//No copying allowed
 		Block(const Block&);
 		void operator=(const Block&);
+	};
+
+	//Iterator over the entries of a Block. Keys of up to kInlineKeySize
+	//bytes are rebuilt in an inline buffer, so an iterator set up with
+	//Block::InitIterator() on the stack does not touch the heap.
+	class BlockIter :public Iterator{
+	public:
+		//An iterator that is not Valid() until Initialize()d.
+		BlockIter();
+		virtual ~BlockIter();
+
+		//Iterate over the entries in data[0..restarts), followed by the
+		//array of "num_restarts" restart points.
+		void Initialize(const Comparator* comparator,
+			const char* data,
+			uint32_t restarts,
+			uint32_t num_restarts,
+			const Slice* lower_bound,
+			const Slice* upper_bound);
+
+		//Make the iterator yield nothing, with the given status.
+		void Invalidate(const Status& status);
+
+		virtual bool Valid() const { return current_ < restarts_; }
+		virtual Status status() const { return status_; }
+		virtual Slice key() const;
+		virtual Slice value() const;
+		virtual void Next();
+		virtual void Prev();
+		virtual void Seek(const Slice& target);
+		virtual void SeekToFirst();
+		virtual void SeekToLast();
+
+	private:
+		enum{ kInlineKeySize = 200 };
+
+		const Comparator* comparator_;
+		const char* data_;		//underlying block contents
+		uint32_t restarts_;		//Offset of restart array (list of fixed32)
+		uint32_t num_restarts_;	//Number of uint32_t entries in restart array
+
+		//current_ is offset in data_ of current entry. >= restarts_ if !Valid
+		uint32_t current_;
+		uint32_t restart_index_;	//Index of restart block in which current_ falls
+		Slice value_;
+		Status status_;
+
+		//Key of the current entry: key_size_ bytes at key_, which points
+		//to key_space_ or, for longer keys, to a heap buffer of
+		//key_capacity_ bytes kept for the life of the iterator.
+		char* key_;
+		size_t key_size_;
+		size_t key_capacity_;
+		char key_space_[kInlineKeySize];
 
-		class Iter;
+		//Optional bounds in the block's key space: the iterator becomes
+		//invalid when a forward move reaches a key >= *upper_bound_ or a
+		//backward move reaches a key < *lower_bound_. NULL means unbounded.
+		const Slice* lower_bound_;
+		const Slice* upper_bound_;
+
+		int Compare(const Slice& a, const Slice& b) const;
+		uint32_t NextEntryOffset() const;
+		uint32_t GetRestartPoint(uint32_t index);
+		void SeekToRestartPoint(uint32_t index);
+		void MarkInvalid();
+		void CheckUpperBound();
+		void CheckLowerBound();
+		void PrevEntry();
+		void SeekEntry(const Slice& target);
+		void SeekToLastEntry();
+		void CorruptionError();
+		bool ParseNextKey();
+
+		//Keep the first "shared" bytes of the key and append p[0..n).
+		void UpdateKey(uint32_t shared, const char* p, size_t n);
+
+		//No copying allowed
+		BlockIter(const BlockIter&);
+		void operator=(const BlockIter&);
 	};
 }
\ No newline at end of file
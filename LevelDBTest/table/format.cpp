@@ -71,9 +71,10 @@ namespace leveldb{
 		assert(dst->size() == original_size + kEncodedLength);
 	}
 
-	extern Status ReadBlock(RandomAccessFile* file, const ReadOptions& options, const BlockHandle& handle, Block** block)
+	extern Status ReadBlockContents(RandomAccessFile* file, const ReadOptions& options, const BlockHandle& handle, char** result, size_t* result_size)
 	{
-		*block = NULL;
+		*result = NULL;
+		*result_size = 0;
 
 		//Read the block contents as well as the type/crc footer.
 		size_t n = static_cast<size_t>(handle.size());
@@ -141,10 +142,24 @@ namespace leveldb{
 			return Status::Corruption("bad block type");
 		}
 
-		*block = new Block(buf, n);	//Block takes ownership of buf[]
+		*result = buf;
+		*result_size = n;
 		return Status::OK();
 	}
 
+	extern Status ReadBlock(RandomAccessFile* file, const ReadOptions& options, const BlockHandle& handle, Block** block)
+	{
+		*block = NULL;
+		char* buf;
+		size_t n;
+		Status s = ReadBlockContents(file, options, handle, &buf, &n);
+		if (s.ok())
+		{
+			*block = new Block(buf, n);	//Block takes ownership of buf[]
+		}
+		return s;
+	}
+
 
 }
 
@@ -72,9 +72,28 @@ namespace leveldb {
 	//kTableMagicnumber was picked by running
 	static const size_t kTableMagicNumber = 0xdb4775248b80fb57u11;
 
+	//Name under which the range deletion block of a table is listed in
+	//its metaindex block.
+	static const char kRangeDelBlockName[] = "leveldb.range_del";
+
+	//Prefix of the name under which the prefix bloom filter of a table is
+	//listed in its metaindex block. The name of the prefix extractor that
+	//built the filter follows, so that a table is never probed with
+	//prefixes from a different extractor.
+	static const char kPrefixFilterBlockPrefix[] = "leveldb.prefix_bloom.";
+
 	//1-byte type + 32-bit crc
 	static const size_t kBlockTrailerSize = 5;
 
+	//Read the uncompressed contents of the block identified by "handle"
+	//from "file". On success, *buf is a new[] allocated array holding *n
+	//bytes that the caller must delete[].
+	extern Status ReadBlockContents(RandomAccessFile* file,
+		const ReadOptions& options,
+		const BlockHandle& handle,
+		char** buf,
+		size_t* n);
+
 	//Read the block identified by "handle" from "file".
 	extern Status ReadBlock(RandomAccessFile* file,
 		const ReadOptions& options,
@@ -0,0 +1,316 @@
+#include "table/merger.h"
+
+#include <vector>
+#include "leveldb/comparator.h"
+#include "leveldb/iterator.h"
+#include "table/iterator_wrapper.h"
+
+namespace leveldb{
+
+	namespace {
+		//A binary heap of valid child iterators ordered by their cached
+		//current keys: smallest first, or largest first for a reverse heap.
+		//Ties are broken by position in the children array (lower first
+		//forward, higher first in reverse), so the merge order never
+		//depends on the heap layout.
+		class IteratorHeap{
+		public:
+			IteratorHeap(const Comparator* comparator, bool reverse)
+				:comparator_(comparator),
+				reverse_(reverse)
+			{
+
+			}
+
+			void reserve(int n) { data_.reserve(n); }
+			void clear() { data_.clear(); }
+			bool empty() const { return data_.empty(); }
+			IteratorWrapper* top() const { return data_.empty() ? NULL : data_[0]; }
+
+			void push(IteratorWrapper* child)
+			{
+				data_.push_back(child);
+				SiftUp(data_.size() - 1);
+			}
+
+			//Restore the heap after the key of top() has changed, or drop
+			//top() if it is no longer valid.
+			void UpdateTop()
+			{
+				assert(!data_.empty());
+				if (!data_[0]->Valid())
+				{
+					data_[0] = data_.back();
+					data_.pop_back();
+					if (data_.empty()) return;
+				}
+				SiftDown(0);
+			}
+
+		private:
+			//Returns true if "a" should be yielded before "b".
+			bool Before(const IteratorWrapper* a, const IteratorWrapper* b) const
+			{
+				int r = comparator_->Compare(a->key(), b->key());
+				if (r == 0)
+				{
+					r = (a < b) ? -1 : 1;
+				}
+				return reverse_ ? (r > 0) : (r < 0);
+			}
+
+			void SiftUp(size_t i)
+			{
+				IteratorWrapper* child = data_[i];
+				while (i > 0)
+				{
+					const size_t parent = (i - 1) / 2;
+					if (!Before(child, data_[parent])) break;
+					data_[i] = data_[parent];
+					i = parent;
+				}
+				data_[i] = child;
+			}
+
+			void SiftDown(size_t i)
+			{
+				IteratorWrapper* child = data_[i];
+				const size_t n = data_.size();
+				while (true)
+				{
+					size_t next = 2 * i + 1;
+					if (next >= n) break;
+					if (next + 1 < n && Before(data_[next + 1], data_[next]))
+					{
+						next++;
+					}
+					if (!Before(data_[next], child)) break;
+					data_[i] = data_[next];
+					i = next;
+				}
+				data_[i] = child;
+			}
+
+			const Comparator* comparator_;
+			const bool reverse_;
+			std::vector<IteratorWrapper*> data_;
+		};
+
+		//Keeps the valid children in a heap so that each step costs
+		//O(log n) key comparisons rather than O(n); reads over many
+		//overlapping level-0 files merge dozens of children. Only the heap
+		//for the current direction is maintained and it is rebuilt when
+		//the direction changes.
+		class MergingIterator :public Iterator{
+		public:
+			MergingIterator(const Comparator* comparator, Iterator** children, int n)
+				:comparator_(comparator),
+				children_(new IteratorWrapper[n]),
+				n_(n),
+				current_(NULL),
+				min_heap_(comparator, false),
+				max_heap_(comparator, true),
+				direction_(kForward)
+			{
+				for (int i = 0; i < n; i++)
+				{
+					children_[i].Set(children[i]);
+				}
+				min_heap_.reserve(n);
+				max_heap_.reserve(n);
+			}
+
+			virtual ~MergingIterator(){
+				delete[] children_;
+			}
+
+			virtual bool Valid() const {
+				return (current_ != NULL);
+			}
+
+			virtual void SeekToFirst(){
+				for (int i = 0; i < n_; i++)
+				{
+					children_[i].SeekToFirst();
+				}
+				BuildMinHeap();
+			}
+
+			virtual void SeekToLast(){
+				for (int i = 0; i < n_; i++)
+				{
+					children_[i].SeekToLast();
+				}
+				BuildMaxHeap();
+			}
+
+			virtual void Seek(const Slice& target){
+				for (int i = 0; i < n_; i++)
+				{
+					children_[i].Seek(target);
+				}
+				BuildMinHeap();
+			}
+
+			virtual void Next(){
+				assert(Valid());
+
+				//Ensure that all children are positioned after key().
+				//If we are moving in the forward direction, it is already
+				//true for all of the non-current_ children since current_ is
+				//the smallest child and key() == current_->key(). Otherwise,
+				//we explicitly position the non-current_ children.
+				if (direction_ != kForward)
+				{
+					for (int i = 0; i < n_; i++)
+					{
+						IteratorWrapper* child = &children_[i];
+						if (child != current_)
+						{
+							child->Seek(key());
+							if (child->Valid() &&
+								comparator_->Compare(key(), child->key()) == 0)
+							{
+								child->Next();
+							}
+						}
+					}
+					//current_ is still the smallest child, so it stays on top.
+					BuildMinHeap();
+					assert(min_heap_.top() == current_);
+				}
+
+				current_->Next();
+				min_heap_.UpdateTop();
+				current_ = min_heap_.top();
+			}
+
+			virtual void Prev(){
+				assert(Valid());
+
+				//Ensure that all children are positioned before key().
+				//If we are moving in the reverse direction, it is already
+				//true for all of the non-current_ children since current_ is
+				//the largest child and key() == current_->key(). Otherwise,
+				//we explicitly position the non-current_ children.
+				if (direction_ != kReverse)
+				{
+					for (int i = 0; i < n_; i++)
+					{
+						IteratorWrapper* child = &children_[i];
+						if (child != current_)
+						{
+							child->Seek(key());
+							if (child->Valid())
+							{
+								//Child is at first entry >= key(). Step back one to be < key()
+								child->Prev();
+							}
+							else
+							{
+								//Child has no entries >= key(). Position at last entry.
+								child->SeekToLast();
+							}
+						}
+					}
+					//current_ is still the largest child, so it stays on top.
+					BuildMaxHeap();
+					assert(max_heap_.top() == current_);
+				}
+
+				current_->Prev();
+				max_heap_.UpdateTop();
+				current_ = max_heap_.top();
+			}
+
+			virtual Slice key() const {
+				assert(Valid());
+				return current_->key();
+			}
+
+			virtual Slice value() const {
+				assert(Valid());
+				return current_->value();
+			}
+
+			virtual Status status() const {
+				Status status;
+				for (int i = 0; i < n_; i++)
+				{
+					status = children_[i].status();
+					if (!status.ok())
+					{
+						break;
+					}
+				}
+				return status;
+			}
+
+		private:
+			void BuildMinHeap();
+			void BuildMaxHeap();
+
+			const Comparator* comparator_;
+			IteratorWrapper* children_;
+			int n_;
+			IteratorWrapper* current_;
+			IteratorHeap min_heap_;	//Valid children, when moving forward
+			IteratorHeap max_heap_;	//Valid children, when moving in reverse
+
+			//Which direction is the iterator moving?
+			enum Direction{
+				kForward,
+				kReverse
+			};
+			Direction direction_;
+		};
+
+		void MergingIterator::BuildMinHeap()
+		{
+			min_heap_.clear();
+			max_heap_.clear();
+			for (int i = 0; i < n_; i++)
+			{
+				if (children_[i].Valid())
+				{
+					min_heap_.push(&children_[i]);
+				}
+			}
+			current_ = min_heap_.top();
+			direction_ = kForward;
+		}
+
+		void MergingIterator::BuildMaxHeap()
+		{
+			min_heap_.clear();
+			max_heap_.clear();
+			for (int i = 0; i < n_; i++)
+			{
+				if (children_[i].Valid())
+				{
+					max_heap_.push(&children_[i]);
+				}
+			}
+			current_ = max_heap_.top();
+			direction_ = kReverse;
+		}
+	}
+
+	extern Iterator* NewMergingIterator(const Comparator* cmp, Iterator** list, int n)
+	{
+		assert(n >= 0);
+		if (n == 0)
+		{
+			return NewEmptyIterator();
+		}
+		else if (n == 1)
+		{
+			return list[0];
+		}
+		else
+		{
+			return new MergingIterator(cmp, list, n);
+		}
+	}
+
+}
@@ -0,0 +1,109 @@
+//Measures a readseq scan through the merging iterator: keys spread at
+//random over in-memory sources, as over the memtables and level-0 files
+//of a write-heavy DB. Built as its own console program.
+//
+//Usage: merger_bench [num_entries [num_sources...]]
+//Default: 2000000 entries over 4, 8, 24 and 48 sources.
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "leveldb/comparator.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "table/merger.h"
+#include "util/random.h"
+
+using namespace leveldb;
+
+namespace {
+
+	//Forward iterator over a sorted vector of keys, which it does not own.
+	class VectorIterator :public Iterator
+	{
+	public:
+		explicit VectorIterator(const std::vector<std::string>* keys)
+			:keys_(keys),
+			index_(keys->size())
+		{
+
+		}
+
+		virtual bool Valid() const { return index_ < keys_->size(); }
+		virtual void SeekToFirst() { index_ = 0; }
+		virtual void SeekToLast() { index_ = keys_->empty() ? 0 : keys_->size() - 1; }
+		virtual void Seek(const Slice& target)
+		{
+			index_ = std::lower_bound(keys_->begin(), keys_->end(), target.ToString()) -
+				keys_->begin();
+		}
+		virtual void Next() { index_++; }
+		virtual void Prev() { index_ = (index_ == 0) ? keys_->size() : index_ - 1; }
+		virtual Slice key() const { return (*keys_)[index_]; }
+		virtual Slice value() const { return (*keys_)[index_]; }
+		virtual Status status() const { return Status::OK(); }
+
+	private:
+		const std::vector<std::string>* const keys_;
+		size_t index_;	//keys_->size() when not valid
+	};
+
+}
+
+static void RunReadSeq(int num_entries, int num_sources)
+{
+	//Keys are generated in order, so each source stays sorted.
+	Random rnd(301);
+	std::vector<std::vector<std::string> > sources(num_sources);
+	for (int i = 0; i < num_entries; i++)
+	{
+		char key[20];
+		snprintf(key, sizeof(key), "%016d", i);
+		sources[rnd.Uniform(num_sources)].push_back(key);
+	}
+	std::vector<Iterator*> children;
+	for (int i = 0; i < num_sources; i++)
+	{
+		children.push_back(new VectorIterator(&sources[i]));
+	}
+	Iterator* iter = NewMergingIterator(BytewiseComparator(), &children[0], num_sources);
+
+	Env* env = Env::Default();
+	const uint64_t start = env->NowMicros();
+	int64_t entries = 0;
+	size_t bytes = 0;
+	for (iter->SeekToFirst(); iter->Valid(); iter->Next())
+	{
+		bytes += iter->key().size();
+		entries++;
+	}
+	const uint64_t micros = env->NowMicros() - start;
+	delete iter;
+
+	fprintf(stdout, "readseq %3d sources: %10lld entries %8.1f ns/entry (%llu bytes)\n",
+		num_sources, static_cast<long long>(entries),
+		entries > 0 ? micros * 1000.0 / entries : 0.0,
+		static_cast<unsigned long long>(bytes));
+}
+
+int main(int argc, char** argv)
+{
+	const int num_entries = (argc > 1) ? atoi(argv[1]) : 2000000;
+	if (argc > 2)
+	{
+		for (int i = 2; i < argc; i++)
+		{
+			RunReadSeq(num_entries, atoi(argv[i]));
+		}
+	}
+	else
+	{
+		const int kSources[] = { 4, 8, 24, 48 };
+		for (size_t i = 0; i < sizeof(kSources) / sizeof(kSources[0]); i++)
+		{
+			RunReadSeq(num_entries, kSources[i]);
+		}
+	}
+	return 0;
+}
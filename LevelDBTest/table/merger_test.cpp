@@ -0,0 +1,156 @@
+//Checks the merging iterator against a sorted reference: forward and
+//reverse scans and random walks that switch between Next() and Prev(),
+//over random sets of children. Built as its own console program.
+#include <algorithm>
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "leveldb/comparator.h"
+#include "leveldb/iterator.h"
+#include "table/merger.h"
+#include "util/random.h"
+
+using namespace leveldb;
+
+namespace {
+
+	//Iterator over a sorted vector of keys, each yielding "value".
+	class VectorIterator :public Iterator
+	{
+	public:
+		VectorIterator(const std::vector<std::string>& keys, const std::string& value)
+			:keys_(keys),
+			value_(value),
+			index_(keys.size())
+		{
+
+		}
+
+		virtual bool Valid() const { return index_ < keys_.size(); }
+		virtual void SeekToFirst() { index_ = 0; }
+		virtual void SeekToLast() { index_ = keys_.empty() ? 0 : keys_.size() - 1; }
+		virtual void Seek(const Slice& target)
+		{
+			index_ = std::lower_bound(keys_.begin(), keys_.end(), target.ToString()) -
+				keys_.begin();
+		}
+		virtual void Next() { assert(Valid()); index_++; }
+		virtual void Prev()
+		{
+			assert(Valid());
+			index_ = (index_ == 0) ? keys_.size() : index_ - 1;
+		}
+		virtual Slice key() const { assert(Valid()); return keys_[index_]; }
+		virtual Slice value() const { assert(Valid()); return value_; }
+		virtual Status status() const { return Status::OK(); }
+
+	private:
+		const std::vector<std::string> keys_;
+		const std::string value_;
+		size_t index_;	//keys_.size() when not valid
+	};
+
+}
+
+static std::string RandomKey(Random* rnd)
+{
+	char buf[20];
+	snprintf(buf, sizeof(buf), "%06d", static_cast<int>(rnd->Uniform(1000)));
+	return std::string(buf);
+}
+
+//Merge "n" random children and compare every way of walking the result
+//with "expected", the sorted union of their keys.
+static void TestRandomChildren(Random* rnd, int n)
+{
+	std::vector<Iterator*> children;
+	std::vector<std::string> expected;
+	for (int i = 0; i < n; i++)
+	{
+		std::vector<std::string> keys;
+		const int num_keys = rnd->Uniform(40);
+		for (int j = 0; j < num_keys; j++)
+		{
+			keys.push_back(RandomKey(rnd));
+		}
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+		expected.insert(expected.end(), keys.begin(), keys.end());
+		char value[20];
+		snprintf(value, sizeof(value), "%d", i);
+		children.push_back(new VectorIterator(keys, value));
+	}
+	std::sort(expected.begin(), expected.end());
+
+	Iterator* iter = NewMergingIterator(BytewiseComparator(),
+		children.empty() ? NULL : &children[0], n);
+
+	std::vector<std::string> got;
+	for (iter->SeekToFirst(); iter->Valid(); iter->Next())
+	{
+		got.push_back(iter->key().ToString());
+	}
+	assert(got == expected);
+
+	got.clear();
+	for (iter->SeekToLast(); iter->Valid(); iter->Prev())
+	{
+		got.push_back(iter->key().ToString());
+	}
+	std::reverse(got.begin(), got.end());
+	assert(got == expected);
+
+	//Random walks. A key held by several children has no single position
+	//to step back to, so moves onto or off such a run are skipped.
+	for (int walk = 0; walk < 10 && !expected.empty(); walk++)
+	{
+		const std::string target = RandomKey(rnd);
+		size_t pos = std::lower_bound(expected.begin(), expected.end(), target) -
+			expected.begin();
+		iter->Seek(target);
+		for (int step = 0; step < 200; step++)
+		{
+			if (pos == expected.size())
+			{
+				assert(!iter->Valid());
+				break;
+			}
+			assert(iter->Valid());
+			assert(iter->key() == Slice(expected[pos]));
+			if (rnd->OneIn(2))
+			{
+				if (pos + 1 < expected.size() && expected[pos + 1] == expected[pos])
+				{
+					continue;
+				}
+				iter->Next();
+				pos++;
+			}
+			else
+			{
+				if (pos == 0 || expected[pos - 1] == expected[pos])
+				{
+					continue;
+				}
+				iter->Prev();
+				pos--;
+			}
+		}
+	}
+	assert(iter->status().ok());
+	delete iter;
+}
+
+int main(int argc, char** argv)
+{
+	Random rnd(301);
+	for (int i = 0; i < 500; i++)
+	{
+		//Up to 48 children, past the 20+ sources of a deep LSM tree
+		TestRandomChildren(&rnd, rnd.Uniform(49));
+	}
+	fprintf(stderr, "PASS\n");
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include "table/prefix_filter.h"
+
+#include "util/hash.h"
+
+namespace leveldb{
+
+	static uint32_t PrefixHash(const Slice& prefix)
+	{
+		return Hash(prefix.data(), prefix.size(), 0xbc9f1d34);
+	}
+
+	PrefixFilterBuilder::PrefixFilterBuilder(int bits_per_key)
+		:bits_per_key_(bits_per_key)
+	{
+		//We intentionally round down to reduce probing cost a little bit
+		k_ = static_cast<size_t>(bits_per_key * 0.69);	//0.69 =~ ln(2)
+		if (k_ < 1) k_ = 1;
+		if (k_ > 30) k_ = 30;
+	}
+
+	void PrefixFilterBuilder::AddPrefix(const Slice& prefix)
+	{
+		if (!hashes_.empty() && Slice(last_prefix_) == prefix)
+		{
+			return;
+		}
+		last_prefix_.assign(prefix.data(), prefix.size());
+		hashes_.push_back(PrefixHash(prefix));
+	}
+
+	Slice PrefixFilterBuilder::Finish()
+	{
+		//Compute bloom filter size (in both bits and bytes)
+		size_t bits = hashes_.size() * bits_per_key_;
+
+		//For small n, we can see a very high false positive rate. Fix it
+		//by enforcing a minimum bloom filter length.
+		if (bits < 64) bits = 64;
+
+		const size_t bytes = (bits + 7) / 8;
+		bits = bytes * 8;
+
+		result_.assign(bytes, 0);
+		result_.push_back(static_cast<char>(k_));	//Remember # of probes in filter
+		char* array = &result_[0];
+		for (size_t i = 0; i < hashes_.size(); i++)
+		{
+			//Use double-hashing to generate a sequence of hash values.
+			uint32_t h = hashes_[i];
+			const uint32_t delta = (h >> 17) | (h << 15);	//Rotate right 17 bits
+			for (size_t j = 0; j < k_; j++)
+			{
+				const uint32_t bitpos = h % bits;
+				array[bitpos / 8] |= (1 << (bitpos % 8));
+				h += delta;
+			}
+		}
+		return Slice(result_);
+	}
+
+	bool PrefixFilterMayMatch(const Slice& prefix, const Slice& filter)
+	{
+		const size_t len = filter.size();
+		if (len < 2) return true;
+
+		const char* array = filter.data();
+		const size_t bits = (len - 1) * 8;
+
+		//Use the encoded k so that we can read filters generated by
+		//builders with different parameters.
+		const size_t k = static_cast<unsigned char>(array[len - 1]);
+		if (k > 30)
+		{
+			//Reserved for potentially new encodings. Consider it a match.
+			return true;
+		}
+
+		uint32_t h = PrefixHash(prefix);
+		const uint32_t delta = (h >> 17) | (h << 15);	//Rotate right 17 bits
+		for (size_t j = 0; j < k; j++)
+		{
+			const uint32_t bitpos = h % bits;
+			if ((array[bitpos / 8] & (1 << (bitpos % 8))) == 0) return false;
+			h += delta;
+		}
+		return true;
+	}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "leveldb/slice.h"
+
+namespace leveldb{
+
+	//PrefixFilterBuilder builds the prefix bloom filter of a table: a
+	//bloom filter over the distinct key prefixes (see
+	//Options::prefix_extractor) of the keys in the table. It is stored as
+	//a meta block and lets an iterator that stays within one prefix skip
+	//the table without reading its index or data blocks.
+	//
+	//The filter is a bit array followed by one byte holding the number of
+	//probes, so that readers need no knowledge of the bits per key used.
+	class PrefixFilterBuilder
+	{
+	public:
+		explicit PrefixFilterBuilder(int bits_per_key);
+
+		//Add "prefix" to the filter. Keys are added in sorted order, so a
+		//prefix equal to the previous one is ignored.
+		void AddPrefix(const Slice& prefix);
+
+		//Return true iff no prefix has been added.
+		bool empty() const { return hashes_.empty(); }
+
+		//Finish building the filter and return a slice that refers to its
+		//contents. The slice remains valid for the lifetime of this builder.
+		Slice Finish();
+
+	private:
+		const int bits_per_key_;
+		size_t k_;	//Number of probes
+		std::string last_prefix_;
+		std::vector<uint32_t> hashes_;	//Hashes of the distinct prefixes
+		std::string result_;
+
+		//No copying allowed
+		PrefixFilterBuilder(const PrefixFilterBuilder&);
+		void operator=(const PrefixFilterBuilder&);
+	};
+
+	//Returns false if "prefix" was certainly not added to the filter whose
+	//contents are "filter". A malformed filter matches every prefix.
+	extern bool PrefixFilterMayMatch(const Slice& prefix, const Slice& filter);
+
+}
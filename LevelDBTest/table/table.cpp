@@ -0,0 +1,655 @@
+#include "leveldb/table.h"
+
+#include "leveldb/cache.h"
+#include "leveldb/comparator.h"
+#include "leveldb/env.h"
+#include "leveldb/options.h"
+#include "leveldb/slice_transform.h"
+#include "port/port.h"
+#include "table/block.h"
+#include "table/format.h"
+#include "table/prefix_filter.h"
+#include "table/two_level_iterator.h"
+#include "util/coding.h"
+
+namespace leveldb{
+
+	struct Table::Rep
+	{
+		~Rep()
+		{
+			delete[] prefix_filter_data;
+			delete range_del_block;
+			delete index_block;
+		}
+
+		Options options;
+		Status status;
+		RandomAccessFile* file;
+		uint64_t cache_id;
+
+		BlockHandle metaindex_handle;	//Handle to metaindex_block: saved from footer
+		BlockHandle index_handle;
+		Block* index_block;	//NULL if the index block is kept in the block cache
+		Block* range_del_block;	//NULL if the table has no range tombstones
+
+		Slice prefix_filter;	//Empty if the table has no usable prefix filter
+		const char* prefix_filter_data;	//Owned by the Rep, or NULL
+
+		//If set, the prefix filter at prefix_filter_handle is kept in the
+		//block cache rather than in prefix_filter
+		bool prefix_filter_cached;
+		BlockHandle prefix_filter_handle;
+
+		port::AtomicCounter bytes_read;	//Data block bytes read from file
+	};
+
+	static void DeleteBlock(void* arg, void* ignored)
+	{
+		delete reinterpret_cast<Block*>(arg);
+	}
+
+	static void DeleteCachedBlock(const Slice& key, void* value)
+	{
+		Block* block = reinterpret_cast<Block*>(value);
+		delete block;
+	}
+
+	static void ReleaseBlock(void* arg, void* h)
+	{
+		Cache* cache = reinterpret_cast<Cache*>(arg);
+		Cache::Handle* handle = reinterpret_cast<Cache::Handle*>(h);
+		cache->Release(handle);
+	}
+
+	//A cached prefix filter is a Slice over the contents of its block
+	static void DeleteCachedFilter(const Slice& key, void* value)
+	{
+		Slice* filter = reinterpret_cast<Slice*>(value);
+		delete[] filter->data();
+		delete filter;
+	}
+
+	//Cache keys are the table's cache id followed by the block offset.
+	static Slice BlockCacheKey(uint64_t cache_id, const BlockHandle& handle,
+		char* buf)
+	{
+		EncodeFixed64(buf, cache_id);
+		EncodeFixed64(buf + 8, handle.offset());
+		return Slice(buf, 16);
+	}
+
+	//Insert an index or filter block read when the table is opened, so
+	//that its first users find it. It is released at once: like any
+	//cached block it stays only as long as the cache has room for it.
+	static void InsertMetaBlock(const Options& options, uint64_t cache_id,
+		const BlockHandle& handle, void* value, size_t charge,
+		void(*deleter)(const Slice& key, void* value))
+	{
+		char cache_key_buffer[16];
+		Slice key = BlockCacheKey(cache_id, handle, cache_key_buffer);
+		options.block_cache->Insert(key, value, charge, deleter, NULL,
+			Cache::HIGH, options.block_cache_owner);
+	}
+
+	//Find the block at "handle" in options.block_cache, or read it from
+	//"file" and, if "fill_cache" is set, insert it with "priority". On
+	//success stores the block in *block, and in *cache_handle the handle
+	//to release once done with it, or NULL if the block is not in the
+	//cache (a strict capacity limit may refuse it) and the caller must
+	//delete it. *read tells whether the file was read.
+	static Status ReadCachedBlock(const Options& options, uint64_t cache_id,
+		RandomAccessFile* file, const ReadOptions& read_options, bool fill_cache,
+		Cache::Priority priority, const BlockHandle& handle,
+		Block** block, Cache::Handle** cache_handle, bool* read)
+	{
+		Cache* block_cache = options.block_cache;
+		char cache_key_buffer[16];
+		Slice key = BlockCacheKey(cache_id, handle, cache_key_buffer);
+		*cache_handle = block_cache->Lookup(key);
+		*read = (*cache_handle == NULL);
+		if (*cache_handle != NULL)
+		{
+			*block = reinterpret_cast<Block*>(block_cache->Value(*cache_handle));
+			return Status::OK();
+		}
+
+		Status s = ReadBlock(file, read_options, handle, block);
+		if (s.ok() && fill_cache)
+		{
+			block_cache->Insert(key, *block, (*block)->size(), &DeleteCachedBlock,
+				cache_handle, priority, options.block_cache_owner);
+		}
+		return s;
+	}
+
+	//Return an iterator over "block" that frees it, or releases
+	//"cache_handle" if the block is cached, when deleted.
+	static Iterator* NewBlockIterator(Block* block, Cache* block_cache,
+		Cache::Handle* cache_handle, const Comparator* comparator,
+		const Slice* lower_bound, const Slice* upper_bound)
+	{
+		Iterator* iter = block->NewIterator(comparator, lower_bound, upper_bound);
+		if (cache_handle == NULL)
+		{
+			iter->RegisterCleanup(&DeleteBlock, block, NULL);
+		}
+		else
+		{
+			iter->RegisterCleanup(&ReleaseBlock, block_cache, cache_handle);
+		}
+		return iter;
+	}
+
+	Status Table::Open(const Options& options,
+		RandomAccessFile* file,
+		uint64_t size,
+		Table** table)
+	{
+		*table = NULL;
+		if (size < Footer::kEncodedLength)
+		{
+			return Status::InvalidArgument("file is too short to be an sstable");
+		}
+
+		char footer_space[Footer::kEncodedLength];
+		Slice footer_input;
+		Status s = file->Read(size - Footer::kEncodedLength, Footer::kEncodedLength,
+			&footer_input, footer_space);
+		if (!s.ok()) return s;
+
+		Footer footer;
+		s = footer.DecodeFrom(&footer_input);
+		if (!s.ok()) return s;
+
+		//Read the index block
+		Block* index_block = NULL;
+		if (s.ok())
+		{
+			ReadOptions opt;
+			opt.verify_checksums = options.paranoid_checks;
+			s = ReadBlock(file, opt, footer.index_handle(), &index_block);
+		}
+
+		if (s.ok())
+		{
+			//We've successfully read the footer and the index block: we're
+			//ready to serve requests.
+			Rep* rep = new Table::Rep;
+			rep->options = options;
+			rep->file = file;
+			rep->metaindex_handle = footer.metaindex_handle();
+			rep->index_handle = footer.index_handle();
+			rep->index_block = index_block;
+			rep->cache_id = (options.block_cache ? options.block_cache->NewId() : 0);
+			rep->range_del_block = NULL;
+			rep->prefix_filter_data = NULL;
+			rep->prefix_filter_cached = false;
+			if (rep->options.block_cache != NULL && rep->options.cache_index_and_filter_blocks)
+			{
+				//Hand the index block over to the cache, which may evict it
+				rep->index_block = NULL;
+				InsertMetaBlock(rep->options, rep->cache_id, rep->index_handle,
+					index_block, index_block->size(), &DeleteCachedBlock);
+			}
+			*table = new Table(rep);
+			(*table)->ReadMeta(footer);
+		}
+		else
+		{
+			if (index_block) delete index_block;
+		}
+
+		return s;
+	}
+
+	void Table::ReadMeta(const Footer& footer)
+	{
+		//Meta blocks only speed up or refine reads, so a table whose
+		//metaindex cannot be read is still served (without them) unless
+		//the caller asked for paranoid checks.
+		ReadOptions opt;
+		opt.verify_checksums = rep_->options.paranoid_checks;
+		Block* meta = NULL;
+		if (!ReadBlock(rep_->file, opt, footer.metaindex_handle(), &meta).ok())
+		{
+			return;
+		}
+
+		Iterator* iter = meta->NewIterator(BytewiseComparator());
+		iter->Seek(kRangeDelBlockName);
+		if (iter->Valid() && iter->key() == Slice(kRangeDelBlockName))
+		{
+			Slice v = iter->value();
+			BlockHandle handle;
+			if (handle.DecodeFrom(&v).ok())
+			{
+				ReadBlock(rep_->file, opt, handle, &rep_->range_del_block);
+			}
+		}
+
+		if (rep_->options.prefix_extractor != NULL)
+		{
+			std::string key = kPrefixFilterBlockPrefix;
+			key.append(rep_->options.prefix_extractor->Name());
+			iter->Seek(key);
+			if (iter->Valid() && iter->key() == Slice(key))
+			{
+				Slice v = iter->value();
+				BlockHandle handle;
+				char* buf;
+				size_t n;
+				if (handle.DecodeFrom(&v).ok() &&
+					ReadBlockContents(rep_->file, opt, handle, &buf, &n).ok())
+				{
+					if (rep_->options.block_cache != NULL &&
+						rep_->options.cache_index_and_filter_blocks)
+					{
+						rep_->prefix_filter_cached = true;
+						rep_->prefix_filter_handle = handle;
+						InsertMetaBlock(rep_->options, rep_->cache_id, handle,
+							new Slice(buf, n), n, &DeleteCachedFilter);
+					}
+					else
+					{
+						rep_->prefix_filter_data = buf;
+						rep_->prefix_filter = Slice(buf, n);
+					}
+				}
+			}
+		}
+		delete iter;
+		delete meta;
+	}
+
+	Table::~Table()
+	{
+		delete rep_;
+	}
+
+	Status Table::ReadDataBlock(const ReadOptions& options, const Slice& index_value,
+		Block** block, Cache::Handle** cache_handle) const
+	{
+		Cache* block_cache = rep_->options.block_cache;
+		*block = NULL;
+		*cache_handle = NULL;
+
+		BlockHandle handle;
+		Slice input = index_value;
+		Status s = handle.DecodeFrom(&input);
+		//We intentionally allow extra stuff in index_value so that we
+		//can add more features in the future.
+
+		if (s.ok())
+		{
+			if (block_cache != NULL)
+			{
+				//Data blocks go to the low-priority pool, so that a scan
+				//evicts other data blocks before any index or filter
+				bool read;
+				s = ReadCachedBlock(rep_->options, rep_->cache_id,
+					rep_->file, options, options.fill_cache, Cache::LOW,
+					handle, block, cache_handle, &read);
+				if (read)
+				{
+					rep_->bytes_read.Add(handle.size());
+				}
+			}
+			else
+			{
+				s = ReadBlock(rep_->file, options, handle, block);
+				rep_->bytes_read.Add(handle.size());
+			}
+		}
+		return s;
+	}
+
+	//Convert an index iterator value (i.e., an encoded BlockHandle)
+	//into an iterator over the contents of the corresponding block.
+	Iterator* Table::BlockReader(void* arg,
+		const ReadOptions& options,
+		const Slice& index_value)
+	{
+		Table* table = reinterpret_cast<Table*>(arg);
+		Block* block;
+		Cache::Handle* cache_handle;
+		Status s = table->ReadDataBlock(options, index_value, &block, &cache_handle);
+
+		Iterator* iter;
+		if (s.ok() && block != NULL)
+		{
+			iter = NewBlockIterator(block, table->rep_->options.block_cache, cache_handle,
+				table->rep_->options.comparator,
+				options.iterate_lower_bound, options.iterate_upper_bound);
+		}
+		else
+		{
+			iter = NewErrorIterator(s);
+		}
+		return iter;
+	}
+
+	Status Table::ReadIndexBlock(Block** block, Cache::Handle** cache_handle) const
+	{
+		*cache_handle = NULL;
+		if (rep_->index_block != NULL)
+		{
+			*block = rep_->index_block;
+			return Status::OK();
+		}
+
+		//The index block was evicted or never cached: read it back, and
+		//keep it in the high-priority pool
+		ReadOptions opt;
+		opt.verify_checksums = rep_->options.paranoid_checks;
+		bool read;
+		return ReadCachedBlock(rep_->options, rep_->cache_id, rep_->file,
+			opt, true, Cache::HIGH, rep_->index_handle, block, cache_handle, &read);
+	}
+
+	Iterator* Table::NewIndexIterator() const
+	{
+		Block* block = NULL;
+		Cache::Handle* cache_handle = NULL;
+		Status s = ReadIndexBlock(&block, &cache_handle);
+		if (!s.ok())
+		{
+			return NewErrorIterator(s);
+		}
+		if (block == rep_->index_block)
+		{
+			return block->NewIterator(rep_->options.comparator);
+		}
+		return NewBlockIterator(block, rep_->options.block_cache, cache_handle,
+			rep_->options.comparator, NULL, NULL);
+	}
+
+	Status Table::InternalGet(const ReadOptions& options,
+		const Slice& k,
+		void* arg,
+		bool(*handle_result)(void*, const Slice&, const Slice&, BlockPin*)) const
+	{
+		Block* index_block;
+		Cache::Handle* index_handle;
+		Status s = ReadIndexBlock(&index_block, &index_handle);
+		if (!s.ok())
+		{
+			return s;
+		}
+
+		//The iterators live on the stack, and cached blocks are used in
+		//place, so a lookup served from memory makes no allocation.
+		const Comparator* comparator = rep_->options.comparator;
+		BlockIter index_iter;
+		index_block->InitIterator(comparator, &index_iter);
+		bool more = true;
+		bool first = true;
+		for (index_iter.Seek(k); more && index_iter.Valid(); index_iter.Next())
+		{
+			Block* block;
+			Cache::Handle* cache_handle;
+			s = ReadDataBlock(options, index_iter.value(), &block, &cache_handle);
+			if (!s.ok())
+			{
+				break;
+			}
+
+			BlockPin pin;
+			if (cache_handle != NULL)
+			{
+				pin.release = &ReleaseBlock;
+				pin.arg1 = rep_->options.block_cache;
+				pin.arg2 = cache_handle;
+			}
+			else
+			{
+				pin.release = &DeleteBlock;
+				pin.arg1 = block;
+				pin.arg2 = NULL;
+			}
+			pin.taken = false;
+
+			{
+				BlockIter block_iter;
+				block->InitIterator(comparator, &block_iter);
+				//Later blocks start past "k"
+				if (first)
+				{
+					block_iter.Seek(k);
+					first = false;
+				}
+				else
+				{
+					block_iter.SeekToFirst();
+				}
+				for (; block_iter.Valid(); block_iter.Next())
+				{
+					if (!(*handle_result)(arg, block_iter.key(), block_iter.value(), &pin))
+					{
+						more = false;
+						break;
+					}
+					assert(!pin.taken);
+				}
+				if (more)
+				{
+					s = block_iter.status();
+					more = s.ok();
+				}
+			}
+			if (!pin.taken)
+			{
+				(*pin.release)(pin.arg1, pin.arg2);
+			}
+		}
+		if (s.ok() && more)
+		{
+			s = index_iter.status();
+		}
+
+		if (index_block != rep_->index_block)
+		{
+			if (index_handle != NULL)
+			{
+				rep_->options.block_cache->Release(index_handle);
+			}
+			else
+			{
+				delete index_block;
+			}
+		}
+		return s;
+	}
+
+	namespace {
+		//Iterator over the index block of a bounded read. Each index key
+		//is >= every key of its data block and < every key of the next,
+		//so once it moves past a key >= the upper bound (or, backwards,
+		//onto a key < the lower bound) the remaining blocks hold nothing
+		//in bounds, and it stops before they are read.
+		class BoundedIndexIterator :public Iterator{
+		public:
+			BoundedIndexIterator(Iterator* iter, const Comparator* comparator,
+				const Slice* lower_bound, const Slice* upper_bound)
+				:iter_(iter),
+				comparator_(comparator),
+				lower_bound_(lower_bound),
+				upper_bound_(upper_bound),
+				done_(false)
+			{
+
+			}
+			virtual ~BoundedIndexIterator() { delete iter_; }
+			virtual bool Valid() const { return !done_ && iter_->Valid(); }
+			virtual void Seek(const Slice& target) {
+				done_ = false;
+				if (lower_bound_ != NULL && comparator_->Compare(target, *lower_bound_) < 0)
+				{
+					iter_->Seek(*lower_bound_);
+				}
+				else
+				{
+					iter_->Seek(target);
+				}
+			}
+			virtual void SeekToFirst() {
+				//Start at the block that may hold the lower bound
+				done_ = false;
+				if (lower_bound_ != NULL)
+				{
+					iter_->Seek(*lower_bound_);
+				}
+				else
+				{
+					iter_->SeekToFirst();
+				}
+			}
+			virtual void SeekToLast() {
+				//End at the block that may hold the upper bound
+				done_ = false;
+				if (upper_bound_ != NULL)
+				{
+					iter_->Seek(*upper_bound_);
+					if (iter_->Valid() || !iter_->status().ok()) return;
+				}
+				iter_->SeekToLast();
+			}
+			virtual void Next() {
+				assert(Valid());
+				done_ = upper_bound_ != NULL &&
+					comparator_->Compare(iter_->key(), *upper_bound_) >= 0;
+				if (!done_) iter_->Next();
+			}
+			virtual void Prev() {
+				assert(Valid());
+				iter_->Prev();
+				done_ = lower_bound_ != NULL && iter_->Valid() &&
+					comparator_->Compare(iter_->key(), *lower_bound_) < 0;
+			}
+			virtual Slice key() const { assert(Valid()); return iter_->key(); }
+			virtual Slice value() const { assert(Valid()); return iter_->value(); }
+			virtual Status status() const { return iter_->status(); }
+		private:
+			Iterator* const iter_;
+			const Comparator* const comparator_;
+			const Slice* const lower_bound_;
+			const Slice* const upper_bound_;
+			bool done_;	//Remaining blocks are out of bounds
+		};
+	}
+
+	Iterator* Table::NewIterator(const ReadOptions& options) const
+	{
+		Iterator* index_iter = NewIndexIterator();
+		if (options.iterate_lower_bound != NULL || options.iterate_upper_bound != NULL)
+		{
+			index_iter = new BoundedIndexIterator(index_iter, rep_->options.comparator,
+				options.iterate_lower_bound, options.iterate_upper_bound);
+		}
+		return NewTwoLevelIterator(index_iter,
+			&Table::BlockReader, const_cast<Table*>(this), options);
+	}
+
+	Iterator* Table::NewRangeTombstoneIterator(const ReadOptions& options) const
+	{
+		if (rep_->range_del_block == NULL)
+		{
+			return NULL;
+		}
+		return rep_->range_del_block->NewIterator(rep_->options.comparator);
+	}
+
+	bool Table::PrefixMayMatch(const Slice& prefix) const
+	{
+		if (rep_->prefix_filter_cached)
+		{
+			return CachedPrefixMayMatch(prefix);
+		}
+		if (rep_->prefix_filter.empty())
+		{
+			return true;
+		}
+		return PrefixFilterMayMatch(prefix, rep_->prefix_filter);
+	}
+
+	bool Table::CachedPrefixMayMatch(const Slice& prefix) const
+	{
+		Cache* block_cache = rep_->options.block_cache;
+		char cache_key_buffer[16];
+		Slice key = BlockCacheKey(rep_->cache_id, rep_->prefix_filter_handle,
+			cache_key_buffer);
+		Cache::Handle* cache_handle = block_cache->Lookup(key);
+		Slice* filter;
+		if (cache_handle != NULL)
+		{
+			filter = reinterpret_cast<Slice*>(block_cache->Value(cache_handle));
+		}
+		else
+		{
+			ReadOptions opt;
+			opt.verify_checksums = rep_->options.paranoid_checks;
+			char* buf;
+			size_t n;
+			if (!ReadBlockContents(rep_->file, opt, rep_->prefix_filter_handle,
+				&buf, &n).ok())
+			{
+				//Without its filter the table may hold anything
+				return true;
+			}
+			filter = new Slice(buf, n);
+			block_cache->Insert(key, filter, n, &DeleteCachedFilter, &cache_handle,
+				Cache::HIGH, rep_->options.block_cache_owner);
+		}
+
+		const bool result = PrefixFilterMayMatch(prefix, *filter);
+		if (cache_handle != NULL)
+		{
+			block_cache->Release(cache_handle);
+		}
+		else
+		{
+			//Refused by a full cache under a strict capacity limit
+			DeleteCachedFilter(key, filter);
+		}
+		return result;
+	}
+
+	uint64_t Table::BytesRead() const
+	{
+		return rep_->bytes_read.Load();
+	}
+
+	uint64_t Table::ApproximateOffsetOf(const Slice& key) const
+	{
+		Iterator* index_iter = NewIndexIterator();
+		index_iter->Seek(key);
+		uint64_t result;
+		if (index_iter->Valid())
+		{
+			BlockHandle handle;
+			Slice input = index_iter->value();
+			Status s = handle.DecodeFrom(&input);
+			if (s.ok())
+			{
+				result = handle.offset();
+			}
+			else
+			{
+				//Strange: we can't decode the block handle in the index block.
+				//We'll just return the offset of the metaindex block, which is
+				//close to the whole file size for this case.
+				result = rep_->metaindex_handle.offset();
+			}
+		}
+		else
+		{
+			//key is past the last key in the file. Approximate the offset
+			//by returning the offset of the metaindex block (which is
+			//right near the end of the file).
+			result = rep_->metaindex_handle.offset();
+		}
+		delete index_iter;
+		return result;
+	}
+
+}
@@ -0,0 +1,544 @@
+#include "leveldb/table_builder.h"
+
+#include <assert.h>
+#include <deque>
+#include "leveldb/comparator.h"
+#include "leveldb/env.h"
+#include "leveldb/slice_transform.h"
+#include "table/block_builder.h"
+#include "table/format.h"
+#include "table/prefix_filter.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+#include "util/mutexlock.h"
+
+namespace leveldb{
+
+	namespace {
+		//A finished data block waiting to be compressed, checksummed and
+		//written in pipelined mode.
+		struct BlockJob{
+			std::string raw;	//Uncompressed block contents
+			std::string compressed;	//Compressed contents, if compression paid off
+			CompressionType type;	//Requested compression, then actual
+			Slice contents;	//Points into raw or compressed once done
+			char trailer[kBlockTrailerSize];
+			std::string index_key;	//Separator key for the index entry
+			bool has_index_key;
+			bool done;	//Set by a worker once contents/trailer are ready
+		};
+	}
+
+	//Compress "raw" as requested by *type (falling back to no compression
+	//if it does not save at least 12.5%), compute the block trailer and
+	//return the contents to write. Runs on the builder thread or, in
+	//pipelined mode, on a worker.
+	static Slice PrepareBlock(const Slice& raw, CompressionType* type,
+		std::string* compressed, char* trailer)
+	{
+		Slice block_contents;
+		switch (*type)
+		{
+		case kNoCompression:
+			block_contents = raw;
+			break;
+
+		case kSnappyCompression:{
+			if (port::Snappy_Compress(raw.data(), raw.size(), compressed) &&
+				compressed->size() < raw.size() - (raw.size() / 8u))
+			{
+				block_contents = *compressed;
+			}
+			else
+			{
+				//Snappy not supported, or compressed less than 12.5%, so just
+				//store uncompressed form
+				block_contents = raw;
+				*type = kNoCompression;
+			}
+			break;
+		}
+		}
+
+		trailer[0] = *type;
+		uint32_t crc = crc32c::Value(block_contents.data(), block_contents.size());
+		crc = crc32c::Extend(crc, trailer, 1);	//Extend crc to cover block type
+		EncodeFixed32(trailer + 1, crc32c::Mask(crc));
+		return block_contents;
+	}
+
+	//Bits per distinct prefix in the prefix bloom filter; about a 1%
+	//false positive rate.
+	static const int kPrefixFilterBitsPerKey = 10;
+
+	struct TableBuilder::Rep
+	{
+		Options options;
+		Options index_block_options;
+		WritableFile* file;
+		uint64_t offset;
+		Status status;
+		BlockBuilder data_block;
+		BlockBuilder index_block;
+		BlockBuilder range_del_block;
+		PrefixFilterBuilder* prefix_filter;	//NULL without a prefix extractor
+		std::string last_key;
+		int64_t num_entries;
+		bool closed;	//Either Finish() or Abandon() has been called.
+
+		//We do not emit the index entry for a block until we have seen the
+		//first key for the next data block. This allows us to use shorter
+		//keys in the index block. For example, consider a block boundary
+		//between the keys "the quick brown fox" and "the who". We can use
+		//"the r" as the key for the index block entry since it is >= all
+		//entries in the first block and < all entries in subsequent
+		//blocks.
+		//
+		//Invariant: r->pending_index_entry is true only if data_block is empty.
+		bool pending_index_entry;
+		BlockHandle pending_handle;	//Handle to add to index block
+
+		std::string compressed_output;
+
+		//Pipelined mode. Flushed blocks enter both queues; workers claim
+		//jobs from work_queue, while the builder thread writes jobs from the
+		//front of in_flight once they are done and their index key is known,
+		//so blocks reach the file in the order they were flushed.
+		const int num_workers;
+		const size_t max_in_flight;	//Bounds memory held by queued blocks
+		port::Mutex mu;
+		port::CondVar cv;	//Signalled on new work, finished jobs and worker exit
+		std::deque<BlockJob*> in_flight;
+		std::deque<BlockJob*> work_queue;
+		uint64_t queued_bytes;	//Raw size of the blocks in in_flight, with trailers; builder thread only
+		int live_workers;
+		bool shutting_down;
+
+		Rep(const Options& opt, WritableFile* f)
+			:options(opt),
+			index_block_options(opt),
+			file(f),
+			offset(0),
+			data_block(&options),
+			index_block(&index_block_options),
+			range_del_block(&index_block_options),
+			prefix_filter(opt.prefix_extractor == NULL ? NULL :
+				new PrefixFilterBuilder(kPrefixFilterBitsPerKey)),
+			num_entries(0),
+			closed(false),
+			pending_index_entry(false),
+			num_workers(opt.table_build_threads > 0 ? opt.table_build_threads : 0),
+			max_in_flight(2 * num_workers),
+			cv(&mu),
+			queued_bytes(0),
+			live_workers(0),
+			shutting_down(false)
+		{
+			index_block_options.block_restart_interval = 1;
+		}
+
+		~Rep()
+		{
+			delete prefix_filter;
+		}
+	};
+
+	TableBuilder::TableBuilder(const Options& options, WritableFile* file)
+		:rep_(new Rep(options, file))
+	{
+		Rep* r = rep_;
+		r->live_workers = r->num_workers;
+		for (int i = 0; i < r->num_workers; i++)
+		{
+			r->options.env->StartThread(&TableBuilder::BGWork, r);
+		}
+	}
+
+	TableBuilder::~TableBuilder()
+	{
+		assert(rep_->closed);	//Catch errors where caller forgot to call Finish()
+		assert(rep_->live_workers == 0);
+		delete rep_;
+	}
+
+	Status TableBuilder::ChangeOptions(const Options options)
+	{
+		//Note: if more fields are added to Options, update
+		//this function to catch changes that should not be allowed to
+		//change in the middle of building a Table.
+		if (options.comparator != rep_->options.comparator)
+		{
+			return Status::InvalidArgument("changing comparator while building table");
+		}
+		if (options.prefix_extractor != rep_->options.prefix_extractor)
+		{
+			return Status::InvalidArgument("changing prefix extractor while building table");
+		}
+
+		//Note that any live BlockBuilders point to rep_->options and therefore
+		//will automatically pick up the updated options.
+		rep_->options = options;
+		rep_->index_block_options = options;
+		rep_->index_block_options.block_restart_interval = 1;
+		return Status::OK();
+	}
+
+	void TableBuilder::Add(const Slice& key, const Slice& value)
+	{
+		Rep* r = rep_;
+		assert(!r->closed);
+		if (!ok()) return;
+		if (r->num_entries > 0)
+		{
+			assert(r->options.comparator->Compare(key, Slice(r->last_key)) > 0);
+		}
+
+		if (r->pending_index_entry)
+		{
+			assert(r->data_block.empty());
+			r->options.comparator->FindShortestSeparator(&r->last_key, key);
+			if (r->num_workers > 0)
+			{
+				{
+					MutexLock l(&r->mu);
+					BlockJob* job = r->in_flight.back();
+					job->index_key = r->last_key;
+					job->has_index_key = true;
+				}
+				WriteQueuedBlocks(r->max_in_flight);
+			}
+			else
+			{
+				AddIndexEntry(r->last_key, r->pending_handle);
+			}
+			r->pending_index_entry = false;
+		}
+
+		if (r->prefix_filter != NULL && r->options.prefix_extractor->InDomain(key))
+		{
+			r->prefix_filter->AddPrefix(r->options.prefix_extractor->Transform(key));
+		}
+
+		r->last_key.assign(key.data(), key.size());
+		r->num_entries++;
+		r->data_block.Add(key, value);
+
+		const size_t estimated_block_size = r->data_block.CurrentSizeEstimate();
+		if (estimated_block_size >= r->options.block_size)
+		{
+			Flush();
+		}
+	}
+
+	void TableBuilder::AddRangeTombstone(const Slice& key, const Slice& value)
+	{
+		Rep* r = rep_;
+		assert(!r->closed);
+		if (!ok()) return;
+		r->range_del_block.Add(key, value);
+	}
+
+	void TableBuilder::Flush()
+	{
+		Rep* r = rep_;
+		assert(!r->closed);
+		if (!ok()) return;
+		if (r->data_block.empty()) return;
+		assert(!r->pending_index_entry);
+		if (r->num_workers > 0)
+		{
+			QueueBlock(&r->data_block);
+			r->pending_index_entry = true;
+			return;
+		}
+		WriteBlock(&r->data_block, &r->pending_handle);
+		if (ok())
+		{
+			r->pending_index_entry = true;
+			r->status = r->file->Flush();
+		}
+	}
+
+	void TableBuilder::WriteBlock(BlockBuilder* block, BlockHandle* handle)
+	{
+		//File format contains a sequence of blocks where each block has:
+		//	block_data: uint8[n]
+		//	type: uint8
+		//	crc: uint32
+		assert(ok());
+		Rep* r = rep_;
+		Slice raw = block->Finish();
+		CompressionType type = r->options.compression;
+		char trailer[kBlockTrailerSize];
+		Slice block_contents = PrepareBlock(raw, &type, &r->compressed_output, trailer);
+		WriteRawBlock(block_contents, trailer, handle);
+		r->compressed_output.clear();
+		block->Reset();
+	}
+
+	void TableBuilder::WriteRawBlock(const Slice& block_contents, const char* trailer,
+		BlockHandle* handle)
+	{
+		Rep* r = rep_;
+		handle->set_offset(r->offset);
+		handle->set_size(block_contents.size());
+		r->status = r->file->Append(block_contents);
+		if (r->status.ok())
+		{
+			r->status = r->file->Append(Slice(trailer, kBlockTrailerSize));
+			if (r->status.ok())
+			{
+				r->offset += block_contents.size() + kBlockTrailerSize;
+			}
+		}
+	}
+
+	void TableBuilder::AddIndexEntry(const Slice& key, const BlockHandle& handle)
+	{
+		std::string handle_encoding;
+		handle.EncodeTo(&handle_encoding);
+		rep_->index_block.Add(key, Slice(handle_encoding));
+	}
+
+	void TableBuilder::QueueBlock(BlockBuilder* block)
+	{
+		Rep* r = rep_;
+		BlockJob* job = new BlockJob;
+		Slice raw = block->Finish();
+		job->raw.assign(raw.data(), raw.size());
+		job->type = r->options.compression;
+		job->has_index_key = false;
+		job->done = false;
+		block->Reset();
+		r->queued_bytes += job->raw.size() + kBlockTrailerSize;
+
+		MutexLock l(&r->mu);
+		r->in_flight.push_back(job);
+		r->work_queue.push_back(job);
+		r->cv.SignalAll();
+	}
+
+	void TableBuilder::WriteQueuedBlocks(size_t max_in_flight)
+	{
+		Rep* r = rep_;
+		bool wrote = false;
+		MutexLock l(&r->mu);
+		while (!r->in_flight.empty())
+		{
+			BlockJob* job = r->in_flight.front();
+			if (!job->done || !job->has_index_key)
+			{
+				if (r->in_flight.size() <= max_in_flight)
+				{
+					break;
+				}
+				//Only the newest block can lack its index key, and it is
+				//never at the front while more than max_in_flight are queued.
+				assert(job->has_index_key);
+				r->cv.Wait();
+				continue;
+			}
+
+			//Blocks are popped in flush order; the file is only touched by
+			//this thread, so the lock is not needed while writing.
+			r->in_flight.pop_front();
+			r->mu.Unlock();
+			r->queued_bytes -= job->raw.size() + kBlockTrailerSize;
+			if (ok())
+			{
+				BlockHandle handle;
+				WriteRawBlock(job->contents, job->trailer, &handle);
+				if (ok())
+				{
+					AddIndexEntry(job->index_key, handle);
+					wrote = true;
+				}
+			}
+			delete job;
+			r->mu.Lock();
+		}
+
+		//As the synchronous path does after each block
+		if (wrote && ok())
+		{
+			r->mu.Unlock();
+			r->status = r->file->Flush();
+			r->mu.Lock();
+		}
+	}
+
+	void TableBuilder::BGWork(void* arg)
+	{
+		Rep* r = reinterpret_cast<Rep*>(arg);
+		r->mu.Lock();
+		while (true)
+		{
+			while (r->work_queue.empty() && !r->shutting_down)
+			{
+				r->cv.Wait();
+			}
+			if (r->work_queue.empty())
+			{
+				break;
+			}
+			BlockJob* job = r->work_queue.front();
+			r->work_queue.pop_front();
+			r->mu.Unlock();
+
+			job->contents = PrepareBlock(job->raw, &job->type, &job->compressed, job->trailer);
+
+			r->mu.Lock();
+			job->done = true;
+			r->cv.SignalAll();
+		}
+		r->live_workers--;
+		r->cv.SignalAll();
+		r->mu.Unlock();
+	}
+
+	void TableBuilder::StopWorkers()
+	{
+		Rep* r = rep_;
+		MutexLock l(&r->mu);
+		//Blocks not yet claimed are dropped; a worker busy with a block
+		//finishes it before noticing the shutdown.
+		r->work_queue.clear();
+		r->shutting_down = true;
+		r->cv.SignalAll();
+		while (r->live_workers > 0)
+		{
+			r->cv.Wait();
+		}
+		for (size_t i = 0; i < r->in_flight.size(); i++)
+		{
+			delete r->in_flight[i];
+		}
+		r->in_flight.clear();
+		r->queued_bytes = 0;
+	}
+
+	Status TableBuilder::status() const
+	{
+		return rep_->status;
+	}
+
+	Status TableBuilder::Finish()
+	{
+		Rep* r = rep_;
+		Flush();
+		assert(!r->closed);
+		r->closed = true;
+
+		if (r->num_workers > 0)
+		{
+			if (r->pending_index_entry)
+			{
+				r->options.comparator->FindShortSuccessor(&r->last_key);
+				{
+					MutexLock l(&r->mu);
+					BlockJob* job = r->in_flight.back();
+					job->index_key = r->last_key;
+					job->has_index_key = true;
+				}
+				r->pending_index_entry = false;
+			}
+			WriteQueuedBlocks(0);
+			StopWorkers();
+		}
+
+		BlockHandle range_del_block_handle;
+		const bool has_range_del_block = !r->range_del_block.empty();
+		if (ok() && has_range_del_block)
+		{
+			WriteBlock(&r->range_del_block, &range_del_block_handle);
+		}
+
+		//Write the prefix filter uncompressed, so that it can be probed
+		//straight from the bytes read.
+		BlockHandle prefix_filter_block_handle;
+		const bool has_prefix_filter = r->prefix_filter != NULL && !r->prefix_filter->empty();
+		if (ok() && has_prefix_filter)
+		{
+			char trailer[kBlockTrailerSize];
+			CompressionType type = kNoCompression;
+			Slice contents = PrepareBlock(r->prefix_filter->Finish(), &type, NULL, trailer);
+			WriteRawBlock(contents, trailer, &prefix_filter_block_handle);
+		}
+
+		BlockHandle metaindex_block_handle, index_block_handle;
+
+		//Write metaindex block
+		if (ok())
+		{
+			BlockBuilder meta_index_block(&r->options);
+			if (has_prefix_filter)
+			{
+				//Metaindex keys must be added in sorted order, and
+				//"leveldb.prefix_bloom." sorts before "leveldb.range_del".
+				std::string key = kPrefixFilterBlockPrefix;
+				key.append(r->options.prefix_extractor->Name());
+				std::string handle_encoding;
+				prefix_filter_block_handle.EncodeTo(&handle_encoding);
+				meta_index_block.Add(key, handle_encoding);
+			}
+			if (has_range_del_block)
+			{
+				std::string handle_encoding;
+				range_del_block_handle.EncodeTo(&handle_encoding);
+				meta_index_block.Add(kRangeDelBlockName, handle_encoding);
+			}
+			WriteBlock(&meta_index_block, &metaindex_block_handle);
+		}
+
+		//Write index block
+		if (ok())
+		{
+			if (r->pending_index_entry)
+			{
+				r->options.comparator->FindShortSuccessor(&r->last_key);
+				AddIndexEntry(r->last_key, r->pending_handle);
+				r->pending_index_entry = false;
+			}
+			WriteBlock(&r->index_block, &index_block_handle);
+		}
+
+		//Write footer
+		if (ok())
+		{
+			Footer footer;
+			footer.set_metaindex_handle(metaindex_block_handle);
+			footer.set_index_handle(index_block_handle);
+			std::string footer_encoding;
+			footer.EncodeTo(&footer_encoding);
+			r->status = r->file->Append(footer_encoding);
+			if (r->status.ok())
+			{
+				r->offset += footer_encoding.size();
+			}
+		}
+		return r->status;
+	}
+
+	void TableBuilder::Abandon()
+	{
+		Rep* r = rep_;
+		assert(!r->closed);
+		r->closed = true;
+		if (r->num_workers > 0)
+		{
+			StopWorkers();
+		}
+	}
+
+	uint64_t TableBuilder::NumEntries() const
+	{
+		return rep_->num_entries;
+	}
+
+	uint64_t TableBuilder::FileSize() const
+	{
+		//Queued blocks count at their uncompressed size until written
+		return rep_->offset + rep_->queued_bytes;
+	}
+
+}
@@ -1,6 +1,8 @@
 #include <assert.h>
+#include <map>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "leveldb/cache.h"
 #include "port/port.h"
 #include "util/hash.h"
@@ -26,8 +28,12 @@ namespace leveldb{
 			LRUHandle* prev;
 			size_t charge;
 			size_t key_length;
+			uint64_t owner;	//Usage is accounted to this owner
 			uint32_t refs;
 			uint32_t hash;//Hash of key(); used for fast sharding and comparisons
+			bool in_cache;	//Whether the cache still refers to the entry
+			bool high_pri;	//Inserted with Cache::HIGH priority
+			bool in_high_pri_pool;	//Currently on the high-priority list
 			char key_data[1];//Beginning of key
 
 			Slice key() const{
@@ -125,10 +131,10 @@ namespace leveldb{
 				for (uint32_t i = 0; i < length_; i++)
 				{
 					LRUHandle* h = list_[i];
-					while (h!- NULL)
+					while (h != NULL)
 					{
-						LRUHandle* next = h->hash;
-						LRUHandle** ptr = &new_list[hash&(new_length - 1)];
+						LRUHandle* next = h->next_hash;
+						LRUHandle** ptr = &new_list[h->hash & (new_length - 1)];
 						h->next_hash = *ptr;
 						*ptr = h;
 						h = next;
@@ -140,186 +146,343 @@ namespace leveldb{
 				list_ = new_list;
 				length_ = new_length;
 			}
+		};
 
-			//A single shard of sharded cache.
-			class LRUCache
-			{
-			public:
-				LRUCache();
-				~LRUCache();
+		//A single shard of sharded cache.
+		//Entries that no client holds a handle to live on one of two LRU
+		//lists; entries in use are on neither, since evicting them would
+		//free nothing. Only listed entries are evicted. High-priority entries go on
+		//their own list while its charge stays within high_pri_capacity_;
+		//past that the oldest of them move to the newest end of the
+		//low-priority list. Eviction takes the oldest low-priority entry
+		//first, so a burst of low-priority inserts cannot evict the
+		//high-priority pool.
+		class LRUCache
+		{
+		public:
+			LRUCache();
+			~LRUCache();
 
-				//Separate from constructor so caller can easily make an array of LRUCache
-				void SetCapacity(size_t capacity){
-					capacity_ = capacity;
-				}
+			//Separate from constructor so caller can easily make an array of LRUCache
+			void SetCapacity(size_t capacity, double high_pri_pool_ratio){
+				capacity_ = capacity;
+				high_pri_capacity_ = static_cast<size_t>(capacity * high_pri_pool_ratio);
+			}
 
-				//Like Cache methods but with an extra "hash" parameter.
-				Cache::Handle* Insert(const Slice& key, uint32_t hash,
-					void* value, size_t charge,
-					void(*deleter)(const Slice& key, void* value));
-
-				Cache::Handle* Lookup(const Slice& key, uint32_t hash);
-				void Release(Cache::Handle* handle);
-				void Erase(const Slice& key, uint32_t hash);
-
-			protected:
-			private:
-				void LRU_Remove(LRUHandle* e);
-				void LRU_Append(LRUHandle* e);
-				void Unref(LRUHandle* e);
-
-				//Initialized before use.
-				size_t capacity_;
-
-				//mutex_ protects the following state.
-				port::Mutex mutex_;
-				size_t usage_;
-				uint64_t last_id_;
-
-				//Dummy head of LRU list.
-				//lru.prev is newest entry, lru.next is oldest entry.
-				LRUHandle lru_;
-				HandleTable table_;
-			};
+			void SetStrictCapacityLimit(bool strict_capacity_limit){
+				MutexLock l(&mutex_);
+				strict_capacity_limit_ = strict_capacity_limit;
+			}
+
+			//Like Cache methods but with an extra "hash" parameter. If "force"
+			//is set the insert ignores a strict capacity limit.
+			Status Insert(const Slice& key, uint32_t hash,
+				void* value, size_t charge,
+				void(*deleter)(const Slice& key, void* value),
+				Cache::Handle** handle, Cache::Priority priority, uint64_t owner,
+				bool force);
+
+			Cache::Handle* Lookup(const Slice& key, uint32_t hash);
+			void Release(Cache::Handle* handle);
+			void Erase(const Slice& key, uint32_t hash);
+			size_t GetUsage();
+			size_t GetOwnerUsage(uint64_t owner);
+
+		protected:
+		private:
+			void LRU_Remove(LRUHandle* e);
+			void LRU_Append(LRUHandle* e);
+			void Unref(LRUHandle* e);
+
+			//Drop the cache's reference to "e", which was just removed from
+			//table_. It is freed once its last handle is released.
+			void Detach(LRUHandle* e);
+
+			//Evict least recently used entries until "charge" more bytes
+			//fit, or no entry is left to evict.
+			void EvictFor(size_t charge);
+
+			//Initialized before use.
+			size_t capacity_;
+			size_t high_pri_capacity_;
+
+			//mutex_ protects the following state.
+			port::Mutex mutex_;
+			bool strict_capacity_limit_;
+			size_t usage_;
+			size_t high_pri_usage_;	//Charge of the entries on high_pri_lru_
+			std::map<uint64_t, size_t> owner_usage_;	//Owners with non-zero usage
+
+			//Dummy heads of the LRU lists.
+			//lru.prev is newest entry, lru.next is oldest entry.
+			LRUHandle lru_;
+			LRUHandle high_pri_lru_;
+			HandleTable table_;
 		};
 
-		HandleTable::LRUCache::LRUCache()
-			:usage_(0),
-			last_id_(0)
+		LRUCache::LRUCache()
+			:capacity_(0),
+			high_pri_capacity_(0),
+			strict_capacity_limit_(false),
+			usage_(0),
+			high_pri_usage_(0)
 		{
 			lru_.next = &lru_;
 			lru_.prev = &lru_;
+			high_pri_lru_.next = &high_pri_lru_;
+			high_pri_lru_.prev = &high_pri_lru_;
 		}
 
-		HandleTable::LRUCache::~LRUCache()
+		LRUCache::~LRUCache()
 		{
-			for (LRUHandle* e = lru_.next; e != &lru_;)
+			LRUHandle* lists[2] = { &lru_, &high_pri_lru_ };
+			for (int i = 0; i < 2; i++)
 			{
-				LRUHandle* next = e->next;
-				assert(e->refs == 1);//Error if caller has an unreleased handle
-				Unref(e);
-				e = next;
+				for (LRUHandle* e = lists[i]->next; e != lists[i];)
+				{
+					LRUHandle* next = e->next;
+					assert(e->refs == 1);//Error if caller has an unreleased handle
+					Unref(e);
+					e = next;
+				}
 			}
 		}
 
-		void HandleTable::LRUCache::Unref(LRUHandle* e)
+		void LRUCache::Unref(LRUHandle* e)
 		{
 			assert(e->refs > 0);
 			e->refs--;
-			if (e->refs <= 0)
+			if (e->refs == 1 && e->in_cache)
+			{
+				//No longer in use: make it evictable again.
+				LRU_Append(e);
+			}
+			else if (e->refs <= 0)
 			{
 				usage_ -= e->charge;
+				std::map<uint64_t, size_t>::iterator it = owner_usage_.find(e->owner);
+				assert(it != owner_usage_.end() && it->second >= e->charge);
+				it->second -= e->charge;
+				if (it->second == 0)
+				{
+					owner_usage_.erase(it);
+				}
 				(*e->deleter)(e->key(), e->value);
 				free(e);
 			}
 		}
 
-		void HandleTable::LRUCache::LRU_Remove(LRUHandle* e)
+		void LRUCache::Detach(LRUHandle* e)
+		{
+			if (e->refs == 1)
+			{
+				LRU_Remove(e);
+			}
+			e->in_cache = false;
+			Unref(e);
+		}
+
+		void LRUCache::LRU_Remove(LRUHandle* e)
 		{
 			e->next->prev = e->prev;
 			e->prev->next = e->next;
+			if (e->in_high_pri_pool)
+			{
+				high_pri_usage_ -= e->charge;
+				e->in_high_pri_pool = false;
+			}
 		}
 
-		void HandleTable::LRUCache::LRU_Append(LRUHandle* e)
+		static void ListAppend(LRUHandle* list, LRUHandle* e)
 		{
-			//Make "e" newest entry by inserting just before lru_
-			e->next = &lru_;
-			e->prev = lru_.prev;
+			//Make "e" newest entry by inserting just before list
+			e->next = list;
+			e->prev = list->prev;
 			e->prev->next = e;
 			e->next->prev = e;
 		}
 
-		Cache::Handle* HandleTable::LRUCache::Lookup(const Slice& key, uint32_t hash)
+		void LRUCache::LRU_Append(LRUHandle* e)
+		{
+			if (!e->high_pri || high_pri_capacity_ == 0)
+			{
+				ListAppend(&lru_, e);
+				return;
+			}
+			ListAppend(&high_pri_lru_, e);
+			e->in_high_pri_pool = true;
+			high_pri_usage_ += e->charge;
+
+			//Demote the oldest high-priority entries beyond the pool.
+			while (high_pri_usage_ > high_pri_capacity_)
+			{
+				LRUHandle* old = high_pri_lru_.next;
+				LRU_Remove(old);
+				ListAppend(&lru_, old);
+			}
+		}
+
+		void LRUCache::EvictFor(size_t charge)
+		{
+			while (usage_ + charge > capacity_)
+			{
+				LRUHandle* old = lru_.next;
+				if (old == &lru_)
+				{
+					old = high_pri_lru_.next;
+					if (old == &high_pri_lru_)
+					{
+						break;
+					}
+				}
+				assert(old->refs == 1);
+				LRU_Remove(old);
+				table_.Remove(old->key(), old->hash);
+				old->in_cache = false;
+				Unref(old);
+			}
+		}
+
+		Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash)
 		{
 			MutexLock l(&mutex_);
 			LRUHandle* e = table_.Lookup(key, hash);
 			if (e != NULL)
 			{
+				if (e->refs == 1)
+				{
+					LRU_Remove(e);
+				}
 				e->refs++;
-				LRU_Remove(e);
-				LRU_Append(e);
 			}
 			return reinterpret_cast<Cache::Handle*>(e);
 		}
 
-		void HandleTable::LRUCache::Release(Cache::Handle* handle)
+		void LRUCache::Release(Cache::Handle* handle)
 		{
 			MutexLock l(&mutex_);
 			Unref(reinterpret_cast<LRUHandle*>(handle));
 		}
 
-		Cache::Handle* HandleTable::LRUCache::Insert(const Slice& key, uint32_t hash, void* value, size_t charge, void(*deleter)(const Slice& key, void* value))
+		Status LRUCache::Insert(const Slice& key, uint32_t hash, void* value, size_t charge,
+			void(*deleter)(const Slice& key, void* value),
+			Cache::Handle** handle, Cache::Priority priority, uint64_t owner,
+			bool force)
 		{
 			MutexLock l(&mutex_);
+			//Entries in use are counted in usage_ but cannot be evicted, so
+			//room may run out even with every list empty.
+			EvictFor(charge);
+			if (usage_ + charge > capacity_ && strict_capacity_limit_ && !force)
+			{
+				if (handle == NULL)
+				{
+					(*deleter)(key, value);
+					return Status::OK();
+				}
+				*handle = NULL;
+				return Status::Incomplete("cache is full");
+			}
+
 			LRUHandle* e = reinterpret_cast<LRUHandle*>(
 				malloc(sizeof(LRUHandle)-1 + key.size()));
 			e->value = value;
 			e->deleter = deleter;
 			e->charge = charge;
 			e->key_length = key.size();
+			e->owner = owner;
 			e->hash = hash;
-			e->refs = 2;//One from LRUCache, one for the returned handle
+			e->in_cache = true;
+			e->high_pri = (priority == Cache::HIGH);
+			e->in_high_pri_pool = false;
+			//One from LRUCache, one for the returned handle
+			e->refs = (handle == NULL) ? 1 : 2;
 			memcpy(e->key_data, key.data(), key.size());
-			LRU_Append(e);
+			if (handle == NULL)
+			{
+				LRU_Append(e);
+			}
 			usage_ += charge;
+			owner_usage_[owner] += charge;
 
 			LRUHandle* old = table_.Insert(e);
 			if (old != NULL)
 			{
-				LRU_Remove(old);
-				Unref(old);
+				Detach(old);
 			}
-
-			while (usage_ > capacity_ && lru_.next != &lru_)
+			if (handle != NULL)
 			{
-				LRUHandle* old = lru_.next;
-				LRU_Remove(old);
-				table_.Remove(old->key(), old->hash);
-				Unref(old);
+				*handle = reinterpret_cast<Cache::Handle*>(e);
 			}
-			return reinterpret_cast<Cache::Handle*>(e);
+			return Status::OK();
 		}
 
-		void HandleTable::LRUCache::Erase(const Slice& key, uint32_t hash)
+		void LRUCache::Erase(const Slice& key, uint32_t hash)
 		{
 			MutexLock l(&mutex_);
 			LRUHandle* e = table_.Remove(key, hash);
 			if (e != NULL)
 			{
-				LRU_Remove(e);
-				Unref(e);
+				Detach(e);
 			}
 		}
 
+		size_t LRUCache::GetUsage()
+		{
+			MutexLock l(&mutex_);
+			return usage_;
+		}
+
+		size_t LRUCache::GetOwnerUsage(uint64_t owner)
+		{
+			MutexLock l(&mutex_);
+			std::map<uint64_t, size_t>::const_iterator it = owner_usage_.find(owner);
+			return (it == owner_usage_.end()) ? 0 : it->second;
+		}
+
 		static const int kNumShardBits = 4;
 		static const int kNumShards = 1 << kNumShardBits;
 
 		class ShardedLRUCache :public Cache
 		{
 		public:
-			explicit ShardLRUCache(size_t capacity)
+			ShardedLRUCache(size_t capacity, double high_pri_pool_ratio,
+				bool strict_capacity_limit)
 				:last_id_(0){
 				const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
 				for (int s = 0; s < kNumShards; s++)
 				{
-					shard_[s].SetCapacity(per_shard);
+					shard_[s].SetCapacity(per_shard, high_pri_pool_ratio);
+					shard_[s].SetStrictCapacityLimit(strict_capacity_limit);
 				}
 			}
 
 			virtual ~ShardedLRUCache() { }
 			virtual Handle* Insert(const Slice& key, void* value, size_t charge,
 				void(*deleter)(const Slice& key, void* value)){
-				const shard_[Shard(hash)]->Insert(key, hash, value, charge, deleter);
+				const uint32_t hash = HashSlice(key);
+				Handle* handle;
+				shard_[Shard(hash)].Insert(key, hash, value, charge, deleter,
+					&handle, LOW, 0, true);
+				return handle;
+			}
+
+			virtual Status Insert(const Slice& key, void* value, size_t charge,
+				void(*deleter)(const Slice& key, void* value),
+				Handle** handle, Priority priority, uint64_t owner){
+				const uint32_t hash = HashSlice(key);
+				return shard_[Shard(hash)].Insert(key, hash, value, charge, deleter,
+					handle, priority, owner, false);
 			}
 
 			virtual Handle* Lookup(const Slice& key){
 				const uint32_t hash = HashSlice(key);
-				return shard_[Shard(hash)]->Lookup(key, hash);
+				return shard_[Shard(hash)].Lookup(key, hash);
 			}
 
 			virtual void Release(Handle* handle){
 				LRUHandle* h = reinterpret_cast<LRUHandle*>(handle);
-				shard_[Shard(h->hash)]->Release(handle);
+				shard_[Shard(h->hash)].Release(handle);
 			}
 
 			virtual void Erase(const Slice& key) {
@@ -334,6 +497,31 @@ namespace leveldb{
 				return ++(last_id_);
 			}
 
+			virtual void SetStrictCapacityLimit(bool strict_capacity_limit) {
+				for (int s = 0; s < kNumShards; s++)
+				{
+					shard_[s].SetStrictCapacityLimit(strict_capacity_limit);
+				}
+			}
+
+			virtual size_t GetUsage() {
+				size_t total = 0;
+				for (int s = 0; s < kNumShards; s++)
+				{
+					total += shard_[s].GetUsage();
+				}
+				return total;
+			}
+
+			virtual size_t GetOwnerUsage(uint64_t owner) {
+				size_t total = 0;
+				for (int s = 0; s < kNumShards; s++)
+				{
+					total += shard_[s].GetOwnerUsage(owner);
+				}
+				return total;
+			}
+
 		protected:
 		private:
 			LRUCache shard_[kNumShards];
@@ -353,7 +541,13 @@ namespace leveldb{
 
 	extern Cache* NewLRUCache(size_t capacity)
 	{
-		return new ShardedLRUCache(capacity);
+		return new ShardedLRUCache(capacity, 0.0, false);
+	}
+
+	extern Cache* NewLRUCache(size_t capacity, double high_pri_pool_ratio,
+		bool strict_capacity_limit)
+	{
+		return new ShardedLRUCache(capacity, high_pri_pool_ratio, strict_capacity_limit);
 	}
 
-}
\ No newline at end of file
+}
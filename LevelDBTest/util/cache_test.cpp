@@ -0,0 +1,206 @@
+//Checks the LRU cache: the high-priority pool, strict capacity limits,
+//usage accounting per owner, and growth of the hash table. Built as its
+//own console program.
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "db/testutil.h"
+#include "leveldb/cache.h"
+#include "util/coding.h"
+
+using namespace leveldb;
+using leveldb::test::CheckOk;
+
+//Entries are spread over 16 shards, each with 1/16 of the capacity.
+static const int kNumShards = 16;
+
+static std::string EncodeKey(int k)
+{
+	std::string result;
+	PutFixed32(&result, k);
+	return result;
+}
+
+static void* EncodeValue(uintptr_t v) { return reinterpret_cast<void*>(v); }
+static int DecodeValue(void* v) { return static_cast<int>(reinterpret_cast<uintptr_t>(v)); }
+
+static int deleted = 0;
+
+static void Deleter(const Slice& key, void* value)
+{
+	deleted++;
+}
+
+static void InsertReleased(Cache* cache, int key, Cache::Priority priority)
+{
+	CheckOk(cache->Insert(EncodeKey(key), EncodeValue(key), 1, &Deleter,
+		NULL, priority, 0));
+}
+
+static bool Contains(Cache* cache, int key)
+{
+	Cache::Handle* h = cache->Lookup(EncodeKey(key));
+	if (h == NULL)
+	{
+		return false;
+	}
+	LEVELDB_CHECK(DecodeValue(cache->Value(h)) == key);
+	cache->Release(h);
+	return true;
+}
+
+//High-priority entries outlast any number of low-priority inserts as long
+//as they fit the pool; once it overflows the oldest are evicted like
+//low-priority ones.
+static void TestHighPriorityPool()
+{
+	//100 entries per shard, half of them reserved for high priority.
+	Cache* cache = NewLRUCache(kNumShards * 100, 0.5, false);
+	const int kHigh = kNumShards * 10;
+	for (int i = 0; i < kHigh; i++)
+	{
+		InsertReleased(cache, i, Cache::HIGH);
+	}
+	for (int i = 0; i < 20000; i++)
+	{
+		InsertReleased(cache, 100000 + i, Cache::LOW);
+	}
+	for (int i = 0; i < kHigh; i++)
+	{
+		LEVELDB_CHECK(Contains(cache, i));
+	}
+
+	//Overflow the pool many times over, then flood it again.
+	for (int i = 0; i < kNumShards * 200; i++)
+	{
+		InsertReleased(cache, 200000 + i, Cache::HIGH);
+	}
+	for (int i = 0; i < 20000; i++)
+	{
+		InsertReleased(cache, 300000 + i, Cache::LOW);
+	}
+	for (int i = 0; i < kHigh; i++)
+	{
+		LEVELDB_CHECK(!Contains(cache, i));
+	}
+	delete cache;
+}
+
+//An entry larger than its shard fails a strict insert and is left to the
+//caller.
+static void TestStrictCapacityLimit()
+{
+	Cache* cache = NewLRUCache(kNumShards * 10, 0.0, true);
+	const int deleted_before = deleted;
+	Cache::Handle* h = reinterpret_cast<Cache::Handle*>(1);
+	Status s = cache->Insert(EncodeKey(1), EncodeValue(1), 11, &Deleter,
+		&h, Cache::LOW, 0);
+	LEVELDB_CHECK(s.IsIncomplete());
+	LEVELDB_CHECK(h == NULL);
+	LEVELDB_CHECK(deleted == deleted_before);
+	LEVELDB_CHECK(cache->Lookup(EncodeKey(1)) == NULL);
+	LEVELDB_CHECK(cache->GetUsage() == 0);
+
+	//Without a handle the entry is deleted at once, as if evicted.
+	CheckOk(cache->Insert(EncodeKey(2), EncodeValue(2), 11, &Deleter,
+		NULL, Cache::LOW, 0));
+	LEVELDB_CHECK(deleted == deleted_before + 1);
+	LEVELDB_CHECK(cache->Lookup(EncodeKey(2)) == NULL);
+
+	//The plain form never fails.
+	h = cache->Insert(EncodeKey(3), EncodeValue(3), 11, &Deleter);
+	LEVELDB_CHECK(h != NULL);
+	LEVELDB_CHECK(cache->GetUsage() == 11);
+	cache->Release(h);
+
+	//Lifting the limit admits the entry.
+	cache->SetStrictCapacityLimit(false);
+	CheckOk(cache->Insert(EncodeKey(1), EncodeValue(1), 11, &Deleter,
+		&h, Cache::LOW, 0));
+	LEVELDB_CHECK(h != NULL);
+	cache->Release(h);
+	delete cache;
+}
+
+//Usage is charged to the owner of each entry until the entry is freed,
+//which for an erased entry still in use is its last Release().
+static void TestOwnerUsage()
+{
+	Cache* cache = NewLRUCache(1 << 20);
+	const uint64_t a = cache->NewId();
+	const uint64_t b = cache->NewId();
+	std::vector<Cache::Handle*> handles;
+	for (int i = 0; i < 10; i++)
+	{
+		Cache::Handle* h;
+		CheckOk(cache->Insert(EncodeKey(i), EncodeValue(i), 100 + i, &Deleter,
+			&h, Cache::LOW, (i % 2 == 0) ? a : b));
+		handles.push_back(h);
+	}
+	LEVELDB_CHECK(cache->GetOwnerUsage(a) == 100 + 102 + 104 + 106 + 108);
+	LEVELDB_CHECK(cache->GetOwnerUsage(b) == 101 + 103 + 105 + 107 + 109);
+	LEVELDB_CHECK(cache->GetUsage() == cache->GetOwnerUsage(a) + cache->GetOwnerUsage(b));
+
+	//Erased but still held: still charged.
+	for (int i = 0; i < 10; i++)
+	{
+		cache->Erase(EncodeKey(i));
+	}
+	LEVELDB_CHECK(cache->GetOwnerUsage(a) == 100 + 102 + 104 + 106 + 108);
+	for (int i = 0; i < 10; i += 2)
+	{
+		cache->Release(handles[i]);
+	}
+	LEVELDB_CHECK(cache->GetOwnerUsage(a) == 0);
+	LEVELDB_CHECK(cache->GetOwnerUsage(b) == 101 + 103 + 105 + 107 + 109);
+
+	//Released first, then erased.
+	for (int i = 1; i < 10; i += 2)
+	{
+		cache->Release(handles[i]);
+	}
+	LEVELDB_CHECK(cache->GetOwnerUsage(b) == 0);
+	CheckOk(cache->Insert(EncodeKey(1), EncodeValue(1), 7, &Deleter,
+		NULL, Cache::HIGH, b));
+	LEVELDB_CHECK(cache->GetOwnerUsage(b) == 7);
+	cache->Erase(EncodeKey(1));
+	LEVELDB_CHECK(cache->GetOwnerUsage(b) == 0);
+	LEVELDB_CHECK(cache->GetUsage() == 0);
+	delete cache;
+}
+
+//Every entry stays reachable while the hash table of each shard grows.
+static void TestResize()
+{
+	Cache* cache = NewLRUCache(1 << 20);
+	const int kNum = 5000;
+	for (int i = 0; i < kNum; i++)
+	{
+		InsertReleased(cache, i, (i % 3 == 0) ? Cache::HIGH : Cache::LOW);
+	}
+	for (int i = 0; i < kNum; i++)
+	{
+		LEVELDB_CHECK(Contains(cache, i));
+	}
+	for (int i = 0; i < kNum; i += 2)
+	{
+		cache->Erase(EncodeKey(i));
+	}
+	for (int i = 0; i < kNum; i++)
+	{
+		LEVELDB_CHECK(Contains(cache, i) == (i % 2 == 1));
+	}
+	LEVELDB_CHECK(cache->GetUsage() == kNum / 2);
+	delete cache;
+}
+
+int main(int argc, char** argv)
+{
+	TestHighPriorityPool();
+	TestStrictCapacityLimit();
+	TestOwnerUsage();
+	TestResize();
+	fprintf(stderr, "PASS\n");
+	return 0;
+}
@@ -34,6 +34,11 @@ namespace leveldb{
 	extern void EncodeFixed32(char* dst, uint32_t value);
 	extern void EncodeFixed64(char* dst, uint64_t value);
 
+	//Lower-level versions of Put...that write directly into a character buffer
+	//and return a pointer just past the last byte written.
+	//REQUIRES: dst has enough space for the value being written
+	extern char* EncodeVarint32(char* dst, uint32_t value);
+
 	inline uint32_t DecodeFixed32(const char* ptr){
 		if (port::kLittleEndian)
 		{
@@ -0,0 +1,54 @@
+#include <string.h>
+#include "util/arena.h"
+#include "util/dynamic_bloom.h"
+#include "util/hash.h"
+
+namespace leveldb{
+
+	DynamicBloom::DynamicBloom(Arena* arena, size_t total_bits, int num_probes)
+		:num_probes_(num_probes > 0 ? num_probes : 1)
+	{
+		size_t blocks = (total_bits + kBitsPerBlock - 1) / kBitsPerBlock;
+		num_blocks_ = static_cast<uint32_t>(blocks > 0 ? blocks : 1);
+		const size_t bytes = static_cast<size_t>(num_blocks_) * (kBitsPerBlock / 8);
+		data_ = reinterpret_cast<unsigned char*>(arena->AllocateAligned(bytes));
+		memset(data_, 0, bytes);
+	}
+
+	uint32_t DynamicBloom::BloomHash(const Slice& key)
+	{
+		return Hash(key.data(), key.size(), 0xbc9f1d34);
+	}
+
+	void DynamicBloom::Add(const Slice& key)
+	{
+		uint32_t h = BloomHash(key);
+		unsigned char* block = data_ + BlockIndex(h) * (kBitsPerBlock / 8);
+		//Use double-hashing to generate a sequence of hash values within the block.
+		const uint32_t delta = (h >> 17) | (h << 15);	//Rotate right 17 bits
+		for (int i = 0; i < num_probes_; i++)
+		{
+			const uint32_t bitpos = h % kBitsPerBlock;
+			block[bitpos / 8] |= (1 << (bitpos % 8));
+			h += delta;
+		}
+	}
+
+	bool DynamicBloom::MayContain(const Slice& key) const
+	{
+		uint32_t h = BloomHash(key);
+		const unsigned char* block = data_ + BlockIndex(h) * (kBitsPerBlock / 8);
+		const uint32_t delta = (h >> 17) | (h << 15);	//Rotate right 17 bits
+		for (int i = 0; i < num_probes_; i++)
+		{
+			const uint32_t bitpos = h % kBitsPerBlock;
+			if ((block[bitpos / 8] & (1 << (bitpos % 8))) == 0)
+			{
+				return false;
+			}
+			h += delta;
+		}
+		return true;
+	}
+
+}
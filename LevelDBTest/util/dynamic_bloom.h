@@ -0,0 +1,50 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "leveldb/slice.h"
+
+namespace leveldb{
+
+	class Arena;
+
+	//A bloom filter over a fixed number of bits, filled in as keys are
+	//added rather than built from a known set of keys like a table's
+	//filter. All probes for a key fall into one cache line, so a lookup
+	//costs a single cache miss.
+	//
+	//Add() requires external synchronization, but MayContain() may be
+	//called concurrently with it: a reader racing with Add(key) may miss
+	//"key", never any key added before.
+	class DynamicBloom
+	{
+	public:
+		//Allocate about "total_bits" bits, rounded up to whole cache lines,
+		//from *arena, which must outlive the filter.
+		DynamicBloom(Arena* arena, size_t total_bits, int num_probes = 6);
+
+		void Add(const Slice& key);
+
+		//Returns false if "key" was certainly never added.
+		bool MayContain(const Slice& key) const;
+
+	private:
+		enum { kBitsPerBlock = 512 };	//One 64 byte cache line
+
+		static uint32_t BloomHash(const Slice& key);
+
+		//Pick a block from the high bits of "h"; the probes within the
+		//block use its low bits.
+		size_t BlockIndex(uint32_t h) const {
+			return static_cast<size_t>((static_cast<uint64_t>(h) * num_blocks_) >> 32);
+		}
+
+		const int num_probes_;
+		uint32_t num_blocks_;
+		unsigned char* data_;
+
+		//No copying allowed
+		DynamicBloom(const DynamicBloom&);
+		void operator=(const DynamicBloom&);
+	};
+
+}
@@ -5,6 +5,11 @@ namespace leveldb{
 
 	}
 
+	Status Env::LinkFile(const std::string& src, const std::string& target)
+	{
+		return Status::NotSupported("LinkFile", src);
+	}
+
 	SequentialFile::~SequentialFile()
 	{
 
@@ -36,7 +41,7 @@ namespace leveldb{
 	extern Status WriteStringToFile(Env* env, const Slice& data, const std::string& fname)
 	{
 		WritableFile* file;
-		Status s = env->NewWritableFile(fname &file);
+		Status s = env->NewWritableFile(fname, &file);
 		if (!s.ok())
 		{
 			return s;
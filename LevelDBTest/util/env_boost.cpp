@@ -391,6 +391,20 @@ namespace leveldb{
 				return result;
 			}
 
+			virtual Status LinkFile(const std::string& src, const std::string& target) {
+				boost::system::error_code ec;
+
+				boost::filesystem::create_hard_link(src, target, ec);
+
+				Status result;
+
+				if (ec) {
+					result = Status::IOError(src, ec.message());
+				}
+
+				return result;
+			}
+
 			virtual Status LockFile(const std::string& fname, FileLock** lock) {
 				*lock = NULL;
 
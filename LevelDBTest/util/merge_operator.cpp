@@ -0,0 +1,18 @@
+#include "leveldb/merge_operator.h"
+
+namespace leveldb{
+
+	MergeOperator::~MergeOperator()
+	{
+
+	}
+
+	bool MergeOperator::PartialMerge(const Slice& key,
+		const Slice& left_operand,
+		const Slice& right_operand,
+		std::string* new_value) const
+	{
+		return false;
+	}
+
+}
@@ -6,17 +6,33 @@ namespace leveldb{
 
 	Options::Options()
 		:comparator(BytewiseComparator()),
+		merge_operator(NULL),
 		create_if_missing(false),
 		error_if_exists(false),
 		paranoid_checks(false),
 		env(Env::Default()),
 		info_log(NULL),
 		write_buffer_size(4<<20),
+		max_write_buffer_number(2),
+		min_write_buffer_number_to_merge(1),
+		prefix_extractor(NULL),
+		memtable_bloom_size_ratio(0),
+		inplace_update_support(false),
+		inplace_update_num_locks(10000),
+		memtable_factory(NULL),
 		max_open_files(1000),
 		block_cache(NULL),
+		cache_index_and_filter_blocks(false),
+		block_cache_owner(0),
 		block_size(4096),
 		block_restart_interval(16),
-		compression(kSnappyCompression)
+		compression(kSnappyCompression),
+		table_build_threads(0),
+		table_open_threads(0),
+		max_successive_merges(0),
+		max_manifest_file_size(64<<20),
+		read_compaction_bytes_per_miss(16<<10),
+		read_compaction_min_misses(100)
 	{
 
 	}
@@ -0,0 +1,61 @@
+#include "leveldb/pinnable_slice.h"
+
+namespace leveldb{
+
+	PinnableSlice::PinnableSlice()
+		:buf_(&self_space_),
+		function_(NULL),
+		arg1_(NULL),
+		arg2_(NULL)
+	{
+
+	}
+
+	PinnableSlice::PinnableSlice(std::string* buf)
+		:buf_(buf),
+		function_(NULL),
+		arg1_(NULL),
+		arg2_(NULL)
+	{
+
+	}
+
+	PinnableSlice::~PinnableSlice()
+	{
+		Reset();
+	}
+
+	void PinnableSlice::PinSlice(const Slice& s, CleanupFunction function, void* arg1, void* arg2)
+	{
+		assert(!IsPinned());
+		assert(function != NULL);
+		Slice::operator=(s);
+		function_ = function;
+		arg1_ = arg1;
+		arg2_ = arg2;
+	}
+
+	void PinnableSlice::PinSelf(const Slice& s)
+	{
+		assert(!IsPinned());
+		buf_->assign(s.data(), s.size());
+		Slice::operator=(*buf_);
+	}
+
+	void PinnableSlice::PinSelf()
+	{
+		assert(!IsPinned());
+		Slice::operator=(*buf_);
+	}
+
+	void PinnableSlice::Reset()
+	{
+		if (function_ != NULL)
+		{
+			(*function_)(arg1_, arg2_);
+			function_ = NULL;
+		}
+		clear();
+	}
+
+}
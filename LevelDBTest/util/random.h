@@ -9,7 +9,7 @@ namespace leveldb{
 	public:
 		explicit Random(uint32_t s) :seed_(s & 0x7fffffffu){ }
 		uint32_t Next(){
-			static const uint32_t M = 214748347L; //2^31-1
+			static const uint32_t M = 2147483647L; //2^31-1
 			static const uint64_t A = 16807; //bits 14, 8, 7,5 ,2 , 1, 0
 			//We are computing
 			//		seed_=(seed_ * A)% M, where M = 2^31-1
@@ -0,0 +1,35 @@
+#include "util/rate_limiter.h"
+
+#include <assert.h>
+#include "leveldb/env.h"
+#include "util/mutexlock.h"
+
+namespace leveldb{
+
+	RateLimiter::RateLimiter(Env* env, uint64_t bytes_per_second)
+		:env_(env),
+		bytes_per_second_(bytes_per_second),
+		next_free_micros_(0)
+	{
+		assert(bytes_per_second > 0);
+	}
+
+	void RateLimiter::Request(uint64_t bytes)
+	{
+		uint64_t wait_micros = 0;
+		{
+			MutexLock l(&mu_);
+			const uint64_t now = env_->NowMicros();
+			if (next_free_micros_ < now)
+			{
+				next_free_micros_ = now;
+			}
+			wait_micros = next_free_micros_ - now;
+			next_free_micros_ += bytes * 1000000 / bytes_per_second_;
+		}
+		if (wait_micros > 0)
+		{
+			env_->SleepForMicroseconds(static_cast<int>(wait_micros));
+		}
+	}
+}
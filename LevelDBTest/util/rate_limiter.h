@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+#include "port/port.h"
+
+namespace leveldb{
+
+	class Env;
+
+	//Throttles the threads that share it to a total of "bytes_per_second".
+	//Each Request() reserves its bytes on a clock that advances by the time
+	//they take at that rate, and sleeps until the reservation starts, so
+	//callers are paced rather than released in bursts. Idle time is not
+	//banked for later.
+	class RateLimiter{
+	public:
+		RateLimiter(Env* env, uint64_t bytes_per_second);
+
+		//Block until "bytes" more may be transferred.
+		void Request(uint64_t bytes);
+
+	private:
+		Env* const env_;
+		const uint64_t bytes_per_second_;
+		port::Mutex mu_;
+		uint64_t next_free_micros_;	//Protected by mu_
+
+		//No copying allowed
+		RateLimiter(const RateLimiter&);
+		void operator=(const RateLimiter&);
+	};
+}
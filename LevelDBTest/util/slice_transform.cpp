@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <string>
+#include "leveldb/slice_transform.h"
+#include "port/port.h"
+
+namespace leveldb{
+
+	SliceTransform::~SliceTransform()
+	{
+
+	}
+
+	namespace{
+
+		class FixedPrefixTransform :public SliceTransform{
+		public:
+			explicit FixedPrefixTransform(size_t prefix_len)
+				:prefix_len_(prefix_len)
+			{
+				char buf[64];
+				snprintf(buf, sizeof(buf), "leveldb.FixedPrefix.%d", static_cast<int>(prefix_len));
+				name_ = buf;
+			}
+
+			virtual const char* Name() const { return name_.c_str(); }
+
+			virtual Slice Transform(const Slice& key) const {
+				assert(InDomain(key));
+				return Slice(key.data(), prefix_len_);
+			}
+
+			virtual bool InDomain(const Slice& key) const {
+				return key.size() >= prefix_len_;
+			}
+
+		private:
+			const size_t prefix_len_;
+			std::string name_;
+		};
+
+		class NoopTransform :public SliceTransform{
+		public:
+			virtual const char* Name() const { return "leveldb.Noop"; }
+			virtual Slice Transform(const Slice& key) const { return key; }
+			virtual bool InDomain(const Slice& key) const { return true; }
+		};
+
+	}
+
+	const SliceTransform* NewFixedPrefixTransform(size_t prefix_len)
+	{
+		return new FixedPrefixTransform(prefix_len);
+	}
+
+	const SliceTransform* NewNoopTransform()
+	{
+		return new NoopTransform();
+	}
+
+}
@@ -0,0 +1,248 @@
+#include "util/thread_local.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#include <assert.h>
+#include "port/port.h"
+#include "util/mutexlock.h"
+
+namespace leveldb{
+
+	namespace {
+		//The slots of one thread, indexed by ThreadLocalPtr id. Only the
+		//owning thread reads and writes its slots without holding
+		//meta_mutex; other threads touch them only in Scrape() and
+		//~ThreadLocalPtr(), under the mutex.
+		struct ThreadData
+		{
+			std::vector<port::AtomicPointer> entries;
+			ThreadData* prev;
+			ThreadData* next;
+		};
+
+		//State of one ThreadLocalPtr id
+		struct PtrInfo
+		{
+			ThreadLocalPtr::UnrefHandler handler;
+			int exiting;	//Values of exiting threads being handed to handler
+		};
+
+		//Guards the fields below and the growth of every thread's entries.
+		port::Mutex meta_mutex;
+		port::CondVar exit_cv(&meta_mutex);	//Signalled as handler calls finish
+		ThreadData* thread_list = NULL;	//Every live thread that used a pointer
+		std::vector<PtrInfo> ptr_infos;	//Indexed by id
+		std::vector<uint32_t> free_ids;	//Ids of destroyed pointers, for reuse
+		bool exit_hook_registered = false;
+#ifdef WIN32
+		DWORD exit_hook;	//FLS index whose callback runs on thread exit
+#else
+		pthread_key_t exit_hook;	//Key whose destructor runs on thread exit
+#endif
+
+		LEVELDB_THREAD_LOCAL ThreadData* thread_data = NULL;
+
+		//A value an exiting thread left for the handler of pointer "id"
+		struct ExitValue
+		{
+			uint32_t id;
+			ThreadLocalPtr::UnrefHandler handler;
+			void* value;
+		};
+
+		//Unlink the slots of an exiting thread and hand its values to the
+		//handlers of their pointers. Runs on the exiting thread.
+		void OnThreadExit(void* ptr)
+		{
+			ThreadData* t = reinterpret_cast<ThreadData*>(ptr);
+			std::vector<ExitValue> values;
+			{
+				MutexLock l(&meta_mutex);
+				if (t->prev != NULL)
+				{
+					t->prev->next = t->next;
+				}
+				else
+				{
+					thread_list = t->next;
+				}
+				if (t->next != NULL)
+				{
+					t->next->prev = t->prev;
+				}
+				for (uint32_t id = 0; id < t->entries.size(); id++)
+				{
+					void* value = t->entries[id].NoBarrier_Load();
+					if (value != NULL && ptr_infos[id].handler != NULL)
+					{
+						ExitValue v = { id, ptr_infos[id].handler, value };
+						values.push_back(v);
+						ptr_infos[id].exiting++;
+					}
+				}
+			}
+
+			//The handlers may take locks that are held around Scrape(), so
+			//they run without meta_mutex. ~ThreadLocalPtr() waits for them.
+			for (size_t i = 0; i < values.size(); i++)
+			{
+				values[i].handler(values[i].value);
+			}
+
+			if (!values.empty())
+			{
+				MutexLock l(&meta_mutex);
+				for (size_t i = 0; i < values.size(); i++)
+				{
+					ptr_infos[values[i].id].exiting--;
+				}
+				exit_cv.SignalAll();
+			}
+			delete t;
+			thread_data = NULL;
+		}
+
+#ifdef WIN32
+		void WINAPI OnFlsExit(void* ptr)
+		{
+			OnThreadExit(ptr);
+		}
+#endif
+
+		ThreadData* GetThreadData()
+		{
+			if (thread_data == NULL)
+			{
+				ThreadData* t = new ThreadData;
+				t->prev = NULL;
+				MutexLock l(&meta_mutex);
+				if (!exit_hook_registered)
+				{
+#ifdef WIN32
+					exit_hook = FlsAlloc(OnFlsExit);
+					assert(exit_hook != FLS_OUT_OF_INDEXES);
+#else
+					const int r = pthread_key_create(&exit_hook, OnThreadExit);
+					assert(r == 0);
+					(void)r;
+#endif
+					exit_hook_registered = true;
+				}
+#ifdef WIN32
+				FlsSetValue(exit_hook, t);
+#else
+				pthread_setspecific(exit_hook, t);
+#endif
+				t->next = thread_list;
+				if (thread_list != NULL)
+				{
+					thread_list->prev = t;
+				}
+				thread_list = t;
+				thread_data = t;
+			}
+			return thread_data;
+		}
+
+		//Return the calling thread's slot for "id", growing its slots if needed.
+		port::AtomicPointer* GetEntry(uint32_t id)
+		{
+			ThreadData* t = GetThreadData();
+			if (id >= t->entries.size())
+			{
+				//Scrape() may be walking the slots of this thread.
+				MutexLock l(&meta_mutex);
+				t->entries.resize(id + 1);
+			}
+			return &t->entries[id];
+		}
+	}
+
+	static uint32_t AllocateId(ThreadLocalPtr::UnrefHandler handler)
+	{
+		MutexLock l(&meta_mutex);
+		uint32_t id;
+		if (free_ids.empty())
+		{
+			id = static_cast<uint32_t>(ptr_infos.size());
+			ptr_infos.resize(id + 1);
+		}
+		else
+		{
+			id = free_ids.back();
+			free_ids.pop_back();
+		}
+		ptr_infos[id].handler = handler;
+		ptr_infos[id].exiting = 0;
+		return id;
+	}
+
+	ThreadLocalPtr::ThreadLocalPtr(UnrefHandler handler)
+		:id_(AllocateId(handler))
+	{
+
+	}
+
+	ThreadLocalPtr::~ThreadLocalPtr()
+	{
+		MutexLock l(&meta_mutex);
+		while (ptr_infos[id_].exiting > 0)
+		{
+			exit_cv.Wait();
+		}
+		for (ThreadData* t = thread_list; t != NULL; t = t->next)
+		{
+			if (id_ < t->entries.size())
+			{
+				t->entries[id_].NoBarrier_Store(NULL);
+			}
+		}
+		ptr_infos[id_].handler = NULL;
+		free_ids.push_back(id_);
+	}
+
+	void* ThreadLocalPtr::Get() const
+	{
+		ThreadData* t = GetThreadData();
+		if (id_ >= t->entries.size())
+		{
+			return NULL;
+		}
+		return t->entries[id_].Acquire_Load();
+	}
+
+	void ThreadLocalPtr::Reset(void* ptr)
+	{
+		GetEntry(id_)->Release_Store(ptr);
+	}
+
+	void* ThreadLocalPtr::Swap(void* ptr)
+	{
+		return GetEntry(id_)->Swap(ptr);
+	}
+
+	bool ThreadLocalPtr::CompareAndSwap(void* ptr, void** expected)
+	{
+		return GetEntry(id_)->CompareAndSwap(ptr, expected);
+	}
+
+	void ThreadLocalPtr::Scrape(std::vector<void*>* ptrs, void* replacement)
+	{
+		MutexLock l(&meta_mutex);
+		for (ThreadData* t = thread_list; t != NULL; t = t->next)
+		{
+			if (id_ < t->entries.size())
+			{
+				void* ptr = t->entries[id_].Swap(replacement);
+				if (ptr != NULL)
+				{
+					ptrs->push_back(ptr);
+				}
+			}
+		}
+	}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace leveldb{
+
+	//A pointer with a separate value in every thread, so a thread can keep
+	//per-object state, such as a cached reference, without locking. Any
+	//thread may Scrape() the values of all threads, which is how an owner
+	//takes back the state others cached when it goes stale.
+	//
+	//When a thread exits, its slots are freed and each of its non-NULL
+	//values is passed to the UnrefHandler of its pointer, on the exiting
+	//thread.
+	class ThreadLocalPtr
+	{
+	public:
+		//Releases "ptr", the value an exiting thread left in its slot.
+		typedef void(*UnrefHandler)(void* ptr);
+
+		//"handler" may be NULL if values need no release. Relies on a
+		//global mutex, so it may not be constructed during static
+		//initialization.
+		explicit ThreadLocalPtr(UnrefHandler handler = NULL);
+
+		//Drops the values of all threads without returning them. Scrape()
+		//first if they hold references. Waits for the handler calls of
+		//threads exiting concurrently.
+		~ThreadLocalPtr();
+
+		//Return the calling thread's value, NULL if it never stored one.
+		void* Get() const;
+
+		//Set the calling thread's value to "ptr".
+		void Reset(void* ptr);
+
+		//Set the calling thread's value to "ptr" and return the old one.
+		void* Swap(void* ptr);
+
+		//If the calling thread's value equals *expected, set it to "ptr"
+		//and return true. Otherwise store the value in *expected and
+		//return false. Fails only if another thread scraped the value
+		//since the calling thread last stored it.
+		bool CompareAndSwap(void* ptr, void** expected);
+
+		//Replace the value of every thread with "replacement" and append
+		//the old values that were non-NULL to *ptrs.
+		void Scrape(std::vector<void*>* ptrs, void* replacement);
+
+	private:
+		const uint32_t id_;	//Index of this pointer in each thread's slots
+
+		//No copying allowed
+		ThreadLocalPtr(const ThreadLocalPtr&);
+		void operator=(const ThreadLocalPtr&);
+	};
+
+}
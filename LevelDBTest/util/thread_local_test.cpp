@@ -0,0 +1,99 @@
+//Checks that the values a thread leaves in ThreadLocalPtr slots are
+//handed to the pointer's UnrefHandler when the thread exits, and that
+//Scrape() no longer walks the slots of exited threads. Built as its own
+//console program.
+#include <stdio.h>
+#include <vector>
+#include "db/testutil.h"
+#include "leveldb/env.h"
+#include "port/port.h"
+#include "util/mutexlock.h"
+#include "util/thread_local.h"
+
+using namespace leveldb;
+
+static const int kNumThreads = 20;
+
+static port::Mutex mu;
+static int released = 0;	//Protected by mu
+static int value_sum = 0;	//Protected by mu
+
+static void Unref(void* ptr)
+{
+	MutexLock l(&mu);
+	released++;
+	value_sum += *reinterpret_cast<int*>(ptr);
+}
+
+struct ThreadArg
+{
+	ThreadLocalPtr* with_handler;
+	ThreadLocalPtr* without_handler;
+	int* value;
+};
+
+static void StoreAndExit(void* arg)
+{
+	ThreadArg* a = reinterpret_cast<ThreadArg*>(arg);
+	a->without_handler->Reset(a->value);
+	a->with_handler->Reset(a->value);
+}
+
+int main(int argc, char** argv)
+{
+	Env* env = Env::Default();
+	ThreadLocalPtr* with_handler = new ThreadLocalPtr(&Unref);
+	ThreadLocalPtr* without_handler = new ThreadLocalPtr;
+
+	int values[kNumThreads];
+	ThreadArg args[kNumThreads];
+	int expected_sum = 0;
+	for (int i = 0; i < kNumThreads; i++)
+	{
+		values[i] = i + 1;
+		expected_sum += values[i];
+		args[i].with_handler = with_handler;
+		args[i].without_handler = without_handler;
+		args[i].value = &values[i];
+		env->StartThread(&StoreAndExit, &args[i]);
+	}
+
+	//Threads run detached; wait for all of them to exit.
+	for (int waited = 0; ; waited++)
+	{
+		{
+			MutexLock l(&mu);
+			if (released == kNumThreads)
+			{
+				break;
+			}
+		}
+		LEVELDB_CHECK(waited < 10000);
+		env->SleepForMicroseconds(1000);
+	}
+	{
+		MutexLock l(&mu);
+		LEVELDB_CHECK(value_sum == expected_sum);
+	}
+
+	//The exited threads were unlinked: only live values remain.
+	std::vector<void*> ptrs;
+	with_handler->Scrape(&ptrs, NULL);
+	without_handler->Scrape(&ptrs, NULL);
+	LEVELDB_CHECK(ptrs.empty());
+
+	int mine = 0;
+	with_handler->Reset(&mine);
+	with_handler->Scrape(&ptrs, NULL);
+	LEVELDB_CHECK(ptrs.size() == 1 && ptrs[0] == &mine);
+	LEVELDB_CHECK(with_handler->Get() == NULL);
+
+	delete with_handler;
+	delete without_handler;
+	{
+		MutexLock l(&mu);
+		LEVELDB_CHECK(released == kNumThreads);
+	}
+	fprintf(stderr, "PASS\n");
+	return 0;
+}